@@ -0,0 +1,1542 @@
+#include "benchmarks.h"
+#include "heightfield.h"
+#include "heightfield_simd.h"
+#include "heightmap_file.h"
+#include "mesh_optimizer.h"
+#include "mip_filter.h"
+#include "occlusion_buffer.h"
+#include "terrain_clipmap.h"
+#include "terrain_culling.h"
+#include "terrain_deform.h"
+#include "terrain_height_query.h"
+#include "terrain_indices.h"
+#include "terrain_lod.h"
+#include "terrain_mesh_cache.h"
+#include "terrain_noise.h"
+#include "terrain_normals.h"
+#include "terrain_raycast.h"
+#include "terrain_splat.h"
+#include "texture_compression.h"
+#include "texture_file.h"
+#include "texture_synthesis.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int argInt(int argc, char **argv, int index, int fallback)
+    {
+        return index < argc ? std::atoi(argv[index]) : fallback;
+    }
+
+    // Serial vs parallel heightfield generation: cells/sec against thread count
+    int benchTerrain(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 4096);
+        size_t cells = (size_t)size * size;
+
+        std::vector<float> reference(cells);
+        auto start = std::chrono::steady_clock::now();
+        generateHeightfieldSerial(reference.data(), size, size, generateSineHeightRowFast);
+        double serialTime = secondsSince(start);
+
+        std::cout << "terrain " << size << "x" << size << std::endl;
+        std::cout << "  serial      " << cells / serialTime / 1e6 << " Mcells/s" << std::endl;
+
+        unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<float> heights(cells);
+        bool allMatch = true;
+
+        // Powers of two, then every core once
+        for (unsigned int threads = 1;; threads = std::min(threads * 2, maxThreads))
+        {
+            ThreadPool pool(threads);
+            start = std::chrono::steady_clock::now();
+            generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, pool);
+            double time = secondsSince(start);
+
+            bool match = std::memcmp(heights.data(), reference.data(), cells * sizeof(float)) == 0;
+            allMatch = allMatch && match;
+
+            std::cout << "  threads " << threads << "   " << cells / time / 1e6 << " Mcells/s"
+                      << "  speedup " << serialTime / time << "x"
+                      << (match ? "" : "  MISMATCH") << std::endl;
+
+            if (threads == maxThreads)
+                break;
+        }
+
+        return allMatch ? 0 : 1;
+    }
+
+    // Polynomial batch kernel against the libm reference: max error and speedup per SIMD level
+    int benchNoise(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2048);
+        size_t cells = (size_t)size * size;
+
+        // Error of the sin/cos approximations themselves over the documented range
+        double maxTrigError = 0.0;
+        for (int i = -1000000; i <= 1000000; i++)
+        {
+            float x = i * (8192.0f / 1000000.0f);
+            maxTrigError = std::max(maxTrigError, std::fabs(fastSin(x) - std::sin((double)x)));
+            maxTrigError = std::max(maxTrigError, std::fabs(fastCos(x) - std::cos((double)x)));
+        }
+        std::cout << "fastSin/fastCos max abs error on [-8192, 8192]: " << maxTrigError << std::endl;
+
+        std::vector<float> reference(cells);
+        auto start = std::chrono::steady_clock::now();
+        generateHeightfieldSerial(reference.data(), size, size, generateSineHeightRow);
+        double referenceTime = secondsSince(start);
+        std::cout << "heights " << size << "x" << size << std::endl;
+        std::cout << "  libm     " << cells / referenceTime / 1e6 << " Mcells/s" << std::endl;
+
+        std::vector<float> heights(cells);
+        std::vector<float> firstLevel;
+        bool identical = true;
+
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2})
+        {
+            if (level > detectSimdLevel())
+                break;
+
+            start = std::chrono::steady_clock::now();
+            for (int z = 0; z < size; z++)
+                generateSineHeightRowSimd(0, z, size, heights.data() + (size_t)z * size, level);
+            double time = secondsSince(start);
+
+            double maxError = 0.0;
+            for (size_t i = 0; i < cells; i++)
+                maxError = std::max(maxError, (double)std::fabs(heights[i] - reference[i]));
+
+            if (firstLevel.empty())
+                firstLevel = heights;
+            else
+                identical = identical && std::memcmp(firstLevel.data(), heights.data(), cells * sizeof(float)) == 0;
+
+            std::cout << "  " << simdLevelName(level) << (level == SimdLevel::Scalar ? "   " : "     ")
+                      << cells / time / 1e6 << " Mcells/s  speedup " << referenceTime / time
+                      << "x  max error " << maxError << std::endl;
+        }
+
+        std::cout << "  SIMD levels bit-identical: " << (identical ? "yes" : "NO") << std::endl;
+        return identical ? 0 : 1;
+    }
+
+    // CDLOD selection cost and triangle budget as the map grows (camera in the middle of the map)
+    int benchLod(int argc, char **argv)
+    {
+        int maxSize = argInt(argc, argv, 3, 4097);
+
+        std::cout << "size      levels  nodes  triangles  full-res triangles  select (ms)" << std::endl;
+        for (int size = 257; size <= maxSize; size = (size - 1) * 2 + 1)
+        {
+            std::vector<float> heights((size_t)size * size);
+            generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, ThreadPool::shared());
+
+            TerrainQuadtree quadtree;
+            quadtree.build(heights.data(), size, size, TerrainLodSettings());
+
+            glm::vec3 camera(size * 0.5f, 20.0f, size * 0.5f);
+            glm::mat4 view = glm::lookAt(camera, camera + glm::vec3(0.0f, -0.3f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            glm::mat4 projection = glm::perspective(glm::radians(60.0f), 800.0f / 600.0f, 0.1f, 2000.0f);
+            Frustum frustum = Frustum::fromMatrix(projection * view);
+
+            std::vector<TerrainLodNode> selection;
+            TerrainLodStats stats;
+            const int iterations = 1000;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+                quadtree.select(camera, &frustum, selection, &stats);
+            double time = secondsSince(start) / iterations;
+
+            size_t fullTriangles = (size_t)(size - 1) * (size - 1) * 2;
+            std::cout << size << (size < 1000 ? "       " : "      ") << quadtree.getLevelCount() << "       "
+                      << stats.nodesSelected << "     " << stats.triangles << "      " << fullTriangles
+                      << "          " << time * 1000.0 << std::endl;
+        }
+        return 0;
+    }
+
+    // Validates the 16-bit restart strips against the triangle list and compares index memory
+    int benchStrips(int, char **)
+    {
+        bool allMatch = true;
+
+        std::cout << "chunk   list indices  list bytes  strip indices  strip bytes  ratio" << std::endl;
+        for (int chunkSize : {8, 16, 32, 64, 128, MaxStripGridSamples - 1})
+        {
+            int samples = chunkSize + 1;
+            std::vector<unsigned int> list;
+            std::vector<uint16_t> strip;
+            buildGridTriangleList(samples, samples, list);
+            buildGridTriangleStrip(samples, samples, strip);
+
+            bool match = stripMatchesTriangleList(strip, list);
+            allMatch = allMatch && match;
+
+            size_t listBytes = list.size() * sizeof(unsigned int);
+            size_t stripBytes = strip.size() * sizeof(uint16_t);
+            std::cout << chunkSize << (chunkSize < 100 ? (chunkSize < 10 ? "       " : "      ") : "     ")
+                      << list.size() << "        " << listBytes << "      " << strip.size() << "         "
+                      << stripBytes << "       " << (double)listBytes / stripBytes << "x"
+                      << (match ? "" : "  MISMATCH") << std::endl;
+        }
+
+        std::cout << "Strips cover the same triangles as the list: " << (allMatch ? "yes" : "NO") << std::endl;
+        return allMatch ? 0 : 1;
+    }
+
+    // Vertex cache reordering of a terrain grid: ACMR/ATVR from the FIFO simulator and reorder time
+    int benchMeshopt(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 1025);
+        size_t vertexCount = (size_t)size * size;
+
+        std::vector<unsigned int> rowMajor;
+        buildGridTriangleList(size, size, rowMajor);
+        VertexCacheStats before = analyzeVertexCache(rowMajor.data(), rowMajor.size(), vertexCount);
+
+        std::vector<unsigned int> whole(rowMajor.size());
+        auto start = std::chrono::steady_clock::now();
+        optimizeVertexCache(whole.data(), rowMajor.data(), rowMajor.size());
+        double wholeTime = secondsSince(start);
+        VertexCacheStats wholeStats = analyzeVertexCache(whole.data(), whole.size(), vertexCount);
+
+        // Same culling chunks Terrain::optimizeIndices reorders one by one
+        std::vector<unsigned int> chunked;
+        std::vector<TerrainCullChunk> chunks;
+        buildChunkedTriangleList(size, size, TerrainCullChunkSize, chunked, chunks);
+        start = std::chrono::steady_clock::now();
+        ThreadPool::shared().parallelFor(0, (int)chunks.size(), 1, [&](int first, int last)
+                                         {
+            for (int c = first; c < last; c++)
+            {
+                unsigned int *chunkIndices = &chunked[chunks[c].firstIndex];
+                optimizeVertexCache(chunkIndices, chunkIndices, chunks[c].indexCount);
+            } });
+        double chunkedTime = secondsSince(start);
+        VertexCacheStats chunkedStats = analyzeVertexCache(chunked.data(), chunked.size(), vertexCount);
+
+        std::cout << "grid " << size << "x" << size << " (" << rowMajor.size() / 3 << " triangles, FIFO "
+                  << DefaultVertexCacheSize << ")" << std::endl;
+        std::cout << "  row-major        ACMR " << before.acmr << "  ATVR " << before.atvr << std::endl;
+        std::cout << "  forsyth          ACMR " << wholeStats.acmr << "  ATVR " << wholeStats.atvr << "  "
+                  << wholeTime * 1000.0 << " ms" << std::endl;
+        std::cout << "  forsyth chunked  ACMR " << chunkedStats.acmr << "  ATVR " << chunkedStats.atvr << "  "
+                  << chunkedTime * 1000.0 << " ms on " << ThreadPool::shared().threadCount() << " thread(s)" << std::endl;
+        return 0;
+    }
+
+    // Heightfield normals: SIMD levels and threads, plus a dirty-rect update checked against a full rebuild
+    int benchNormals(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 4096);
+        size_t cells = (size_t)size * size;
+
+        std::vector<float> heights(cells);
+        generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, ThreadPool::shared());
+
+        std::vector<float> reference(cells * 3);
+        std::vector<float> normals(cells * 3);
+        bool identical = true;
+
+        std::cout << "normals " << size << "x" << size << std::endl;
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2})
+        {
+            if (level > detectSimdLevel())
+                break;
+
+            std::vector<float> &out = level == SimdLevel::Scalar ? reference : normals;
+            auto start = std::chrono::steady_clock::now();
+            for (int z = 1; z < size - 1; z++)
+            {
+                const float *center = heights.data() + (size_t)z * size;
+                computeNormalRow(center - size + 1, center + 1, center + size + 1, size - 2,
+                                 out.data() + ((size_t)z * size + 1) * 3, 3, level);
+            }
+            double time = secondsSince(start);
+
+            bool match = level == SimdLevel::Scalar || normals == reference;
+            identical = identical && match;
+            std::cout << "  " << simdLevelName(level) << (level == SimdLevel::Scalar ? "   " : "     ")
+                      << cells / time / 1e6 << " Mnormals/s" << (match ? "" : "  MISMATCH") << std::endl;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        computeNormals(heights.data(), size, size, reference.data(), 3, &ThreadPool::shared());
+        double time = secondsSince(start);
+        std::cout << "  " << ThreadPool::shared().threadCount() << " thread(s)  " << cells / time / 1e6
+                  << " Mnormals/s (including edges)" << std::endl;
+
+        // Raise a bump, patch the normals around it and compare against recomputing everything
+        int bump = std::min(32, size / 3);
+        int x0 = size / 3, z0 = size / 2, x1 = x0 + bump, z1 = z0 + bump;
+        for (int z = z0; z < z1; z++)
+            for (int x = x0; x < x1; x++)
+                heights[(size_t)z * size + x] += 1.5f;
+
+        normals = reference;
+        start = std::chrono::steady_clock::now();
+        updateNormalsForDirtyRect(heights.data(), size, size, x0, z0, x1, z1, normals.data(), 3);
+        double dirtyTime = secondsSince(start);
+
+        computeNormals(heights.data(), size, size, reference.data(), 3, &ThreadPool::shared());
+        bool dirtyMatch = normals == reference;
+        std::cout << "  " << bump << "x" << bump << " dirty rect  " << dirtyTime * 1e6 << " us" << (dirtyMatch ? "" : "  MISMATCH") << std::endl;
+
+        std::cout << "  SIMD levels bit-identical: " << (identical ? "yes" : "NO")
+                  << ", dirty update matches full rebuild: " << (dirtyMatch ? "yes" : "NO") << std::endl;
+        return identical && dirtyMatch ? 0 : 1;
+    }
+
+    // Startup cost of a baked heightmap: procedural generation vs mapping the Float32 file vs
+    // decoding the Quantized16 file, plus the cost of touching it with height lookups
+    int benchHeightmap(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 4096);
+        size_t cells = (size_t)size * size;
+        ThreadPool &pool = ThreadPool::shared();
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path();
+        std::string rawPath = (directory / "racing_bench_heightmap.rhmp").string();
+        std::string quantizedPath = (directory / "racing_bench_heightmap_q16.rhmp").string();
+
+        std::cout << "heightmap " << size << "x" << size << " (" << cells * sizeof(float) / (1024.0 * 1024.0)
+                  << " MB as floats, " << pool.threadCount() << " thread(s))" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        if (!writeHeightmapFile(rawPath.c_str(), generateSineHeightRowFast, size, size, HeightmapEncoding::Float32, 256, &pool) ||
+            !writeHeightmapFile(quantizedPath.c_str(), generateSineHeightRowFast, size, size, HeightmapEncoding::Quantized16, 256, &pool))
+            return 1;
+        std::cout << "  convert (both files)   " << secondsSince(start) * 1000.0 << " ms" << std::endl;
+
+        double generateTime;
+        {
+            start = std::chrono::steady_clock::now();
+            std::vector<float> heights(cells);
+            generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, pool);
+            generateTime = secondsSince(start);
+        }
+        std::cout << "  generate procedurally  " << generateTime * 1000.0 << " ms" << std::endl;
+
+        // The files are mapped inside the lambda, so they are unmapped again before being removed
+        auto measure = [&]()
+        {
+            HeightmapFile raw;
+            start = std::chrono::steady_clock::now();
+            if (!raw.open(rawPath.c_str(), &pool))
+                return false;
+            double mapTime = secondsSince(start);
+
+            // A million scattered lookups fault in the pages they hit, like a first frame would
+            const int lookups = 1000000;
+            uint32_t state = 12345;
+            float sum = 0.0f;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < lookups; i++)
+            {
+                state = state * 1664525u + 1013904223u;
+                sum += raw.heights()[state % cells];
+            }
+            double lookupTime = secondsSince(start);
+            std::cout << "  map Float32            " << mapTime * 1000.0 << " ms (zero-copy: " << (raw.isZeroCopy() ? "yes" : "no")
+                      << "), 1M cold lookups " << lookupTime * 1000.0 << " ms" << std::endl;
+
+            HeightmapFile quantized;
+            start = std::chrono::steady_clock::now();
+            if (!quantized.open(quantizedPath.c_str(), &pool))
+                return false;
+            double decodeTime = secondsSince(start);
+
+            float maxError = 0.0f;
+            for (size_t i = 0; i < cells; i++)
+                maxError = std::max(maxError, std::fabs(quantized.heights()[i] - raw.heights()[i]));
+            std::cout << "  decode Quantized16     " << decodeTime * 1000.0 << " ms, max error " << maxError
+                      << " (file " << std::filesystem::file_size(quantizedPath) * 100 / std::filesystem::file_size(rawPath)
+                      << "% of Float32)" << std::endl;
+            std::cout << "  startup speedup (map vs generate): " << generateTime / mapTime << "x  [checksum " << sum << "]" << std::endl;
+            return true;
+        };
+
+        bool ok = measure();
+        std::filesystem::remove(rawPath);
+        std::filesystem::remove(quantizedPath);
+        return ok ? 0 : 1;
+    }
+
+    // Cold start (generate heights, vertices, normals, indices) against mapping the mesh cache
+    int benchMeshCache(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2048);
+        size_t cells = (size_t)size * size;
+        ThreadPool &pool = ThreadPool::shared();
+        std::string path = (std::filesystem::temp_directory_path() / "racing_bench_mesh.rtmc").string();
+        uint64_t key = terrainMeshCacheKey(nullptr, size, size);
+
+        std::cout << "mesh cache " << size << "x" << size << " (" << pool.threadCount() << " thread(s))" << std::endl;
+
+        // Same work as Terrain::generateMesh, minus the vertex cache reordering
+        auto start = std::chrono::steady_clock::now();
+        std::vector<float> heights(cells);
+        generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, pool);
+        std::vector<float> vertices(cells * 8);
+        for (int z = 0; z < size; z++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                float *vertex = &vertices[((size_t)z * size + x) * 8];
+                vertex[0] = (float)x;
+                vertex[1] = heights[(size_t)z * size + x];
+                vertex[2] = (float)z;
+                vertex[6] = x * 0.1f;
+                vertex[7] = z * 0.1f;
+            }
+        }
+        computeNormals(heights.data(), size, size, vertices.data() + 3, 8, &pool);
+        std::vector<unsigned int> indices;
+        buildGridTriangleList(size, size, indices);
+        double coldTime = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        if (!writeTerrainMeshCache(path, key, size, size, heights.data(), vertices.data(), 8, indices.data(), indices.size()))
+            return 1;
+        double writeTime = secondsSince(start);
+
+        auto measure = [&]()
+        {
+            TerrainMeshCache cache;
+            start = std::chrono::steady_clock::now();
+            if (!cache.open(path, key, 8))
+                return false;
+            double mapTime = secondsSince(start);
+
+            // Reading every byte faults the pages in, as the glBufferData copy does
+            start = std::chrono::steady_clock::now();
+            bool identical = std::memcmp(cache.vertices(), vertices.data(), vertices.size() * sizeof(float)) == 0 &&
+                             std::memcmp(cache.indices(), indices.data(), indices.size() * sizeof(unsigned int)) == 0 &&
+                             std::memcmp(cache.heights(), heights.data(), cells * sizeof(float)) == 0;
+            double readTime = secondsSince(start);
+
+            size_t bytes = std::filesystem::file_size(path);
+            std::cout << "  cold: generate         " << coldTime * 1000.0 << " ms\n"
+                      << "  write cache            " << writeTime * 1000.0 << " ms (" << bytes / (1024.0 * 1024.0) << " MB)\n"
+                      << "  warm: map              " << mapTime * 1000.0 << " ms, read through " << readTime * 1000.0 << " ms\n"
+                      << "  contents identical: " << (identical ? "yes" : "NO") << ", warm speedup "
+                      << coldTime / (mapTime + readTime) << "x" << std::endl;
+            return identical;
+        };
+
+        bool ok = measure();
+        std::filesystem::remove(path);
+        return ok ? 0 : 1;
+    }
+
+    // Batched SoA height queries per SIMD level against one getHeight-style call per point
+    int benchHeightQuery(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2048);
+        std::vector<float> heights((size_t)size * size);
+        generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, ThreadPool::shared());
+
+        // Clustered points (wheels and particles near a few cars) and points scattered over the map,
+        // both with some off the map and a NaN to exercise the outside handling
+        const size_t count = 1 << 16;
+        const int repeats = 50;
+        uint32_t state = 12345;
+        auto random = [&]()
+        {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        };
+
+        bool allIdentical = true;
+        for (bool clustered : {true, false})
+        {
+            std::vector<float> x(count), z(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                float spread = clustered ? 8.0f : size * 1.1f;
+                float cx = clustered ? (float)((i / 64) % 16) * size / 16.0f : -size * 0.05f;
+                float cz = clustered ? (float)((i / 64) % 16) * size / 16.0f : -size * 0.05f;
+                x[i] = cx + random() * spread;
+                z[i] = cz + random() * spread;
+            }
+            x[7] = std::nanf("");
+
+            std::vector<float> reference(count), referenceX(count), referenceZ(count);
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++)
+                for (size_t i = 0; i < count; i++)
+                    reference[i] = sampleHeight(heights.data(), size, size, x[i], z[i]);
+            double pointTime = secondsSince(start);
+            sampleHeights(heights.data(), size, size, x.data(), z.data(), count, reference.data(), referenceX.data(),
+                          referenceZ.data(), SimdLevel::Scalar);
+
+            size_t outside = 0;
+            for (size_t i = 0; i < count; i++)
+                outside += reference[i] == 0.0f && referenceX[i] == 0.0f && referenceZ[i] == 0.0f;
+
+            std::cout << (clustered ? "clustered" : "scattered") << " queries (" << count << " points, " << outside
+                      << " off the map)" << std::endl;
+            std::cout << "  per point        " << count * repeats / pointTime / 1e6 << " Mqueries/s" << std::endl;
+
+            std::vector<float> out(count), gradientX(count), gradientZ(count);
+            for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2})
+            {
+                if (level > detectSimdLevel())
+                    break;
+
+                start = std::chrono::steady_clock::now();
+                for (int r = 0; r < repeats; r++)
+                    sampleHeights(heights.data(), size, size, x.data(), z.data(), count, out.data(), nullptr, nullptr,
+                                  level);
+                double heightTime = secondsSince(start);
+
+                start = std::chrono::steady_clock::now();
+                for (int r = 0; r < repeats; r++)
+                    sampleHeights(heights.data(), size, size, x.data(), z.data(), count, out.data(), gradientX.data(),
+                                  gradientZ.data(), level);
+                double gradientTime = secondsSince(start);
+
+                bool identical = std::memcmp(out.data(), reference.data(), count * sizeof(float)) == 0 &&
+                                 std::memcmp(gradientX.data(), referenceX.data(), count * sizeof(float)) == 0 &&
+                                 std::memcmp(gradientZ.data(), referenceZ.data(), count * sizeof(float)) == 0;
+                allIdentical = allIdentical && identical;
+
+                std::cout << "  batch " << simdLevelName(level) << (level == SimdLevel::Scalar ? "   " : "     ")
+                          << count * repeats / heightTime / 1e6 << " Mqueries/s (speedup " << pointTime / heightTime
+                          << "x), with gradients " << count * repeats / gradientTime / 1e6 << " Mqueries/s"
+                          << (identical ? "" : "  MISMATCH") << std::endl;
+            }
+        }
+
+        std::cout << "  all paths bit-identical to per-point: " << (allIdentical ? "yes" : "NO") << std::endl;
+        return allIdentical ? 0 : 1;
+    }
+
+    // Ray casts against the min/max pyramid (single rays, packets, threads) vs marching getHeight
+    int benchRaycast(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2048);
+        ThreadPool &pool = ThreadPool::shared();
+        std::vector<float> heights((size_t)size * size);
+        generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, pool);
+
+        auto start = std::chrono::steady_clock::now();
+        TerrainHeightPyramid pyramid;
+        pyramid.build(heights.data(), size, size, &pool);
+        std::cout << "raycast " << size << "x" << size << ": pyramid of " << pyramid.getLevelCount() << " levels built in "
+                  << secondsSince(start) * 1000.0 << " ms" << std::endl;
+
+        // Fixed-step march through the bilinear height with bisection at the first downward crossing
+        const float marchStep = 0.25f;
+        auto march = [&](const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, float &distance)
+        {
+            bool above = false;
+            float previous = 0.0f;
+            for (float t = 0.0f; t <= maxDistance; t += marchStep)
+            {
+                glm::vec3 p = origin + direction * t;
+                bool onMap = p.x >= 0.0f && p.x < size - 1 && p.z >= 0.0f && p.z < size - 1;
+                bool nowAbove = !onMap || p.y > sampleHeight(heights.data(), size, size, p.x, p.z);
+                if (onMap && above && !nowAbove)
+                {
+                    float lo = previous, hi = t;
+                    for (int k = 0; k < 20; k++)
+                    {
+                        float mid = 0.5f * (lo + hi);
+                        glm::vec3 m = origin + direction * mid;
+                        (m.y > sampleHeight(heights.data(), size, size, m.x, m.z) ? lo : hi) = mid;
+                    }
+                    distance = hi;
+                    return true;
+                }
+                above = nowAbove && onMap;
+                previous = t;
+            }
+            return false;
+        };
+
+        uint32_t state = 12345;
+        auto random = [&]()
+        {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        };
+
+        // Picking: fans of 16 rays looking down from 30 units up. Line of sight: near-horizontal
+        // rays from 2 units above the ground, 16 to a bundle from the same spot.
+        const int rayCount = 1 << 14;
+        bool allValid = true;
+        for (bool picking : {true, false})
+        {
+            std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+            for (int i = 0; i < rayCount; i += TerrainHeightPyramid::PacketSize)
+            {
+                glm::vec3 origin(random() * (size - 1), 0.0f, random() * (size - 1));
+                origin.y = sampleHeight(heights.data(), size, size, origin.x, origin.z) + (picking ? 30.0f : 2.0f);
+                float heading = random() * 6.2831853f;
+                for (int r = 0; r < TerrainHeightPyramid::PacketSize && i + r < rayCount; r++)
+                {
+                    float angle = heading + (r - 8) * 0.02f;
+                    float pitch = picking ? -0.6f - r * 0.02f : -0.05f + r * 0.005f;
+                    origins[i + r] = origin;
+                    directions[i + r] = glm::normalize(glm::vec3(std::cos(angle), pitch, std::sin(angle)));
+                }
+            }
+            float maxDistance = picking ? 200.0f : 300.0f;
+
+            std::vector<TerrainRayHit> single(rayCount), packet(rayCount), threaded(rayCount);
+            TerrainRaycastStats stats;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < rayCount; i++)
+                pyramid.raycast(origins[i], directions[i], maxDistance, single[i], &stats);
+            double singleTime = secondsSince(start);
+
+            TerrainRaycastStats packetStats;
+            start = std::chrono::steady_clock::now();
+            pyramid.raycastPacket(origins.data(), directions.data(), rayCount, maxDistance, packet.data(), &packetStats);
+            double packetTime = secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            pool.parallelFor(0, rayCount / TerrainHeightPyramid::PacketSize, 4, [&](int first, int last)
+            {
+                int begin = first * TerrainHeightPyramid::PacketSize, end = last * TerrainHeightPyramid::PacketSize;
+                pyramid.raycastPacket(&origins[begin], &directions[begin], end - begin, maxDistance, &threaded[begin]);
+            });
+            double threadedTime = secondsSince(start);
+
+            // Marching is slow, so only a slice of the rays is marched and checked against
+            const int marchCount = rayCount / 8;
+            int marchHits = 0, pyramidMisses = 0, pyramidLater = 0, offSurface = 0, packetMismatches = 0;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < marchCount; i++)
+            {
+                float distance;
+                if (!march(origins[i], directions[i], maxDistance, distance))
+                    continue;
+                marchHits++;
+                if (!single[i].hit)
+                    pyramidMisses++;
+                else if (single[i].distance > distance + 1e-3f)
+                    pyramidLater++;
+            }
+            double marchTime = secondsSince(start);
+
+            int hits = 0;
+            for (int i = 0; i < rayCount; i++)
+            {
+                if (single[i].hit != packet[i].hit || single[i].distance != packet[i].distance ||
+                    single[i].hit != threaded[i].hit || single[i].distance != threaded[i].distance)
+                    packetMismatches++;
+                if (!single[i].hit)
+                    continue;
+                hits++;
+                const glm::vec3 &p = single[i].position;
+                if (std::fabs(p.y - sampleHeight(heights.data(), size, size, p.x, p.z)) > 1e-3f * (1.0f + std::fabs(p.y)))
+                    offSurface++;
+            }
+
+            bool valid = pyramidMisses == 0 && pyramidLater == 0 && offSurface == 0 && packetMismatches == 0;
+            allValid = allValid && valid;
+
+            std::cout << (picking ? "picking fans" : "line of sight") << " (" << rayCount << " rays, " << hits << " hits)\n"
+                      << "  march " << marchStep << " step   " << marchCount / marchTime / 1e6 << " Mrays/s\n"
+                      << "  pyramid single   " << rayCount / singleTime / 1e6 << " Mrays/s ("
+                      << (double)stats.nodesVisited / rayCount << " nodes, " << (double)stats.cellsTested / rayCount
+                      << " cells per ray), speedup " << (rayCount / singleTime) / (marchCount / marchTime) << "x\n"
+                      << "  pyramid packets  " << rayCount / packetTime / 1e6 << " Mrays/s ("
+                      << (double)packetStats.nodesVisited / rayCount << " node visits per ray)\n"
+                      << "  packets x " << pool.threadCount() << " threads " << rayCount / threadedTime / 1e6 << " Mrays/s\n"
+                      << "  check: " << marchHits << " march hits, " << pyramidMisses << " missed, " << pyramidLater
+                      << " later than march, " << offSurface << " off the surface, " << packetMismatches
+                      << " packet mismatches" << std::endl;
+        }
+        return allValid ? 0 : 1;
+    }
+
+    // Per-chunk frustum culling of the fixed mesh: chunks and triangles kept, and the CPU cost
+    int benchCull(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2049);
+        std::vector<float> heights((size_t)size * size);
+        generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, ThreadPool::shared());
+
+        std::vector<unsigned int> indices;
+        std::vector<TerrainCullChunk> chunks;
+        buildChunkedTriangleList(size, size, TerrainCullChunkSize, indices, chunks);
+        updateChunkBounds(heights.data(), size, 0, 0, size, size, chunks, &ThreadPool::shared());
+
+        // Same projection as the game, looking around from a few spots on the map
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+        std::vector<int> counts;
+        std::vector<const void *> offsets;
+        TerrainCullStats stats;
+        size_t totalTriangles = indices.size() / 3;
+
+        std::cout << "cull " << size << "x" << size << ": " << chunks.size() << " chunks of " << TerrainCullChunkSize
+                  << " cells, " << totalTriangles << " triangles" << std::endl;
+        for (float fraction : {0.1f, 0.5f, 0.9f})
+        {
+            for (float heading : {0.0f, 90.0f, 225.0f})
+            {
+                glm::vec3 camera(size * fraction, 0.0f, size * fraction);
+                camera.y = sampleHeight(heights.data(), size, size, camera.x, camera.z) + 5.0f;
+                glm::vec3 forward(std::cos(glm::radians(heading)), -0.2f, std::sin(glm::radians(heading)));
+                glm::mat4 view = glm::lookAt(camera, camera + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+                Frustum frustum = Frustum::fromMatrix(projection * view);
+
+                const int iterations = 1000;
+                auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations; i++)
+                    cullTerrainChunks(chunks, frustum, sizeof(unsigned int), counts, offsets, stats);
+                double time = secondsSince(start) / iterations;
+
+                std::cout << "  camera (" << (int)camera.x << ", " << (int)camera.z << ") heading " << heading << ": "
+                          << stats.chunksVisible << " visible, " << stats.chunksCulled << " culled, " << stats.drawRanges
+                          << " draw range(s), " << stats.triangles * 100.0 / totalTriangles << "% of triangles, "
+                          << time * 1e6 << " us" << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    // CPU occlusion culling behind hilly terrain: raster cost per SIMD level and thread count,
+    // chunks hidden beyond the frustum test, and a ray cast check that nothing hidden was visible
+    int benchOcclusion(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2049);
+        NoiseSettings hills;
+        hills.frequency = 0.004f;
+        hills.amplitude = 40.0f;
+        std::vector<float> heights((size_t)size * size);
+        generateHeightfield(heights.data(), size, size, TerrainNoise(hills).rowFunction(), ThreadPool::shared());
+
+        TerrainHeightPyramid pyramid;
+        pyramid.build(heights.data(), size, size, &ThreadPool::shared());
+        std::vector<TerrainCullChunk> chunks;
+        layoutTerrainChunks(size, size, TerrainCullChunkSize, chunks);
+        updateChunkBounds(heights.data(), size, 0, 0, size, size, chunks, &ThreadPool::shared());
+
+        std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+        if (detectSimdLevel() >= SimdLevel::SSE2)
+            levels.push_back(SimdLevel::SSE2);
+        if (detectSimdLevel() >= SimdLevel::AVX2)
+            levels.push_back(SimdLevel::AVX2);
+        const char *levelNames[] = {"scalar", "sse2", "avx2"};
+
+        uint32_t state = 777;
+        auto random = [&]()
+        {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        };
+
+        std::cout << "occlusion " << size << "x" << size << ": " << chunks.size() << " chunks of "
+                  << TerrainCullChunkSize << " cells" << std::endl;
+
+        // The game's view distance, and a long one where far hills hide most of the map
+        OcclusionBuffer buffer;
+        std::vector<glm::vec3> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<int> counts;
+        std::vector<const void *> offsets;
+        bool allValid = true;
+        for (float farPlane : {100.0f, 1000.0f})
+        {
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, farPlane);
+            const int views = 32;
+            double rasterTime[3] = {}, threadedTime = 0.0, setupTime = 0.0;
+            size_t occluderTriangles = 0, frustumChunks = 0, hiddenChunks = 0, cars = 0, hiddenCars = 0;
+            int depthMismatches = 0, samplesChecked = 0, violations = 0;
+
+            for (int v = 0; v < views; v++)
+            {
+                // Low camera a couple of units over the ground, looking roughly level
+                glm::vec3 camera(size * (0.2f + 0.6f * random()), 0.0f, size * (0.2f + 0.6f * random()));
+                camera.y = sampleHeight(heights.data(), size, size, camera.x, camera.z) + 2.0f;
+                float heading = random() * 6.2831853f;
+                glm::vec3 forward(std::cos(heading), -0.05f, std::sin(heading));
+                glm::mat4 viewProjection = projection * glm::lookAt(camera, camera + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+                Frustum frustum = Frustum::fromMatrix(viewProjection);
+
+                auto start = std::chrono::steady_clock::now();
+                vertices.clear();
+                indices.clear();
+                appendTerrainOccluders(pyramid, 2, frustum, vertices, indices);
+                buffer.begin(viewProjection);
+                buffer.addOccluders(vertices.data(), indices.data(), indices.size() / 3);
+                setupTime += secondsSince(start);
+                occluderTriangles += buffer.getTrianglesRasterized();
+
+                std::vector<float> reference;
+                for (SimdLevel level : levels)
+                {
+                    OcclusionBuffer copy = buffer;
+                    start = std::chrono::steady_clock::now();
+                    copy.rasterize(nullptr, level);
+                    rasterTime[(int)level] += secondsSince(start);
+
+                    const float *depth = copy.depth();
+                    size_t pixels = (size_t)copy.getWidth() * copy.getHeight();
+                    if (reference.empty())
+                        reference.assign(depth, depth + pixels);
+                    else if (std::memcmp(reference.data(), depth, pixels * sizeof(float)) != 0)
+                        depthMismatches++;
+                }
+                start = std::chrono::steady_clock::now();
+                buffer.rasterize(&ThreadPool::shared());
+                threadedTime += secondsSince(start);
+                if (std::memcmp(reference.data(), buffer.depth(), reference.size() * sizeof(float)) != 0)
+                    depthMismatches++;
+
+                TerrainCullStats frustumOnly, occluded;
+                cullTerrainChunks(chunks, frustum, sizeof(unsigned int), counts, offsets, frustumOnly);
+                cullTerrainChunks(chunks, frustum, sizeof(unsigned int), counts, offsets, occluded, &buffer);
+                frustumChunks += frustumOnly.chunksVisible;
+                hiddenChunks += occluded.chunksOccluded;
+
+                // Every sample of a hidden chunk that lies in the frustum must have terrain in front
+                // of it along the ray from the camera
+                auto checkPoint = [&](const glm::vec3 &point)
+                {
+                    glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+                    if (std::fabs(clip.x) > clip.w || std::fabs(clip.y) > clip.w || clip.z < -clip.w || clip.z > clip.w)
+                        return;
+                    samplesChecked++;
+                    glm::vec3 toPoint = point - camera;
+                    float distance = glm::length(toPoint);
+                    TerrainRayHit hit;
+                    if (!pyramid.raycast(camera, toPoint / distance, distance, hit) || hit.distance > distance - 0.05f)
+                        violations++;
+                };
+                for (const TerrainCullChunk &chunk : chunks)
+                {
+                    if (!frustum.intersectsAABB(chunk.boxMin, chunk.boxMax) || buffer.isVisible(chunk.boxMin, chunk.boxMax))
+                        continue;
+                    for (int z = chunk.z0; z <= chunk.z1; z += 8)
+                        for (int x = chunk.x0; x <= chunk.x1; x += 8)
+                            checkPoint(glm::vec3((float)x, heights[(size_t)z * size + x] + 0.1f, (float)z));
+                }
+
+                // Car-sized boxes resting on the ground at random spots in front of the camera
+                for (int c = 0; c < 64; c++)
+                {
+                    float angle = heading + (random() - 0.5f) * 0.8f, range = 5.0f + random() * (farPlane - 5.0f);
+                    glm::vec3 centre = camera + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * range;
+                    if (centre.x < 2.0f || centre.z < 2.0f || centre.x > size - 3.0f || centre.z > size - 3.0f)
+                        continue;
+                    centre.y = sampleHeight(heights.data(), size, size, centre.x, centre.z) + 0.5f;
+                    glm::vec3 reach(2.3f);
+                    if (!frustum.intersectsAABB(centre - reach, centre + reach))
+                        continue;
+                    cars++;
+                    if (buffer.isVisible(centre - reach, centre + reach))
+                        continue;
+                    hiddenCars++;
+                    checkPoint(centre + glm::vec3(0.0f, 0.5f, 0.0f));
+                }
+            }
+
+            bool valid = depthMismatches == 0 && violations == 0;
+            allValid = allValid && valid;
+            std::cout << "  far " << farPlane << ": " << occluderTriangles / views << " occluder triangles per view ("
+                      << buffer.getWidth() << "x" << buffer.getHeight() << "), setup " << setupTime / views * 1e6
+                      << " us\n";
+            for (SimdLevel level : levels)
+                std::cout << "    raster " << levelNames[(int)level] << "   " << rasterTime[(int)level] / views * 1e6
+                          << " us\n";
+            std::cout << "    raster x " << ThreadPool::shared().threadCount() << " threads " << threadedTime / views * 1e6
+                      << " us\n"
+                      << "    chunks in frustum " << frustumChunks << ", occluded " << hiddenChunks << " ("
+                      << (frustumChunks ? hiddenChunks * 100.0 / frustumChunks : 0.0) << "%); cars " << cars
+                      << ", occluded " << hiddenCars << "\n"
+                      << "    check: " << depthMismatches << " depth buffer mismatches, " << violations << "/"
+                      << samplesChecked << " hidden samples visible by ray cast" << std::endl;
+        }
+        return allValid ? 0 : 1;
+    }
+
+    // Clipmap upload traffic for a camera flying over an endless noise world at several speeds,
+    // with every level checked against the source along the way
+    int benchClipmap(int argc, char **argv)
+    {
+        TerrainClipmapSettings requested;
+        requested.levels = argInt(argc, argv, 3, requested.levels);
+        TerrainNoise noise;
+        HeightRowFunction source = noise.rowFunction();
+        HeightStridedRowFunction stridedSource = noise.stridedRowFunction();
+
+        // The clipmap clamps the level count; everything below uses what it settled on
+        TerrainClipmapSettings settings = TerrainClipmap(source, requested).getSettings();
+        int size = settings.gridSize + 1;
+        size_t fullBytes = (size_t)size * size * settings.levels * sizeof(float);
+        size_t reach = (size_t)settings.gridSize << (settings.levels - 1);
+        std::cout << "clipmap: " << settings.levels << " levels of " << settings.gridSize << " quads, " << reach
+                  << " cells across; full texture " << fullBytes << " bytes, static mesh that size "
+                  << (reach + 1) * (reach + 1) * 8 * sizeof(float) << " bytes" << std::endl;
+
+        bool allValid = true;
+        std::vector<float> expected(size);
+        for (float speed : {0.1f, 0.5f, 2.0f, 8.0f})
+        {
+            // Gentle curve so both axes move, in both directions
+            auto path = [&](int frame)
+            {
+                float angle = frame * 0.01f;
+                return glm::vec3(std::sin(angle) * 40.0f + frame * speed, 5.0f,
+                                 std::cos(angle * 0.7f) * 60.0f - frame * speed * 0.5f);
+            };
+
+            TerrainClipmap clipmap(source, settings, stridedSource);
+            clipmap.update(path(0));
+
+            const int frames = 600;
+            size_t totalBytes = 0, maxBytes = 0;
+            int movedFrames = 0, mismatches = 0, badHoles = 0;
+            double updateTime = 0.0;
+            for (int frame = 1; frame <= frames; frame++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                clipmap.update(path(frame));
+                updateTime += secondsSince(start);
+
+                const TerrainClipmapStats &stats = clipmap.getStats();
+                totalBytes += stats.uploadBytes;
+                maxBytes = std::max(maxBytes, stats.uploadBytes);
+                movedFrames += stats.uploadBytes > 0;
+
+                for (int level = 1; level < clipmap.getLevelCount(); level++)
+                {
+                    glm::ivec2 hole = clipmap.getHoleOffset(level) - glm::ivec2(settings.gridSize / 4);
+                    if (hole.x < 0 || hole.x > 1 || hole.y < 0 || hole.y > 1)
+                        badHoles++;
+                }
+
+                // Every texel must hold the source height of the sample it wraps to. Checking
+                // all of them is slow, so only every 15th frame is checked.
+                for (int level = 0; level < clipmap.getLevelCount() && frame % 15 == 0; level++)
+                {
+                    glm::ivec2 origin = clipmap.getOrigin(level);
+                    const float *heights = clipmap.getHeights(level);
+                    for (int z = origin.y; z < origin.y + size; z++)
+                    {
+                        stridedSource(origin.x * (1 << level), z * (1 << level), 1 << level, size, expected.data());
+                        const float *row = heights + (size_t)(((z % size) + size) % size) * size;
+                        for (int x = origin.x; x < origin.x + size; x++)
+                        {
+                            if (row[((x % size) + size) % size] != expected[x - origin.x])
+                                mismatches++;
+                        }
+                    }
+                }
+            }
+
+            bool valid = mismatches == 0 && badHoles == 0;
+            allValid = allValid && valid;
+            std::cout << "  " << speed << " cells/frame: " << totalBytes / frames << " bytes/frame average, "
+                      << maxBytes << " max (" << 100.0 * maxBytes / fullBytes << "% of full), moved on " << movedFrames
+                      << "/" << frames << " frames, update " << updateTime / frames * 1e6 << " us; check: "
+                      << mismatches << " texel mismatches, " << badHoles << " misplaced holes" << std::endl;
+        }
+        return allValid ? 0 : 1;
+    }
+
+    // Splat map baking: throughput against thread count, and how far the filtered baked weights
+    // drift from evaluating the blend per fragment
+    int benchSplat(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2048);
+        size_t samples = (size_t)size * size;
+        std::vector<float> heights(samples), normals(samples * 3);
+        generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, ThreadPool::shared());
+        computeNormals(heights.data(), size, size, normals.data(), 3, &ThreadPool::shared());
+
+        std::vector<uint8_t> reference(samples * 4);
+        auto start = std::chrono::steady_clock::now();
+        bakeSplatMap(heights.data(), normals.data(), 3, size, size, reference.data());
+        double serialTime = secondsSince(start);
+
+        std::cout << "splat " << size << "x" << size << " (" << reference.size() << " bytes RGBA8)" << std::endl;
+        std::cout << "  serial      " << samples / serialTime / 1e6 << " Msamples/s" << std::endl;
+
+        unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<uint8_t> splat(samples * 4);
+        bool allMatch = true;
+        for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            ThreadPool pool(threads);
+            start = std::chrono::steady_clock::now();
+            bakeSplatMap(heights.data(), normals.data(), 3, size, size, splat.data(), &pool);
+            double time = secondsSince(start);
+            bool match = splat == reference;
+            allMatch = allMatch && match;
+            std::cout << "  " << threads << " thread(s) " << samples / time / 1e6 << " Msamples/s, speedup "
+                      << serialTime / time << "x" << (match ? "" : " MISMATCH") << std::endl;
+        }
+
+        int badSums = 0;
+        for (size_t i = 0; i < samples; i++)
+        {
+            const uint8_t *texel = &reference[i * 4];
+            if (texel[0] + texel[1] + texel[2] + texel[3] != 255)
+                badSums++;
+        }
+
+        // Fragments at random points: the procedural shader blends from the interpolated height
+        // and normal, the baked one filters the weights of the four samples around it
+        uint32_t state = 4242;
+        auto random = [&]()
+        {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        };
+        const int fragments = 1 << 20;
+        double totalError = 0.0;
+        float maxError = 0.0f;
+        for (int i = 0; i < fragments; i++)
+        {
+            float x = random() * (size - 1), z = random() * (size - 1);
+            int x0 = std::min((int)x, size - 2), z0 = std::min((int)z, size - 2);
+            float fx = x - x0, fz = z - z0;
+            size_t corners[4] = {(size_t)z0 * size + x0, (size_t)z0 * size + x0 + 1, (size_t)(z0 + 1) * size + x0,
+                                 (size_t)(z0 + 1) * size + x0 + 1};
+            float cornerWeights[4] = {(1 - fx) * (1 - fz), fx * (1 - fz), (1 - fx) * fz, fx * fz};
+
+            float height = 0.0f;
+            glm::vec3 normal(0.0f);
+            glm::vec4 baked(0.0f);
+            for (int c = 0; c < 4; c++)
+            {
+                height += heights[corners[c]] * cornerWeights[c];
+                normal += glm::make_vec3(&normals[corners[c] * 3]) * cornerWeights[c];
+                const uint8_t *texel = &reference[corners[c] * 4];
+                baked += glm::vec4(texel[0], texel[1], texel[2], texel[3]) * (cornerWeights[c] / 255.0f);
+            }
+            glm::vec4 procedural = computeSplatWeights(height, 1.0f - glm::normalize(normal).y);
+
+            glm::vec4 difference = glm::abs(procedural - baked);
+            float error = std::max({difference.x, difference.y, difference.z, difference.w});
+            maxError = std::max(maxError, error);
+            totalError += error;
+        }
+
+        std::cout << "  weights vs per-fragment blend: mean error " << totalError / fragments << ", max " << maxError
+                  << "; " << badSums << " texels not summing to 255" << std::endl;
+        std::cout << "  fragment blend (hand-counted estimate, not measured): baked " << BakedSplatCost.aluOps
+                  << " ALU ops, " << BakedSplatCost.textureFetches << " fetches, " << BakedSplatCost.branches
+                  << " branches; procedural " << ProceduralSplatCost.aluOps << " ALU ops, "
+                  << ProceduralSplatCost.textureFetches << " fetches, " << ProceduralSplatCost.branches << " branches ("
+                  << 100 - 100 * BakedSplatCost.aluOps / ProceduralSplatCost.aluOps << "% fewer ALU ops)" << std::endl;
+        return allMatch && badSums == 0 ? 0 : 1;
+    }
+
+    // The original generator: rand() per channel and a strstr on the texture name per texel
+    void synthesizeWithRand(const char *name, int width, int height, uint8_t *data)
+    {
+        for (int i = 0; i < width * height; i++)
+        {
+            if (strstr(name, "grass"))
+            {
+                data[i * 3] = 34 + (rand() % 50);
+                data[i * 3 + 1] = 139 + (rand() % 50);
+                data[i * 3 + 2] = 34 + (rand() % 50);
+            }
+            else if (strstr(name, "rock"))
+            {
+                int gray = 100 + (rand() % 80);
+                data[i * 3] = data[i * 3 + 1] = data[i * 3 + 2] = gray;
+            }
+            else if (strstr(name, "sand"))
+            {
+                data[i * 3] = 194 + (rand() % 40);
+                data[i * 3 + 1] = 178 + (rand() % 40);
+                data[i * 3 + 2] = 128 + (rand() % 40);
+            }
+            else
+            {
+                data[i * 3] = 139 + (rand() % 40);
+                data[i * 3 + 1] = 69 + (rand() % 40);
+                data[i * 3 + 2] = 19 + (rand() % 40);
+            }
+        }
+    }
+
+    // Material texture synthesis: the rand() generator against the tiled one, serial and over
+    // thread counts, plus determinism and range checks
+    int benchTextureSynthesis(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 4096);
+        size_t bytes = (size_t)size * size * 3;
+        double megatexels = (double)size * size / 1e6;
+        const char *names[] = {"grass", "rock", "sand", "earth"};
+        const TerrainMaterial materials[] = {TerrainMaterial::Grass, TerrainMaterial::Rock, TerrainMaterial::Sand,
+                                             TerrainMaterial::Earth};
+
+        std::cout << "texsynth " << size << "x" << size << " RGB8, 4 materials" << std::endl;
+
+        std::vector<uint8_t> texture(bytes);
+        auto start = std::chrono::steady_clock::now();
+        for (const char *name : names)
+            synthesizeWithRand(name, size, size, texture.data());
+        double randTime = secondsSince(start);
+        std::cout << "  rand()+strstr " << 4 * megatexels / randTime << " Mtexels/s" << std::endl;
+
+        std::vector<std::vector<uint8_t>> reference(4, std::vector<uint8_t>(bytes));
+        start = std::chrono::steady_clock::now();
+        for (int m = 0; m < 4; m++)
+            synthesizeMaterialTexture(materials[m], size, size, 1, reference[m].data());
+        double serialTime = secondsSince(start);
+        std::cout << "  tiled serial  " << 4 * megatexels / serialTime << " Mtexels/s, " << randTime / serialTime
+                  << "x rand()" << std::endl;
+
+        unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        bool allMatch = true;
+        for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            ThreadPool pool(threads);
+            bool match = true;
+            start = std::chrono::steady_clock::now();
+            for (int m = 0; m < 4; m++)
+            {
+                synthesizeMaterialTexture(materials[m], size, size, 1, texture.data(), &pool);
+                match = match && texture == reference[m];
+            }
+            double time = secondsSince(start);
+            allMatch = allMatch && match;
+            std::cout << "  " << threads << " thread(s) " << 4 * megatexels / time << " Mtexels/s, "
+                      << randTime / time << "x rand()" << (match ? "" : " MISMATCH") << std::endl;
+        }
+
+        // Every channel inside its pattern's range, grey materials grey, and the channel means
+        // near the middle of the range
+        int outOfRange = 0;
+        double worstMeanOffset = 0.0;
+        for (int m = 0; m < 4; m++)
+        {
+            const MaterialPattern &pattern = materialPattern(materials[m]);
+            double sums[3] = {0.0, 0.0, 0.0};
+            for (size_t i = 0; i < bytes; i += 3)
+            {
+                const uint8_t *texel = &reference[m][i];
+                for (int c = 0; c < 3; c++)
+                {
+                    if (texel[c] < pattern.base[c] || texel[c] >= pattern.base[c] + pattern.range[c])
+                        outOfRange++;
+                    sums[c] += texel[c];
+                }
+                if (pattern.grey && (texel[1] != texel[0] || texel[2] != texel[0]))
+                    outOfRange++;
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                double expected = pattern.base[c] + (pattern.range[c] - 1) * 0.5;
+                worstMeanOffset = std::max(worstMeanOffset, std::abs(sums[c] / ((double)size * size) - expected));
+            }
+        }
+
+        // A different seed should share only chance bytes with the first
+        synthesizeMaterialTexture(TerrainMaterial::Grass, size, size, 2, texture.data(), &ThreadPool::shared());
+        size_t sameBytes = 0;
+        for (size_t i = 0; i < bytes; i++)
+            sameBytes += texture[i] == reference[0][i];
+        double sameFraction = (double)sameBytes / bytes;
+
+        std::cout << "  check: " << outOfRange << " values out of range, worst channel mean offset "
+                  << worstMeanOffset << ", seed 2 vs seed 1 " << 100.0 * sameFraction << "% equal bytes"
+                  << std::endl;
+        return allMatch && outOfRange == 0 && sameFraction < 0.1 ? 0 : 1;
+    }
+
+    // Material texture array: the packed layers against each material synthesized on its own, and
+    // the per-frame texture state the array saves
+    int benchMaterials(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 1024);
+        size_t layerBytes = (size_t)size * size * 3;
+
+        std::vector<uint8_t> layers(layerBytes * TerrainMaterialCount);
+        auto start = std::chrono::steady_clock::now();
+        synthesizeMaterialLayers(size, size, 1, layers.data(), &ThreadPool::shared());
+        double packTime = secondsSince(start);
+
+        std::cout << "materials " << TerrainMaterialCount << " layers of " << size << "x" << size << " RGB8 ("
+                  << layers.size() << " bytes), packed in " << packTime * 1e3 << " ms" << std::endl;
+
+        size_t totalMismatches = 0;
+        for (int material = 0; material < TerrainMaterialCount; material++)
+        {
+            size_t mismatches = countLayerMismatches((TerrainMaterial)material, layers.data() + material * layerBytes,
+                                                     size, size, 1, &ThreadPool::shared());
+            totalMismatches += mismatches;
+            std::cout << "  layer " << material << ": " << mismatches << " bytes differ" << std::endl;
+        }
+
+        // A layer must not match its neighbour, or a swapped upload would go unnoticed
+        size_t swapped = countLayerMismatches(TerrainMaterial::Grass, layers.data() + layerBytes, size, size, 1);
+        std::cout << "  rock layer vs grass texture: " << swapped << " bytes differ (expected most)" << std::endl;
+
+        // Texture binds and sampler uniform calls per frame: one texture and sampler per material
+        // before, one array (samplers set once at startup) after; the splat map adds one bind
+        std::cout << "  per frame: separate textures " << TerrainMaterialCount + 1 << " binds + "
+                  << TerrainMaterialCount + 1 << " sampler uniforms, array 2 binds + 0 sampler uniforms" << std::endl;
+        return totalMismatches == 0 && swapped > layerBytes / 2 ? 0 : 1;
+    }
+
+    // Offline texture baking: CPU mip chains per filter and SIMD level (bit-identical across
+    // levels), then startup from the baked file against synthesizing the layers
+    int benchTextureBake(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2048);
+        std::string path = (std::filesystem::temp_directory_path() / "racing_bench_materials.rtex").string();
+
+        MipChain chain;
+        chain.width = chain.height = size;
+        chain.layers = TerrainMaterialCount;
+        chain.channels = 3;
+        chain.levels.resize(1);
+        chain.levels[0].resize(chain.levelLayerBytes(0) * chain.layers);
+
+        auto start = std::chrono::steady_clock::now();
+        synthesizeMaterialLayers(size, size, 1, chain.levels[0].data(), &ThreadPool::shared());
+        double synthesizeTime = secondsSince(start);
+
+        std::cout << "texbake " << TerrainMaterialCount << " layers of " << size << "x" << size << " RGB8, "
+                  << mipLevelCount(size, size) << " levels" << std::endl;
+
+        bool allMatch = true;
+        SimdLevel best = detectSimdLevel();
+        for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser})
+        {
+            MipChain reference;
+            for (int simd = 0; simd <= (int)best; simd++)
+            {
+                MipChain built = chain;
+                start = std::chrono::steady_clock::now();
+                buildMipChain(built, filter, nullptr, (SimdLevel)simd);
+                double time = secondsSince(start);
+
+                bool match = simd == 0 || built.levels == reference.levels;
+                allMatch = allMatch && match;
+                if (simd == 0)
+                    reference = std::move(built);
+                std::cout << "  " << mipFilterName(filter) << " " << simdLevelName((SimdLevel)simd) << ": " << time * 1e3
+                          << " ms serial" << (match ? "" : " MISMATCH") << std::endl;
+            }
+
+            start = std::chrono::steady_clock::now();
+            MipChain threaded = chain;
+            buildMipChain(threaded, filter, &ThreadPool::shared());
+            double time = secondsSince(start);
+            bool match = threaded.levels == reference.levels;
+            allMatch = allMatch && match;
+            std::cout << "  " << mipFilterName(filter) << " " << simdLevelName(best) << ": " << time * 1e3 << " ms on "
+                      << ThreadPool::shared().threadCount() << " thread(s)" << (match ? "" : " MISMATCH") << std::endl;
+        }
+
+        // The box filter is the rounded 2x2 average, and both kernels keep a flat image flat
+        int boxErrors = 0, flatErrors = 0;
+        {
+            std::vector<uint8_t> level((size_t)(size / 2) * (size / 2) * 3);
+            downsampleMip(chain.levels[0].data(), size, size, 3, MipFilter::Box, level.data(), &ThreadPool::shared());
+            const uint8_t *source = chain.levels[0].data();
+            for (int y = 0; y < size / 2; y++)
+            {
+                for (int x = 0; x < size / 2; x++)
+                {
+                    for (int c = 0; c < 3; c++)
+                    {
+                        auto texel = [&](int sx, int sy) { return source[((size_t)sy * size + sx) * 3 + c]; };
+                        int sum = texel(2 * x, 2 * y) + texel(2 * x + 1, 2 * y) + texel(2 * x, 2 * y + 1) +
+                                  texel(2 * x + 1, 2 * y + 1);
+                        boxErrors += level[((size_t)y * (size / 2) + x) * 3 + c] != (sum + 2) / 4;
+                    }
+                }
+            }
+
+            std::vector<uint8_t> flat((size_t)64 * 64 * 3, 173), flatLevel((size_t)32 * 32 * 3);
+            for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser})
+            {
+                downsampleMip(flat.data(), 64, 64, 3, filter, flatLevel.data());
+                for (uint8_t value : flatLevel)
+                    flatErrors += value != 173;
+            }
+        }
+
+        MipChain baked = chain;
+        buildMipChain(baked, MipFilter::Kaiser, &ThreadPool::shared());
+        if (!writeTextureFile(path.c_str(), baked, MipFilter::Kaiser))
+            return 1;
+
+        // The file is mapped inside the lambda, so it is unmapped again before being removed
+        auto measure = [&]()
+        {
+            TextureFile file;
+            start = std::chrono::steady_clock::now();
+            if (!file.open(path.c_str()))
+                return false;
+
+            // Reading every level stands in for the upload, which touches every page once
+            bool same = file.getLevelCount() == (int)baked.levels.size();
+            for (int level = 0; same && level < file.getLevelCount(); level++)
+                same = std::memcmp(file.levelData(level), baked.levels[level].data(), baked.levels[level].size()) == 0;
+            double loadTime = secondsSince(start);
+
+            std::cout << "  startup: synthesize level 0 " << synthesizeTime * 1e3
+                      << " ms (+ GPU mipmaps), baked file map + read " << loadTime * 1e3 << " ms ("
+                      << file.size() << " bytes, all levels)" << (same ? "" : " MISMATCH") << std::endl;
+            allMatch = allMatch && same;
+            return true;
+        };
+
+        bool ok = measure();
+        std::filesystem::remove(path);
+        std::cout << "  check: " << boxErrors << " box texels off the rounded average, " << flatErrors
+                  << " flat-image texels changed" << std::endl;
+        return ok && allMatch && boxErrors == 0 && flatErrors == 0 ? 0 : 1;
+    }
+
+    // BC1 encoding of the material layers: throughput per SIMD level and thread count (every
+    // path must produce the same blocks) and PSNR against the source texels
+    int benchBC1(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 2048);
+        size_t layerBytes = (size_t)size * size * 3, layerBlocks = bc1Size(size, size);
+        double megatexels = (double)size * size * TerrainMaterialCount / 1e6;
+
+        std::vector<uint8_t> layers(layerBytes * TerrainMaterialCount);
+        synthesizeMaterialLayers(size, size, 1, layers.data(), &ThreadPool::shared());
+
+        std::cout << "bc1 " << TerrainMaterialCount << " layers of " << size << "x" << size << ": "
+                  << layers.size() << " bytes RGB8 -> " << layerBlocks * TerrainMaterialCount << " bytes BC1"
+                  << std::endl;
+
+        auto encodeAll = [&](std::vector<uint8_t> &blocks, ThreadPool *pool, SimdLevel level)
+        {
+            blocks.resize(layerBlocks * TerrainMaterialCount);
+            auto start = std::chrono::steady_clock::now();
+            for (int layer = 0; layer < TerrainMaterialCount; layer++)
+                encodeBC1(layers.data() + layer * layerBytes, size, size, blocks.data() + layer * layerBlocks, pool,
+                          level);
+            return secondsSince(start);
+        };
+
+        std::vector<uint8_t> reference, blocks;
+        double scalarTime = encodeAll(reference, nullptr, SimdLevel::Scalar);
+        std::cout << "  scalar      " << megatexels / scalarTime << " Mtexels/s" << std::endl;
+
+        bool allMatch = true;
+        for (int simd = 1; simd <= (int)detectSimdLevel(); simd++)
+        {
+            double time = encodeAll(blocks, nullptr, (SimdLevel)simd);
+            bool match = blocks == reference;
+            allMatch = allMatch && match;
+            std::cout << "  " << simdLevelName((SimdLevel)simd) << "        " << megatexels / time << " Mtexels/s, "
+                      << scalarTime / time << "x scalar" << (match ? "" : " MISMATCH") << std::endl;
+        }
+
+        unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            ThreadPool pool(threads);
+            double time = encodeAll(blocks, &pool, detectSimdLevel());
+            bool match = blocks == reference;
+            allMatch = allMatch && match;
+            std::cout << "  " << threads << " thread(s) " << megatexels / time << " Mtexels/s, " << scalarTime / time
+                      << "x scalar" << (match ? "" : " MISMATCH") << std::endl;
+        }
+
+        // Quality per material; per-texel colour noise is close to the worst case for BC1
+        const char *names[] = {"grass", "rock", "sand", "earth"};
+        std::vector<uint8_t> decoded(layerBytes);
+        double worstPsnr = std::numeric_limits<double>::infinity();
+        std::cout << "  PSNR:";
+        for (int layer = 0; layer < TerrainMaterialCount; layer++)
+        {
+            decodeBC1(reference.data() + layer * layerBlocks, size, size, decoded.data());
+            double psnr = computePsnr(layers.data() + layer * layerBytes, decoded.data(), layerBytes);
+            worstPsnr = std::min(worstPsnr, psnr);
+            std::cout << " " << names[layer] << " " << psnr << " dB";
+        }
+        std::cout << std::endl;
+
+        // Smooth content is what BC1 is built for: a gradient should come back far cleaner than noise
+        std::vector<uint8_t> gradient(layerBytes), gradientBlocks(layerBlocks);
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                uint8_t *texel = &gradient[((size_t)y * size + x) * 3];
+                texel[0] = (uint8_t)(x * 255 / std::max(size - 1, 1));
+                texel[1] = (uint8_t)(y * 255 / std::max(size - 1, 1));
+                texel[2] = 96;
+            }
+        }
+        encodeBC1(gradient.data(), size, size, gradientBlocks.data(), &ThreadPool::shared());
+        decodeBC1(gradientBlocks.data(), size, size, decoded.data());
+        double gradientPsnr = computePsnr(gradient.data(), decoded.data(), layerBytes);
+        std::cout << "  gradient PSNR " << gradientPsnr << " dB" << std::endl;
+
+        // A BC1 texture file must hold exactly the blocks encoded here
+        std::string path = (std::filesystem::temp_directory_path() / "racing_bench_bc1.rtex").string();
+        MipChain chain;
+        chain.width = chain.height = size;
+        chain.layers = TerrainMaterialCount;
+        chain.levels.push_back(layers);
+        bool fileMatches = false;
+        if (writeTextureFile(path.c_str(), chain, MipFilter::Box, TextureCompression::BC1, &ThreadPool::shared()))
+        {
+            TextureFile file;
+            fileMatches = file.open(path.c_str()) && file.getCompression() == TextureCompression::BC1 &&
+                          file.getLevel(0).size == reference.size() &&
+                          std::memcmp(file.levelData(0), reference.data(), reference.size()) == 0;
+        }
+        std::filesystem::remove(path);
+        std::cout << "  BC1 texture file round trip: " << (fileMatches ? "blocks match" : "MISMATCH") << std::endl;
+
+        return allMatch && fileMatches && worstPsnr > 25.0 && gradientPsnr > 35.0 ? 0 : 1;
+    }
+
+    // Upload bytes and CPU rebuild time per edit, against re-uploading the whole vertex buffer
+    int benchDeform(int argc, char **argv)
+    {
+        int size = argInt(argc, argv, 3, 1024);
+        const size_t bytesPerVertex = 8 * sizeof(float);
+        size_t fullBytes = (size_t)size * size * bytesPerVertex;
+
+        std::vector<float> heights((size_t)size * size);
+        generateHeightfield(heights.data(), size, size, generateSineHeightRowFast, ThreadPool::shared());
+        std::vector<float> normals((size_t)size * size * 3);
+        computeNormals(heights.data(), size, size, normals.data(), 3, &ThreadPool::shared());
+
+        std::cout << "edits on " << size << "x" << size << " (full vertex buffer " << fullBytes << " bytes)" << std::endl;
+        std::cout << "edit              samples  upload bytes  spans  % of full  rebuild (us)" << std::endl;
+
+        std::vector<VertexUploadSpan> spans;
+        auto report = [&](const char *name, const DirtyRegionTracker &tracker)
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<TerrainRect> touched;
+            size_t samples = 0;
+            for (const TerrainRect &rect : tracker.getRects())
+            {
+                updateNormalsForDirtyRect(heights.data(), size, size, rect.x0, rect.z0, rect.x1, rect.z1, normals.data(), 3);
+                touched.push_back(rect.grown(1).clamped(size, size));
+                samples += rect.area();
+            }
+            collectVertexUploadSpans(touched, size, bytesPerVertex, spans);
+            double time = secondsSince(start);
+
+            size_t bytes = 0;
+            for (const VertexUploadSpan &span : spans)
+                bytes += span.size;
+            std::cout << name << samples << "     " << bytes << "        " << spans.size() << "     "
+                      << 100.0 * bytes / fullBytes << "     " << time * 1e6 << std::endl;
+        };
+
+        float center = size * 0.5f;
+        for (float radius : {2.0f, 4.0f, 8.0f, 16.0f})
+        {
+            DirtyRegionTracker tracker;
+            tracker.add(applyCrater(heights.data(), size, size, center, center, radius, 1.0f));
+            std::string name = "crater r=" + std::to_string((int)radius);
+            report((name + std::string(18 - name.size(), ' ')).c_str(), tracker);
+        }
+
+        // A car's worth of rut stamps for one second of driving
+        DirtyRegionTracker ruts;
+        for (int i = 0; i < 40; i++)
+        {
+            glm::vec2 from(center + i * 0.25f, center), to(center + (i + 1) * 0.25f, center);
+            ruts.add(applyRut(heights.data(), size, size, from + glm::vec2(0.0f, 0.7f), to + glm::vec2(0.0f, 0.7f), 0.4f, 0.03f));
+            ruts.add(applyRut(heights.data(), size, size, from - glm::vec2(0.0f, 0.7f), to - glm::vec2(0.0f, 0.7f), 0.4f, 0.03f));
+        }
+        report("ruts (40 stamps)  ", ruts);
+        return 0;
+    }
+}
+
+int runBenchmarks(int argc, char **argv)
+{
+    std::string name = argc > 2 ? argv[2] : "";
+
+    if (name == "terrain")
+        return benchTerrain(argc, argv);
+    if (name == "noise")
+        return benchNoise(argc, argv);
+    if (name == "lod")
+        return benchLod(argc, argv);
+    if (name == "strips")
+        return benchStrips(argc, argv);
+    if (name == "meshopt")
+        return benchMeshopt(argc, argv);
+    if (name == "normals")
+        return benchNormals(argc, argv);
+    if (name == "heightmap")
+        return benchHeightmap(argc, argv);
+    if (name == "deform")
+        return benchDeform(argc, argv);
+    if (name == "meshcache")
+        return benchMeshCache(argc, argv);
+    if (name == "heightquery")
+        return benchHeightQuery(argc, argv);
+    if (name == "raycast")
+        return benchRaycast(argc, argv);
+    if (name == "cull")
+        return benchCull(argc, argv);
+    if (name == "occlusion")
+        return benchOcclusion(argc, argv);
+    if (name == "clipmap")
+        return benchClipmap(argc, argv);
+    if (name == "splat")
+        return benchSplat(argc, argv);
+    if (name == "texsynth")
+        return benchTextureSynthesis(argc, argv);
+    if (name == "materials")
+        return benchMaterials(argc, argv);
+    if (name == "texbake")
+        return benchTextureBake(argc, argv);
+    if (name == "bc1")
+        return benchBC1(argc, argv);
+
+    std::cerr << "Usage: " << argv[0] << " --bench <name> [args]\n"
+              << "  terrain [size]   heightfield generation, cells/sec vs thread count\n"
+              << "  noise [size]     SIMD height kernel vs libm, max error and speedup\n"
+              << "  lod [max size]   CDLOD node selection and triangle budget vs map size\n"
+              << "  strips           16-bit restart strips vs triangle list, coverage and index bytes\n"
+              << "  meshopt [size]   vertex cache reordering of a terrain grid, ACMR/ATVR before and after\n"
+              << "  normals [size]   heightfield normals per SIMD level and thread count, dirty-rect update\n"
+              << "  heightmap [size] baked heightmap: generate vs mmap vs quantized decode startup\n"
+              << "  deform [size]    terrain edits: upload bytes and rebuild time vs edit size\n"
+              << "  meshcache [size] on-disk mesh cache: cold generate vs warm map startup\n"
+              << "  heightquery [size] batched SIMD height queries vs one call per point\n"
+              << "  raycast [size]   min/max pyramid ray casts (single, packets, threads) vs marching, rays/sec\n"
+              << "  cull [size]      per-chunk frustum culling: chunks and triangles kept, cull time\n"
+              << "  occlusion [size] CPU occlusion behind terrain: raster time per SIMD level, chunks hidden\n"
+              << "  clipmap [levels] geometry clipmap: height upload bytes per frame vs camera speed\n"
+              << "  splat [size]     material weight baking: throughput vs threads, error vs per-fragment blend\n"
+              << "  texsynth [size]  material texture synthesis: rand() baseline vs tiled generator vs threads\n"
+              << "  materials [size] material texture array: packed layers vs each material on its own\n"
+              << "  texbake [size]   baked textures: CPU mip filters per SIMD level, file load vs synthesis\n"
+              << "  bc1 [size]       BC1 encoder: throughput per SIMD level and thread count, PSNR per material" << std::endl;
+    return 1;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Runs the CPU benchmark named by argv[2] (e.g. `opengl_racing_game --bench terrain 4096`).
+// Benchmarks never create a window, so they work on machines without a GPU.
+// Returns the process exit code.
+int runBenchmarks(int argc, char **argv);
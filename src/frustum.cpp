@@ -0,0 +1,46 @@
+#include "frustum.h"
+
+Frustum Frustum::fromMatrix(const glm::mat4 &viewProjection)
+{
+    // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i)
+    { return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); };
+
+    Frustum frustum;
+    frustum.planes[Left] = row(3) + row(0);
+    frustum.planes[Right] = row(3) - row(0);
+    frustum.planes[Bottom] = row(3) + row(1);
+    frustum.planes[Top] = row(3) - row(1);
+    frustum.planes[Near] = row(3) + row(2);
+    frustum.planes[Far] = row(3) - row(2);
+
+    for (glm::vec4 &plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+
+    return frustum;
+}
+
+bool Frustum::intersectsAABB(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const
+{
+    for (const glm::vec4 &plane : planes)
+    {
+        // The box corner furthest along the plane normal
+        glm::vec3 positive(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                           plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                           plane.z >= 0.0f ? boxMax.z : boxMin.z);
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::containsPoint(const glm::vec3 &point) const
+{
+    for (const glm::vec4 &plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), point) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (ax + by + cz + d >= 0 inside)
+class Frustum
+{
+public:
+    enum Plane
+    {
+        Left,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        PlaneCount
+    };
+
+    glm::vec4 planes[PlaneCount];
+
+    // Extracts the planes from projection * view (Gribb/Hartmann)
+    static Frustum fromMatrix(const glm::mat4 &viewProjection);
+
+    // False only when the box is entirely outside one of the planes (conservative)
+    bool intersectsAABB(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const;
+
+    bool containsPoint(const glm::vec3 &point) const;
+};
@@ -0,0 +1,129 @@
+#include "gl_call_counter.h"
+
+#include <glad/glad.h>
+
+namespace
+{
+    // name, return type, parameters, arguments
+#define COUNTED_GL_FUNCTIONS(X)                                                                                         \
+    X(Clear, void, (GLbitfield mask), (mask))                                                                           \
+    X(Enable, void, (GLenum cap), (cap))                                                                                \
+    X(Disable, void, (GLenum cap), (cap))                                                                               \
+    X(Viewport, void, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))                         \
+    X(PrimitiveRestartIndex, void, (GLuint index), (index))                                                             \
+    X(UseProgram, void, (GLuint program), (program))                                                                    \
+    X(GetUniformLocation, GLint, (GLuint program, const GLchar *name), (program, name))                                 \
+    X(Uniform1i, void, (GLint location, GLint v0), (location, v0))                                                      \
+    X(Uniform1f, void, (GLint location, GLfloat v0), (location, v0))                                                    \
+    X(Uniform2i, void, (GLint location, GLint v0, GLint v1), (location, v0, v1))                                        \
+    X(Uniform2f, void, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1))                                    \
+    X(Uniform3f, void, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2))                    \
+    X(Uniform4f, void, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3))    \
+    X(Uniform2iv, void, (GLint location, GLsizei count, const GLint *value), (location, count, value))                  \
+    X(Uniform2fv, void, (GLint location, GLsizei count, const GLfloat *value), (location, count, value))                \
+    X(Uniform3fv, void, (GLint location, GLsizei count, const GLfloat *value), (location, count, value))                \
+    X(Uniform4fv, void, (GLint location, GLsizei count, const GLfloat *value), (location, count, value))                \
+    X(UniformMatrix4fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value),               \
+      (location, count, transpose, value))                                                                              \
+    X(ActiveTexture, void, (GLenum texture), (texture))                                                                 \
+    X(BindTexture, void, (GLenum target, GLuint texture), (target, texture))                                            \
+    X(BindVertexArray, void, (GLuint array), (array))                                                                   \
+    X(BindBuffer, void, (GLenum target, GLuint buffer), (target, buffer))                                               \
+    X(BindBufferRange, void, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size),            \
+      (target, index, buffer, offset, size))                                                                            \
+    X(BufferData, void, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), (target, size, data, usage))  \
+    X(BufferSubData, void, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data),                         \
+      (target, offset, size, data))                                                                                     \
+    X(MapBufferRange, void *, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access),                   \
+      (target, offset, length, access))                                                                                 \
+    X(FlushMappedBufferRange, void, (GLenum target, GLintptr offset, GLsizeiptr length), (target, offset, length))      \
+    X(UnmapBuffer, GLboolean, (GLenum target), (target))                                                                \
+    X(CopyBufferSubData, void,                                                                                          \
+      (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size),              \
+      (readTarget, writeTarget, readOffset, writeOffset, size))                                                         \
+    X(FenceSync, GLsync, (GLenum condition, GLbitfield flags), (condition, flags))                                      \
+    X(ClientWaitSync, GLenum, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout))                \
+    X(DeleteSync, void, (GLsync sync), (sync))                                                                          \
+    X(PixelStorei, void, (GLenum pname, GLint param), (pname, param))                                                   \
+    X(TexSubImage2D, void,                                                                                              \
+      (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format,          \
+       GLenum type, const void *pixels),                                                                                \
+      (target, level, xoffset, yoffset, width, height, format, type, pixels))                                           \
+    X(TexSubImage3D, void,                                                                                              \
+      (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height,          \
+       GLsizei depth, GLenum format, GLenum type, const void *pixels),                                                  \
+      (target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels))                           \
+    X(CompressedTexSubImage2D, void,                                                                                    \
+      (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format,          \
+       GLsizei imageSize, const void *data),                                                                            \
+      (target, level, xoffset, yoffset, width, height, format, imageSize, data))                                        \
+    X(CompressedTexSubImage3D, void,                                                                                    \
+      (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height,          \
+       GLsizei depth, GLenum format, GLsizei imageSize, const void *data),                                              \
+      (target, level, xoffset, yoffset, zoffset, width, height, depth, format, imageSize, data))                        \
+    X(DrawArrays, void, (GLenum mode, GLint first, GLsizei count), (mode, first, count))                                \
+    X(DrawElements, void, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices)) \
+    X(DrawElementsBaseVertex, void, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLint basevertex),   \
+      (mode, count, type, indices, basevertex))                                                                         \
+    X(MultiDrawElements, void,                                                                                          \
+      (GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei drawcount),                  \
+      (mode, count, type, indices, drawcount))                                                                          \
+    X(MultiDrawElementsBaseVertex, void,                                                                                \
+      (GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei drawcount,                   \
+       const GLint *basevertex),                                                                                        \
+      (mode, count, type, indices, drawcount, basevertex))
+
+    enum CountedFunction
+    {
+#define COUNTED_INDEX(name, ...) Counted##name,
+        COUNTED_GL_FUNCTIONS(COUNTED_INDEX)
+#undef COUNTED_INDEX
+            CountedFunctionCount
+    };
+
+    const char *const countedNames[CountedFunctionCount] = {
+#define COUNTED_NAME(name, ...) "gl" #name,
+        COUNTED_GL_FUNCTIONS(COUNTED_NAME)
+#undef COUNTED_NAME
+    };
+
+    uint64_t callCounts[CountedFunctionCount] = {};
+    bool installed = false;
+
+    // The loaded entry point and a wrapper that counts, then forwards to it
+#define COUNTED_WRAPPER(name, result, parameters, arguments) \
+    decltype(glad_gl##name) original##name = nullptr;        \
+    result APIENTRY counted##name parameters                 \
+    {                                                        \
+        callCounts[Counted##name]++;                         \
+        return original##name arguments;                     \
+    }
+    COUNTED_GL_FUNCTIONS(COUNTED_WRAPPER)
+#undef COUNTED_WRAPPER
+}
+
+void installGLCallCounters()
+{
+    if (installed)
+        return;
+    installed = true;
+
+#define COUNTED_INSTALL(name, ...)     \
+    original##name = glad_gl##name;    \
+    if (original##name)                \
+        glad_gl##name = counted##name;
+    COUNTED_GL_FUNCTIONS(COUNTED_INSTALL)
+#undef COUNTED_INSTALL
+}
+
+std::vector<GLCallCount> takeGLCallCounts()
+{
+    std::vector<GLCallCount> counts;
+    for (int i = 0; i < CountedFunctionCount; i++)
+    {
+        if (callCounts[i] > 0)
+            counts.push_back({countedNames[i], callCounts[i]});
+        callCounts[i] = 0;
+    }
+    return counts;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Per-entry-point GL call counts for the render loop. Installing swaps GLAD's function pointers
+// for the functions listed in COUNTED_GL_FUNCTIONS (gl_call_counter.cpp) with counting wrappers,
+// so calls to those are counted from every caller (renderers included) without touching them.
+// Functions missing from the list are not counted. Render thread only.
+
+struct GLCallCount
+{
+    const char *name;
+    uint64_t calls;
+};
+
+// Call after gladLoadGLLoader; installing twice does nothing
+void installGLCallCounters();
+
+// Counts since the last call for every counted function that was called, then starts over
+std::vector<GLCallCount> takeGLCallCounts();
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+// Compiles and links a vertex/fragment shader pair, printing any errors to std::cerr.
+// Returns the program name (check the log if rendering looks wrong).
+unsigned int compileShaderProgram(const char *vertexSource, const char *fragmentSource);
+
+// Copy of a shader source with text (whole lines) inserted after its #version line
+std::string addShaderPreamble(const char *source, const std::string &text);
+
+// Copy of a shader source with "#define name" inserted after its #version line, for picking a
+// variant of a shader at compile time
+std::string addShaderDefine(const char *source, const char *name);
+
+// True when the current context advertises the named extension (e.g.
+// "GL_EXT_texture_compression_s3tc")
+bool hasGLExtension(const char *name);
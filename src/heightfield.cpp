@@ -0,0 +1,50 @@
+#include "heightfield.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+float generateSineHeight(int x, int z)
+{
+    // Simple noise function for terrain generation
+    float scale = 0.1f;
+    float amplitude = 5.0f;
+
+    float height = 0.0f;
+    height += sin(x * scale) * cos(z * scale) * amplitude;
+    height += sin(x * scale * 0.5f) * cos(z * scale * 0.5f) * amplitude * 0.5f;
+    height += sin(x * scale * 0.25f) * cos(z * scale * 0.25f) * amplitude * 0.25f;
+
+    return height;
+}
+
+void generateSineHeightRow(int x0, int z, int count, float *out)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = generateSineHeight(x0 + i, z);
+}
+
+HeightStridedRowFunction stridedRowsFromRowFunction(HeightRowFunction rowFunction)
+{
+    return [rowFunction = std::move(rowFunction)](int x0, int z, int step, int count, float *out)
+    {
+        for (int i = 0; i < count; i++)
+            rowFunction(x0 + i * step, z, 1, out + i);
+    };
+}
+
+void generateHeightfieldSerial(float *out, int width, int height, const HeightRowFunction &rowFunction)
+{
+    for (int z = 0; z < height; z++)
+        rowFunction(0, z, width, out + (size_t)z * width);
+}
+
+void generateHeightfield(float *out, int width, int height, const HeightRowFunction &rowFunction,
+                         ThreadPool &pool, int rowsPerChunk)
+{
+    pool.parallelFor(0, height, rowsPerChunk, [&](int zBegin, int zEnd)
+                     {
+        for (int z = zBegin; z < zEnd; z++)
+            rowFunction(0, z, width, out + (size_t)z * width); });
+}
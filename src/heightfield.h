@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+
+class ThreadPool;
+
+// Writes count heights for grid row z, starting at column x0, into out
+using HeightRowFunction = std::function<void(int x0, int z, int count, float *out)>;
+
+// Writes count heights of grid row z at columns x0, x0 + step, x0 + 2 * step, ... into out
+using HeightStridedRowFunction = std::function<void(int x0, int z, int step, int count, float *out)>;
+
+// Strided rows from a row function, one call per sample, for sources without a batched form
+HeightStridedRowFunction stridedRowsFromRowFunction(HeightRowFunction rowFunction);
+
+// The original stacked sin/cos terrain height for a single grid cell
+float generateSineHeight(int x, int z);
+
+// Row generator that evaluates generateSineHeight cell by cell
+void generateSineHeightRow(int x0, int z, int count, float *out);
+
+// Fills a width x height row-major heightfield one row at a time on the calling thread
+void generateHeightfieldSerial(float *out, int width, int height, const HeightRowFunction &rowFunction);
+
+// Same output as generateHeightfieldSerial, with rows split into chunks across the pool.
+// Every cell is produced by the same row function, so the result is bit-for-bit identical.
+void generateHeightfield(float *out, int width, int height, const HeightRowFunction &rowFunction,
+                         ThreadPool &pool, int rowsPerChunk = 16);
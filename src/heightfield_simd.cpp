@@ -0,0 +1,186 @@
+#include "heightfield_simd.h"
+
+#include <cmath>
+
+namespace
+{
+    // Cody-Waite split of pi/2: the first two parts have few enough mantissa bits that k * part
+    // is exact for every quadrant index we can reach with |x| <= 8192
+    constexpr float TwoOverPi = 0.636619772367581343f;
+    constexpr float PiOver2A = 1.5703125f;
+    constexpr float PiOver2B = 4.837512969970703125e-4f;
+    constexpr float PiOver2C = 7.54978995489188216e-8f;
+
+    // Cephes sinf/cosf minimax coefficients for [-pi/4, pi/4]
+    constexpr float SinC1 = -1.6666654611e-1f;
+    constexpr float SinC2 = 8.3321608736e-3f;
+    constexpr float SinC3 = -1.9515295891e-4f;
+    constexpr float CosC1 = 4.166664568298827e-2f;
+    constexpr float CosC2 = -1.388731625493765e-3f;
+    constexpr float CosC3 = 2.443315711809948e-5f;
+
+    // Octave frequencies and amplitudes of generateSineHeight
+    constexpr int OctaveCount = 3;
+    constexpr float OctaveScale[OctaveCount] = {0.1f, 0.1f * 0.5f, 0.1f * 0.25f};
+    constexpr float OctaveAmplitude[OctaveCount] = {5.0f, 5.0f * 0.5f, 5.0f * 0.25f};
+
+    // sin(quadrant * pi/2 + r)
+    float sinQuadrant(int quadrant, float r)
+    {
+        float z = r * r;
+        float s = ((SinC3 * z + SinC2) * z + SinC1) * z * r + r;
+        float c = ((CosC3 * z + CosC2) * z + CosC1) * z * z - 0.5f * z + 1.0f;
+        float v = (quadrant & 1) ? c : s;
+        return (quadrant & 2) ? -v : v;
+    }
+
+    float reduce(float x, int &quadrant)
+    {
+        quadrant = (int)std::lrint(x * TwoOverPi);
+        float k = (float)quadrant;
+        return ((x - k * PiOver2A) - k * PiOver2B) - k * PiOver2C;
+    }
+
+    // Per-row cos(z) * amplitude terms shared by every cell in the row
+    void rowTerms(int z, float *terms)
+    {
+        for (int octave = 0; octave < OctaveCount; octave++)
+            terms[octave] = fastCos(z * OctaveScale[octave]) * OctaveAmplitude[octave];
+    }
+
+    void rowScalar(int x0, int count, const float *terms, float *out)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            float x = (float)(x0 + i);
+            float height = 0.0f;
+            for (int octave = 0; octave < OctaveCount; octave++)
+                height += fastSin(x * OctaveScale[octave]) * terms[octave];
+            out[i] = height;
+        }
+    }
+
+#if RACING_SIMD_X86
+    __m128 sinSSE2(__m128 x)
+    {
+        __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TwoOverPi)));
+        __m128 k = _mm_cvtepi32_ps(quadrant);
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(PiOver2A)));
+        r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(PiOver2B)));
+        r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(PiOver2C)));
+
+        __m128 z = _mm_mul_ps(r, r);
+        __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SinC3), z), _mm_set1_ps(SinC2));
+        s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SinC1));
+        s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), r), r);
+
+        __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(CosC3), z), _mm_set1_ps(CosC2));
+        c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(CosC1));
+        c = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+        c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+        __m128i one = _mm_set1_epi32(1);
+        __m128 useCos = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+        __m128 v = _mm_or_ps(_mm_and_ps(useCos, c), _mm_andnot_ps(useCos, s));
+        __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+        return _mm_xor_ps(v, sign);
+    }
+
+    void rowSSE2(int x0, int count, const float *terms, float *out)
+    {
+        int i = 0;
+        __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 x = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x0 + i), lane));
+            __m128 height = _mm_setzero_ps();
+            for (int octave = 0; octave < OctaveCount; octave++)
+            {
+                __m128 s = sinSSE2(_mm_mul_ps(x, _mm_set1_ps(OctaveScale[octave])));
+                height = _mm_add_ps(height, _mm_mul_ps(s, _mm_set1_ps(terms[octave])));
+            }
+            _mm_storeu_ps(out + i, height);
+        }
+        rowScalar(x0 + i, count - i, terms, out + i);
+    }
+
+    RACING_TARGET_AVX2 __m256 sinAVX2(__m256 x)
+    {
+        __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(TwoOverPi)));
+        __m256 k = _mm256_cvtepi32_ps(quadrant);
+        __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(PiOver2A)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(PiOver2B)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(PiOver2C)));
+
+        __m256 z = _mm256_mul_ps(r, r);
+        __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SinC3), z), _mm256_set1_ps(SinC2));
+        s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(SinC1));
+        s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), r), r);
+
+        __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(CosC3), z), _mm256_set1_ps(CosC2));
+        c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(CosC1));
+        c = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, z), z), _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+        c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+        __m256i one = _mm256_set1_epi32(1);
+        __m256 useCos = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+        __m256 v = _mm256_blendv_ps(s, c, useCos);
+        __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+        return _mm256_xor_ps(v, sign);
+    }
+
+    RACING_TARGET_AVX2 void rowAVX2(int x0, int count, const float *terms, float *out)
+    {
+        int i = 0;
+        __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 x = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x0 + i), lane));
+            __m256 height = _mm256_setzero_ps();
+            for (int octave = 0; octave < OctaveCount; octave++)
+            {
+                __m256 s = sinAVX2(_mm256_mul_ps(x, _mm256_set1_ps(OctaveScale[octave])));
+                height = _mm256_add_ps(height, _mm256_mul_ps(s, _mm256_set1_ps(terms[octave])));
+            }
+            _mm256_storeu_ps(out + i, height);
+        }
+        rowSSE2(x0 + i, count - i, terms, out + i);
+    }
+#endif
+}
+
+float fastSin(float x)
+{
+    int quadrant;
+    float r = reduce(x, quadrant);
+    return sinQuadrant(quadrant, r);
+}
+
+float fastCos(float x)
+{
+    int quadrant;
+    float r = reduce(x, quadrant);
+    return sinQuadrant(quadrant + 1, r);
+}
+
+void generateSineHeightRowFast(int x0, int z, int count, float *out)
+{
+    generateSineHeightRowSimd(x0, z, count, out, detectSimdLevel());
+}
+
+void generateSineHeightRowSimd(int x0, int z, int count, float *out, SimdLevel level)
+{
+    float terms[OctaveCount];
+    rowTerms(z, terms);
+
+    if (level > detectSimdLevel())
+        level = detectSimdLevel();
+
+#if RACING_SIMD_X86
+    if (level == SimdLevel::AVX2)
+        return rowAVX2(x0, count, terms, out);
+    if (level == SimdLevel::SSE2)
+        return rowSSE2(x0, count, terms, out);
+#endif
+    rowScalar(x0, count, terms, out);
+}
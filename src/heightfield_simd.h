@@ -0,0 +1,20 @@
+#pragma once
+
+#include "simd.h"
+
+// Polynomial sin/cos used by the batch height kernel.
+//
+// The argument is reduced to r in [-pi/4, pi/4] with a three-part Cody-Waite split of pi/2,
+// then evaluated with the Cephes single-precision minimax polynomials. For |x| <= 8192 the
+// absolute error against the exact result is below 1e-7 (about 1 ulp near 1.0), which keeps
+// a generated terrain height within 2e-6 of generateSineHeight (`--bench noise` checks both).
+float fastSin(float x);
+float fastCos(float x);
+
+// Batch version of generateSineHeightRow. cos(z) is hoisted out of the row, so each cell costs
+// three polynomial sines instead of six libm calls. The scalar, SSE2 and AVX2 paths perform the
+// same IEEE operations in the same order (no FMA), so they produce bit-identical rows.
+void generateSineHeightRowFast(int x0, int z, int count, float *out);
+
+// Same as above with an explicit instruction set level (clamped to what the CPU supports)
+void generateSineHeightRowSimd(int x0, int z, int count, float *out, SimdLevel level);
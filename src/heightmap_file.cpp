@@ -0,0 +1,218 @@
+#include "heightmap_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    constexpr char HeightmapMagic[4] = {'R', 'H', 'M', 'P'};
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    int tileExtent(int tile, int tileSize, int size)
+    {
+        return std::min(tileSize, size - tile * tileSize);
+    }
+}
+
+bool writeHeightmapFile(const char *path, const HeightRowFunction &source, int width, int height,
+                        HeightmapEncoding encoding, int tileSize, ThreadPool *pool)
+{
+    tileSize = std::max(tileSize, 1);
+
+    HeightmapFileHeader header = {};
+    std::memcpy(header.magic, HeightmapMagic, sizeof(header.magic));
+    header.version = HeightmapFileVersion;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.tileSize = (uint32_t)tileSize;
+    header.encoding = (uint32_t)encoding;
+    header.tilesX = (uint32_t)((width + tileSize - 1) / tileSize);
+    header.tilesZ = (uint32_t)((height + tileSize - 1) / tileSize);
+    header.minHeight = INFINITY;
+    header.maxHeight = -INFINITY;
+    header.tileTableOffset = sizeof(HeightmapFileHeader);
+
+    std::vector<HeightmapTileInfo> tiles((size_t)header.tilesX * header.tilesZ);
+    header.dataOffset = alignUp(header.tileTableOffset + tiles.size() * sizeof(HeightmapTileInfo), 64);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to create heightmap file " << path << std::endl;
+        return false;
+    }
+
+    // Header and tile table are written last, once every tile's range is known
+    std::vector<char> placeholder(header.dataOffset, 0);
+    file.write(placeholder.data(), placeholder.size());
+
+    std::vector<float> band((size_t)tileSize * width);
+    std::vector<uint16_t> quantized((size_t)tileSize * tileSize);
+    uint64_t offset = header.dataOffset;
+
+    for (int tz = 0; tz < (int)header.tilesZ; tz++)
+    {
+        int z0 = tz * tileSize;
+        int rows = tileExtent(tz, tileSize, height);
+
+        auto bandSource = [&](int x0, int z, int count, float *out)
+        { source(x0, z0 + z, count, out); };
+        if (pool)
+            generateHeightfield(band.data(), width, rows, bandSource, *pool);
+        else
+            generateHeightfieldSerial(band.data(), width, rows, bandSource);
+
+        for (int tx = 0; tx < (int)header.tilesX; tx++)
+        {
+            int x0 = tx * tileSize;
+            int columns = tileExtent(tx, tileSize, width);
+
+            HeightmapTileInfo &tile = tiles[(size_t)tz * header.tilesX + tx];
+            tile.minHeight = INFINITY;
+            tile.maxHeight = -INFINITY;
+            for (int z = 0; z < rows; z++)
+            {
+                auto range = std::minmax_element(&band[(size_t)z * width + x0], &band[(size_t)z * width + x0 + columns]);
+                tile.minHeight = std::min(tile.minHeight, *range.first);
+                tile.maxHeight = std::max(tile.maxHeight, *range.second);
+            }
+            header.minHeight = std::min(header.minHeight, tile.minHeight);
+            header.maxHeight = std::max(header.maxHeight, tile.maxHeight);
+
+            if (encoding == HeightmapEncoding::Float32)
+            {
+                tile.offset = header.dataOffset + ((uint64_t)z0 * width + x0) * sizeof(float);
+                continue;
+            }
+
+            float range = tile.maxHeight - tile.minHeight;
+            float scale = range > 0.0f ? 65535.0f / range : 0.0f;
+            for (int z = 0; z < rows; z++)
+            {
+                const float *row = &band[(size_t)z * width + x0];
+                for (int x = 0; x < columns; x++)
+                    quantized[(size_t)z * columns + x] = (uint16_t)std::lround((row[x] - tile.minHeight) * scale);
+            }
+
+            tile.offset = offset;
+            size_t bytes = (size_t)rows * columns * sizeof(uint16_t);
+            file.write(reinterpret_cast<const char *>(quantized.data()), bytes);
+            offset += bytes;
+        }
+
+        if (encoding == HeightmapEncoding::Float32)
+            file.write(reinterpret_cast<const char *>(band.data()), (size_t)rows * width * sizeof(float));
+    }
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(tiles.data()), tiles.size() * sizeof(HeightmapTileInfo));
+
+    if (!file.good())
+    {
+        std::cerr << "Failed to write heightmap file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool HeightmapFile::open(const char *path, ThreadPool *pool)
+{
+    header = nullptr;
+    tiles = nullptr;
+    heightData = nullptr;
+    decoded.clear();
+
+    if (!file.open(path))
+        return false;
+
+    auto fail = [&](const char *reason)
+    {
+        std::cerr << "Failed to load heightmap " << path << ": " << reason << std::endl;
+        file.close();
+        header = nullptr;
+        return false;
+    };
+
+    const unsigned char *bytes = file.data();
+    uint64_t size = file.size();
+    if (size < sizeof(HeightmapFileHeader))
+        return fail("file too small");
+
+    header = reinterpret_cast<const HeightmapFileHeader *>(bytes);
+    if (std::memcmp(header->magic, HeightmapMagic, sizeof(header->magic)) != 0)
+        return fail("not a heightmap file");
+    if (header->version != HeightmapFileVersion)
+        return fail("unsupported version");
+    if (header->encoding > (uint32_t)HeightmapEncoding::Quantized16)
+        return fail("unknown encoding");
+    if (header->width < 2 || header->height < 2 || header->tileSize == 0 ||
+        header->tilesX != (header->width + header->tileSize - 1) / header->tileSize ||
+        header->tilesZ != (header->height + header->tileSize - 1) / header->tileSize)
+        return fail("inconsistent dimensions");
+
+    uint64_t tileCount = (uint64_t)header->tilesX * header->tilesZ;
+    if (header->tileTableOffset % alignof(HeightmapTileInfo) != 0 ||
+        header->tileTableOffset + tileCount * sizeof(HeightmapTileInfo) > size)
+        return fail("truncated tile table");
+    tiles = reinterpret_cast<const HeightmapTileInfo *>(bytes + header->tileTableOffset);
+
+    int width = (int)header->width;
+    int height = (int)header->height;
+    int tileSize = (int)header->tileSize;
+
+    if (getEncoding() == HeightmapEncoding::Float32)
+    {
+        // The mapping is the height array
+        if (header->dataOffset % sizeof(float) != 0 ||
+            header->dataOffset + (uint64_t)width * height * sizeof(float) > size)
+            return fail("truncated height data");
+        heightData = reinterpret_cast<const float *>(bytes + header->dataOffset);
+        return true;
+    }
+
+    for (uint64_t i = 0; i < tileCount; i++)
+    {
+        int columns = tileExtent((int)(i % header->tilesX), tileSize, width);
+        int rows = tileExtent((int)(i / header->tilesX), tileSize, height);
+        if (tiles[i].offset % sizeof(uint16_t) != 0 || tiles[i].offset + (uint64_t)columns * rows * sizeof(uint16_t) > size)
+            return fail("truncated tile data");
+    }
+
+    decoded.resize((size_t)width * height);
+    auto decodeTiles = [&](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+        {
+            int tx = i % (int)header->tilesX, tz = i / (int)header->tilesX;
+            int columns = tileExtent(tx, tileSize, width);
+            int rows = tileExtent(tz, tileSize, height);
+
+            const HeightmapTileInfo &tile = tiles[i];
+            const uint16_t *source = reinterpret_cast<const uint16_t *>(bytes + tile.offset);
+            float scale = (tile.maxHeight - tile.minHeight) / 65535.0f;
+
+            for (int z = 0; z < rows; z++)
+            {
+                float *row = &decoded[(size_t)(tz * tileSize + z) * width + tx * tileSize];
+                for (int x = 0; x < columns; x++)
+                    row[x] = tile.minHeight + source[(size_t)z * columns + x] * scale;
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, (int)tileCount, 1, decodeTiles);
+    else
+        decodeTiles(0, (int)tileCount);
+
+    heightData = decoded.data();
+    return true;
+}
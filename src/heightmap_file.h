@@ -0,0 +1,83 @@
+#pragma once
+
+#include "heightfield.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+// Binary heightfield file, little-endian:
+//
+//   HeightmapFileHeader  64 bytes
+//   HeightmapTileInfo    one per tile, row-major, at tileTableOffset
+//   sample data          at dataOffset (64-byte aligned)
+//
+// Float32 files store the whole grid row-major, so a mapping of the file is directly usable as
+// the terrain's height array. Quantized16 files store each tile as 16-bit values between the
+// tile's min and max (half the size, error below (max - min) / 131070) and are decoded on open.
+
+constexpr uint32_t HeightmapFileVersion = 1;
+
+enum class HeightmapEncoding : uint32_t
+{
+    Float32 = 0,
+    Quantized16 = 1
+};
+
+struct HeightmapFileHeader
+{
+    char magic[4]; // "RHMP"
+    uint32_t version;
+    uint32_t width, height; // Samples
+    uint32_t tileSize;      // Samples per tile side; edge tiles may be smaller
+    uint32_t encoding;      // HeightmapEncoding
+    uint32_t tilesX, tilesZ;
+    float minHeight, maxHeight;
+    uint64_t tileTableOffset;
+    uint64_t dataOffset;
+    uint8_t reserved[8];
+};
+
+struct HeightmapTileInfo
+{
+    float minHeight, maxHeight;
+    uint64_t offset; // File offset of the tile's data (Quantized16) or of its first sample (Float32)
+};
+
+static_assert(sizeof(HeightmapFileHeader) == 64, "heightmap header layout is part of the file format");
+static_assert(sizeof(HeightmapTileInfo) == 16, "heightmap tile layout is part of the file format");
+
+// Converter: runs the generator one band of tiles at a time (rows spread over pool) and streams
+// it to path, so worlds far larger than memory can be written. Returns false on I/O failure.
+bool writeHeightmapFile(const char *path, const HeightRowFunction &source, int width, int height,
+                        HeightmapEncoding encoding, int tileSize = 256, ThreadPool *pool = nullptr);
+
+// A heightmap file opened for reading. Float32 files are used in place through the mapping.
+class HeightmapFile
+{
+public:
+    // Maps and validates path; Quantized16 tiles are decoded in parallel on pool. Returns false
+    // (and prints why) if the file is missing, truncated or not a supported version.
+    bool open(const char *path, ThreadPool *pool = nullptr);
+
+    // Row-major width x height samples, valid while the file stays open
+    const float *heights() const { return heightData; }
+    int getWidth() const { return (int)header->width; }
+    int getHeight() const { return (int)header->height; }
+    int getTileSize() const { return (int)header->tileSize; }
+    int getTilesX() const { return (int)header->tilesX; }
+    int getTilesZ() const { return (int)header->tilesZ; }
+    const HeightmapTileInfo &getTile(int tx, int tz) const { return tiles[(size_t)tz * header->tilesX + tx]; }
+    HeightmapEncoding getEncoding() const { return (HeightmapEncoding)header->encoding; }
+
+    // True when heights() points straight into the mapping (no copy was made)
+    bool isZeroCopy() const { return decoded.empty(); }
+
+private:
+    MappedFile file;
+    const HeightmapFileHeader *header = nullptr;
+    const HeightmapTileInfo *tiles = nullptr;
+    std::vector<float> decoded;
+    const float *heightData = nullptr;
+};
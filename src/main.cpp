@@ -5,6 +5,43 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "benchmarks.h"
+#include "gl_call_counter.h"
+#include "gl_utils.h"
+#include "heightfield.h"
+#include "heightfield_simd.h"
+#include "heightmap_file.h"
+#include "mesh_optimizer.h"
+#include "mip_filter.h"
+#include "occlusion_buffer.h"
+#include "shader_program.h"
+#include "terrain_chunks.h"
+#include "terrain_clipmap_renderer.h"
+#include "terrain_compact.h"
+#include "terrain_culling.h"
+#include "terrain_deform.h"
+#include "terrain_height_query.h"
+#include "terrain_indices.h"
+#include "terrain_lod_renderer.h"
+#include "terrain_mesh_cache.h"
+#include "terrain_noise.h"
+#include "terrain_normals.h"
+#include "terrain_raycast.h"
+#include "terrain_splat.h"
+#include "terrain_streaming.h"
+#include "texture_compression.h"
+#include "texture_file.h"
+#include "texture_synthesis.h"
+#include "thread_pool.h"
+#include "uniform_buffers.h"
+#include "upload_manager.h"
 
 // Defines several possible options for camera movement
 enum Camera_Movement
@@ -125,69 +162,225 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-// Texture loading function
-unsigned int loadTexture(const char *path)
+// Staging ring that meshes and textures upload through; created once the GL context exists
+UploadManager *uploads = nullptr;
+
+// Side and seed of the synthesized material textures ("--texture-size <n>"; "--seed <n>" also
+// reseeds the textures)
+int materialTextureSize = 256;
+uint32_t materialTextureSeed = 1;
+
+// Baked material layers with their mip chain ("--textures <file>", written by "--bake-textures
+// <file>"); without one the layers are synthesized at startup
+const char *bakedTexturePath = nullptr;
+
+// Material arrays are stored as BC1 when the driver supports S3TC, unless
+// "--no-texture-compression" is given; compressed arrays get CPU-built mips ("--mip-filter")
+bool compressMaterialTextures = true;
+MipFilter materialMipFilter = MipFilter::Kaiser;
+
+// From GL_EXT_texture_compression_s3tc, which the core 3.3 loader doesn't define
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+void setMaterialArraySampling()
+{
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// Queues every layer of one level of the bound material array through the upload ring. The
+// level's storage must already exist.
+void queueMaterialLevel(unsigned int textureID, int level, int width, int height, int layers, bool compressed,
+                        UploadFill fill, std::function<void()> onComplete = nullptr)
+{
+    TextureUploadRegion region;
+    region.target = GL_TEXTURE_2D_ARRAY;
+    region.texture = textureID;
+    region.level = level;
+    region.width = width;
+    region.height = height;
+    region.depth = layers;
+    region.compressed = compressed;
+    region.format = compressed ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGB;
+    region.type = GL_UNSIGNED_BYTE;
+    region.rowBytes = compressed ? bc1Size(width, 1) : (size_t)width * 3;
+    uploads->queueTexture(region, std::move(fill), std::move(onComplete));
+}
+
+// Encodes every layer of each level of chain to BC1 and queues it for the bound array; returns
+// the PSNR of level 0 against the uncompressed texels
+double uploadCompressedMaterialArray(unsigned int textureID, const MipChain &chain)
+{
+    double psnr = 0.0;
+    for (int level = 0; level < (int)chain.levels.size(); level++)
+    {
+        int width = chain.levelWidth(level), height = chain.levelHeight(level);
+        size_t layerBlocks = bc1Size(width, height);
+        auto blocks = std::make_shared<std::vector<uint8_t>>(layerBlocks * chain.layers);
+        for (int layer = 0; layer < chain.layers; layer++)
+            encodeBC1(chain.levels[level].data() + layer * chain.levelLayerBytes(level), width, height,
+                      blocks->data() + layer * layerBlocks, &ThreadPool::shared());
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height,
+                               chain.layers, 0, (GLsizei)blocks->size(), nullptr);
+        queueMaterialLevel(textureID, level, width, height, chain.layers, true, copyUploadFill(blocks->data(), blocks));
+
+        if (level == 0)
+        {
+            std::vector<uint8_t> decoded(chain.levels[0].size());
+            for (int layer = 0; layer < chain.layers; layer++)
+                decodeBC1(blocks->data() + layer * layerBlocks, width, height,
+                          decoded.data() + layer * chain.levelLayerBytes(0));
+            psnr = computePsnr(chain.levels[0].data(), decoded.data(), decoded.size());
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (int)chain.levels.size() - 1);
+    return psnr;
+}
+
+// Builds every terrain material as one layer of a texture array, so the terrain shaders bind a
+// single texture and pick materials by layer index. Compressed arrays report the level 0 PSNR
+// through psnr.
+unsigned int createMaterialArray(bool compress, double &psnr)
 {
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    // For now, we'll create a simple procedural texture
-    // In a real implementation, you'd load from image files
-    const int width = 256;
-    const int height = 256;
-    unsigned char *data = new unsigned char[width * height * 3];
+    // Procedural colour noise, tiles generated in parallel with a deterministic generator each
+    size_t layerBytes = (size_t)materialTextureSize * materialTextureSize * 3;
+    auto layers = std::make_shared<std::vector<uint8_t>>(layerBytes * TerrainMaterialCount);
+    synthesizeMaterialLayers(materialTextureSize, materialTextureSize, materialTextureSeed, layers->data(),
+                             &ThreadPool::shared());
 
-    // Generate a simple procedural texture
-    for (int i = 0; i < width * height; i++)
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    if (compress)
     {
-        int x = i % width;
-        int y = i / width;
+        // Compressed levels can't be mipmapped by the driver, so the chain is built on the CPU
+        MipChain chain;
+        chain.width = chain.height = materialTextureSize;
+        chain.layers = TerrainMaterialCount;
+        chain.channels = 3;
+        chain.levels.push_back(std::move(*layers));
+        buildMipChain(chain, materialMipFilter, &ThreadPool::shared());
+        psnr = uploadCompressedMaterialArray(textureID, chain);
+
+        setMaterialArraySampling();
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return textureID;
+    }
 
-        // Create different patterns based on texture type
-        if (strstr(path, "grass"))
-        {
-            // Grass texture - green with some variation
-            data[i * 3] = 34 + (rand() % 50);      // R
-            data[i * 3 + 1] = 139 + (rand() % 50); // G
-            data[i * 3 + 2] = 34 + (rand() % 50);  // B
-        }
-        else if (strstr(path, "rock"))
+    // The driver builds the mips once the last layer has been copied in
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, materialTextureSize, materialTextureSize, TerrainMaterialCount, 0,
+                 GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    queueMaterialLevel(textureID, 0, materialTextureSize, materialTextureSize, TerrainMaterialCount, false,
+                       copyUploadFill(layers->data(), layers),
+                       [textureID]
+                       {
+                           glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+                           glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+                           glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+                       });
+
+    setMaterialArraySampling();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return textureID;
+}
+
+// Queues a baked material array level by level; the loaders copy straight from the file's
+// mapping, which the uploads keep open. BC1 files are decoded on the CPU first when the driver has
+// no S3TC support.
+unsigned int createMaterialArray(std::shared_ptr<const TextureFile> file, bool s3tc)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    for (int level = 0; level < file->getLevelCount(); level++)
+    {
+        const TextureLevelInfo &info = file->getLevel(level);
+        if (file->getCompression() == TextureCompression::None)
         {
-            // Rock texture - gray with variation
-            int gray = 100 + (rand() % 80);
-            data[i * 3] = gray;     // R
-            data[i * 3 + 1] = gray; // G
-            data[i * 3 + 2] = gray; // B
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB8, info.width, info.height, file->getLayers(), 0, GL_RGB,
+                         GL_UNSIGNED_BYTE, nullptr);
+            queueMaterialLevel(textureID, level, info.width, info.height, file->getLayers(), false,
+                               copyUploadFill(file->levelData(level), file));
         }
-        else if (strstr(path, "sand"))
+        else if (s3tc)
         {
-            // Sand texture - beige
-            data[i * 3] = 194 + (rand() % 40);     // R
-            data[i * 3 + 1] = 178 + (rand() % 40); // G
-            data[i * 3 + 2] = 128 + (rand() % 40); // B
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, info.width,
+                                   info.height, file->getLayers(), 0, (GLsizei)info.size, nullptr);
+            queueMaterialLevel(textureID, level, info.width, info.height, file->getLayers(), true,
+                               copyUploadFill(file->levelData(level), file));
         }
         else
         {
-            // Default - brown earth
-            data[i * 3] = 139 + (rand() % 40);    // R
-            data[i * 3 + 1] = 69 + (rand() % 40); // G
-            data[i * 3 + 2] = 19 + (rand() % 40); // B
+            size_t layerBlocks = bc1Size(info.width, info.height), layerBytes = (size_t)info.width * info.height * 3;
+            auto decoded = std::make_shared<std::vector<uint8_t>>(layerBytes * file->getLayers());
+            for (int layer = 0; layer < file->getLayers(); layer++)
+                decodeBC1(file->levelData(level) + layer * layerBlocks, info.width, info.height,
+                          decoded->data() + layer * layerBytes);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB8, info.width, info.height, file->getLayers(), 0, GL_RGB,
+                         GL_UNSIGNED_BYTE, nullptr);
+            queueMaterialLevel(textureID, level, info.width, info.height, file->getLayers(), false,
+                               copyUploadFill(decoded->data(), decoded));
         }
     }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, file->getLevelCount() - 1);
 
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    setMaterialArraySampling();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
-    delete[] data;
     return textureID;
 }
 
+// Reads the array back and compares every layer with its material synthesized on its own (and
+// BC1-encoded, for a compressed array); returns false (and reports the layers) on any difference
+bool checkMaterialArray(unsigned int textureID, bool compressed)
+{
+    size_t layerBytes = (size_t)materialTextureSize * materialTextureSize * 3;
+    size_t layerBlocks = bc1Size(materialTextureSize, materialTextureSize);
+    std::vector<uint8_t> layers((compressed ? layerBlocks : layerBytes) * TerrainMaterialCount);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    if (compressed)
+        glGetCompressedTexImage(GL_TEXTURE_2D_ARRAY, 0, layers.data());
+    else
+        glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, GL_UNSIGNED_BYTE, layers.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    std::vector<uint8_t> texels(layerBytes), blocks(layerBlocks);
+    bool valid = true;
+    for (int material = 0; material < TerrainMaterialCount; material++)
+    {
+        size_t mismatches = 0;
+        if (compressed)
+        {
+            synthesizeMaterialTexture((TerrainMaterial)material, materialTextureSize, materialTextureSize,
+                                      materialTextureSeed, texels.data(), &ThreadPool::shared());
+            encodeBC1(texels.data(), materialTextureSize, materialTextureSize, blocks.data(), &ThreadPool::shared());
+            for (size_t i = 0; i < layerBlocks; i++)
+                mismatches += layers[material * layerBlocks + i] != blocks[i];
+        }
+        else
+        {
+            mismatches = countLayerMismatches((TerrainMaterial)material, layers.data() + material * layerBytes,
+                                              materialTextureSize, materialTextureSize, materialTextureSeed,
+                                              &ThreadPool::shared());
+        }
+        if (mismatches > 0)
+        {
+            std::cerr << "Material layer " << material << ": " << mismatches << " bytes differ" << std::endl;
+            valid = false;
+        }
+    }
+    return valid;
+}
+
 // Terrain class
 class Terrain
 {
@@ -195,52 +388,166 @@ public:
     unsigned int VAO, VBO, EBO;
     int width, height;
     std::vector<float> heights;
+    // Heights the mesh and getHeight read: heights.data() when generated, or a mapped file
+    const float *heightData = nullptr;
     std::vector<unsigned int> indices;
     std::vector<float> vertices;
-    unsigned int grassTexture, rockTexture, sandTexture, earthTexture;
+    // Mesh buffers setupMesh uploads: the vectors above, or a mapped mesh cache
+    const float *vertexData = nullptr;
+    const unsigned int *indexData = nullptr;
+    size_t indexCount = 0;
+    // Material layers in TerrainMaterial order, BC1-compressed when materialCompressed
+    unsigned int materialArray;
+    bool materialCompressed = false;
+
+    // RGBA8 material weights per sample for the BAKED_SPLAT shader; empty until bakeMaterials
+    std::vector<uint8_t> splatWeights;
+    unsigned int splatTexture = 0;
+
+    // Produces the heightmap rows (sine pattern by default, seeded noise via TerrainNoise); empty
+    // for terrains built from a heightmap file or mesh cache, whose heights live in heightData
+    HeightRowFunction heightSource;
+
+    // Min/max pyramid for ray casts, kept in step with edits by flushEdits
+    TerrainHeightPyramid pyramid;
+
+    // Index ranges and boxes of the culling chunks; render(frustum) draws only the visible ones
+    std::vector<TerrainCullChunk> cullChunks;
+    std::vector<int> drawCounts;
+    std::vector<const void *> drawOffsets;
+    TerrainCullStats cullStats;
+
+    // Edits waiting for flushEdits
+    DirtyRegionTracker dirtyRegions;
+    std::vector<VertexUploadSpan> uploadSpans;
+
+    Terrain(int w, int h, HeightRowFunction source = generateSineHeightRowFast)
+        : width(w), height(h), heightSource(std::move(source))
+    {
+        loadTextures();
+        generateTerrain();
+        setupMesh();
+        buildBounds();
+    }
 
-    Terrain(int w, int h) : width(w), height(h)
+    // Builds the mesh straight from a heightmap file's heights without copying them. The file
+    // must stay open for the terrain's lifetime.
+    Terrain(const HeightmapFile &file)
+        : width(file.getWidth()), height(file.getHeight()), heightData(file.heights())
     {
-        // Load textures
-        grassTexture = loadTexture("grass");
-        rockTexture = loadTexture("rock");
-        sandTexture = loadTexture("sand");
-        earthTexture = loadTexture("earth");
+        loadTextures();
+        generateMesh();
+        setupMesh();
+        buildBounds();
+    }
 
-        generateTerrain();
+    // Material textures only, for endless worlds: the streamer or clipmap owns the heights and
+    // meshes, so there is no grid, mesh or GL buffer here (width and height are 0)
+    Terrain() : VAO(0), VBO(0), EBO(0), width(0), height(0)
+    {
+        loadTextures();
+    }
+
+    // Uploads a cached mesh straight from its mapping. The cache must have been opened for 8
+    // floats per vertex (the layout setupMesh and the splat bake read) and stay open for the
+    // terrain's lifetime.
+    Terrain(const TerrainMeshCache &cache)
+        : width(cache.getWidth()), height(cache.getHeight()), heightData(cache.heights()),
+          vertexData(cache.vertices()), indexData(cache.indices()), indexCount(cache.getIndexCount())
+    {
+        layoutTerrainChunks(width, height, TerrainCullChunkSize, cullChunks);
+        loadTextures();
         setupMesh();
+        buildBounds();
     }
 
-    void generateTerrain()
+    // Ray cast pyramid and culling boxes over the finished heights
+    void buildBounds()
     {
-        heights.resize(width * height);
+        pyramid.build(heightData, width, height, &ThreadPool::shared());
+        updateChunkBounds(heightData, width, 0, 0, width, height, cullChunks, &ThreadPool::shared());
+    }
 
-        // Generate heightmap using simple noise
-        for (int z = 0; z < height; z++)
+    // Bakes the material weights of every sample into splatTexture
+    void bakeMaterials()
+    {
+        splatWeights.resize((size_t)width * height * 4);
+        bakeSplatMap(heightData, vertexData + 3, 8, width, height, splatWeights.data(), &ThreadPool::shared());
+
+        glGenTextures(1, &splatTexture);
+        glBindTexture(GL_TEXTURE_2D, splatTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        TextureUploadRegion region;
+        region.target = GL_TEXTURE_2D;
+        region.texture = splatTexture;
+        region.width = width;
+        region.height = height;
+        region.format = GL_RGBA;
+        region.type = GL_UNSIGNED_BYTE;
+        region.rowBytes = (size_t)width * 4;
+        uploads->queueTexture(region, copyUploadFill(splatWeights.data()));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void loadTextures()
+    {
+        auto start = std::chrono::steady_clock::now();
+        bool s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+        auto baked = std::make_shared<TextureFile>();
+        if (bakedTexturePath && baked->open(bakedTexturePath))
         {
-            for (int x = 0; x < width; x++)
+            if (baked->getLayers() == TerrainMaterialCount && baked->getChannels() == 3 &&
+                baked->getWidth() == baked->getHeight())
             {
-                float heightValue = generateHeight(x, z);
-                heights[z * width + x] = heightValue;
+                materialArray = createMaterialArray(baked, s3tc);
+                materialCompressed = baked->getCompression() == TextureCompression::BC1 && s3tc;
+                materialTextureSize = baked->getWidth();
+                std::cout << "Material textures: " << TerrainMaterialCount << " layers of " << materialTextureSize
+                          << "x" << materialTextureSize << " loaded from " << bakedTexturePath << " ("
+                          << baked->getLevelCount() << " levels, " << mipFilterName(baked->getMipFilter())
+                          << " mips, "
+                          << (baked->getCompression() == TextureCompression::None ? "uncompressed"
+                              : materialCompressed                                 ? "BC1"
+                                                                                   : "BC1 decoded on the CPU")
+                          << ", " << baked->size() << " bytes) in "
+                          << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                          << " ms" << std::endl;
+                return;
             }
+            std::cerr << bakedTexturePath << " does not hold " << TerrainMaterialCount
+                      << " square RGB material layers; synthesizing them instead" << std::endl;
         }
 
-        // Generate vertices and indices
-        generateMesh();
+        materialCompressed = compressMaterialTextures && s3tc;
+        double psnr = 0.0;
+        materialArray = createMaterialArray(materialCompressed, psnr);
+        size_t uncompressedBytes = (size_t)materialTextureSize * materialTextureSize * 3 * TerrainMaterialCount;
+        std::cout << "Material textures: " << TerrainMaterialCount << " layers of " << materialTextureSize << "x"
+                  << materialTextureSize << " synthesized in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                  << " ms (seed " << materialTextureSeed << ", ";
+        if (materialCompressed)
+            std::cout << "BC1 with " << mipFilterName(materialMipFilter) << " mips: level 0 "
+                      << bc1Size(materialTextureSize, materialTextureSize) * TerrainMaterialCount
+                      << " bytes instead of " << uncompressedBytes << ", PSNR " << psnr << " dB)" << std::endl;
+        else
+            std::cout << (s3tc ? "uncompressed" : "no S3TC support") << ", mipmapped on the GPU)" << std::endl;
     }
 
-    float generateHeight(int x, int z)
+    void generateTerrain()
     {
-        // Simple noise function for terrain generation
-        float scale = 0.1f;
-        float amplitude = 5.0f;
+        heights.resize(width * height);
 
-        float height = 0.0f;
-        height += sin(x * scale) * cos(z * scale) * amplitude;
-        height += sin(x * scale * 0.5f) * cos(z * scale * 0.5f) * amplitude * 0.5f;
-        height += sin(x * scale * 0.25f) * cos(z * scale * 0.25f) * amplitude * 0.25f;
+        // Generate heightmap using simple noise, split into row chunks across the thread pool
+        generateHeightfield(heights.data(), width, height, heightSource, ThreadPool::shared());
+        heightData = heights.data();
 
-        return height;
+        // Generate vertices and indices
+        generateMesh();
     }
 
     void generateMesh()
@@ -253,14 +560,14 @@ public:
         {
             for (int x = 0; x < width; x++)
             {
-                float y = heights[z * width + x];
+                float y = heightData[z * width + x];
 
                 // Position
                 vertices.push_back(x);
                 vertices.push_back(y);
                 vertices.push_back(z);
 
-                // Normal (simplified - will calculate proper normals later)
+                // Normal (filled in below)
                 vertices.push_back(0.0f);
                 vertices.push_back(1.0f);
                 vertices.push_back(0.0f);
@@ -271,29 +578,134 @@ public:
             }
         }
 
-        // Generate indices
-        for (int z = 0; z < height - 1; z++)
+        // Normals from central differences, written straight into the interleaved vertices
+        computeNormals(heightData, width, height, vertices.data() + 3, 8, &ThreadPool::shared());
+
+        // Generate indices chunk by chunk so each culling chunk is one index range
+        buildChunkedTriangleList(width, height, TerrainCullChunkSize, indices, cullChunks);
+        optimizeIndices();
+
+        vertexData = vertices.data();
+        indexData = indices.data();
+        indexCount = indices.size();
+    }
+
+    // Recomputes the normals around heights edited in [x0, x1) x [z0, z1) (CPU copy only)
+    void updateNormals(int x0, int z0, int x1, int z1)
+    {
+        updateNormalsForDirtyRect(heightData, width, height, x0, z0, x1, z1, vertices.data() + 3, 8,
+                                  &ThreadPool::shared());
+    }
+
+    // Heights that can be edited. Mapped heights and vertices are copied on the first edit.
+    float *editableHeights()
+    {
+        if (heightData != heights.data())
+        {
+            heights.assign(heightData, heightData + (size_t)width * height);
+            heightData = heights.data();
+        }
+        if (vertexData != vertices.data())
+        {
+            vertices.assign(vertexData, vertexData + (size_t)width * height * 8);
+            vertexData = vertices.data();
+        }
+        return heights.data();
+    }
+
+    void deformCrater(float x, float z, float radius, float depth)
+    {
+        dirtyRegions.add(applyCrater(editableHeights(), width, height, x, z, radius, depth));
+    }
+
+    void deformRut(const glm::vec2 &from, const glm::vec2 &to, float halfWidth, float depth)
+    {
+        dirtyRegions.add(applyRut(editableHeights(), width, height, from, to, halfWidth, depth));
+    }
+
+    void deform(const TerrainRect &rect, const std::function<float(int, int, float)> &edit)
+    {
+        dirtyRegions.add(applyHeightEdit(editableHeights(), width, height, rect, edit));
+    }
+
+    // Rebuilds the vertices of every edited region and uploads just those rows with
+    // glBufferSubData. Returns the bytes uploaded, which stays proportional to the edit size.
+    size_t flushEdits()
+    {
+        if (dirtyRegions.isEmpty())
+            return 0;
+
+        // Normals change one sample beyond the edited heights
+        std::vector<TerrainRect> touched;
+        for (const TerrainRect &rect : dirtyRegions.getRects())
+        {
+            updateNormals(rect.x0, rect.z0, rect.x1, rect.z1);
+            pyramid.update(heightData, rect.x0, rect.z0, rect.x1, rect.z1);
+            updateChunkBounds(heightData, width, rect.x0, rect.z0, rect.x1, rect.z1, cullChunks);
+
+            TerrainRect grown = rect.grown(1).clamped(width, height);
+            for (int z = grown.z0; z < grown.z1; z++)
+                for (int x = grown.x0; x < grown.x1; x++)
+                    vertices[((size_t)z * width + x) * 8 + 1] = heightData[(size_t)z * width + x];
+            touched.push_back(grown);
+        }
+        dirtyRegions.clear();
+
+        collectVertexUploadSpans(touched, width, 8 * sizeof(float), uploadSpans);
+
+        size_t bytes = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        for (const VertexUploadSpan &span : uploadSpans)
         {
-            for (int x = 0; x < width - 1; x++)
+            glBufferSubData(GL_ARRAY_BUFFER, span.offset, span.size, (const char *)vertices.data() + span.offset);
+            bytes += span.size;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // Material weights follow the new heights and normals over the same rectangles
+        if (splatTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, splatTexture);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+            for (const TerrainRect &rect : touched)
             {
-                unsigned int topLeft = z * width + x;
-                unsigned int topRight = topLeft + 1;
-                unsigned int bottomLeft = (z + 1) * width + x;
-                unsigned int bottomRight = bottomLeft + 1;
-
-                // First triangle
-                indices.push_back(topLeft);
-                indices.push_back(bottomLeft);
-                indices.push_back(topRight);
-
-                // Second triangle
-                indices.push_back(topRight);
-                indices.push_back(bottomLeft);
-                indices.push_back(bottomRight);
+                bakeSplatMapRect(heightData, vertexData + 3, 8, width, height, rect.x0, rect.z0, rect.x1, rect.z1,
+                                 splatWeights.data());
+                glPixelStorei(GL_UNPACK_SKIP_PIXELS, rect.x0);
+                glPixelStorei(GL_UNPACK_SKIP_ROWS, rect.z0);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x0, rect.z0, rect.x1 - rect.x0, rect.z1 - rect.z0, GL_RGBA,
+                                GL_UNSIGNED_BYTE, splatWeights.data());
+                bytes += (size_t)rect.area() * 4;
             }
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+            glBindTexture(GL_TEXTURE_2D, 0);
         }
+        return bytes;
+    }
+
+    void optimizeIndices()
+    {
+        VertexCacheStats before = analyzeVertexCache(indices.data(), indices.size(), (size_t)width * height);
+
+        // Reorder triangles for the vertex cache within each culling chunk, which keeps the
+        // chunks contiguous and lets large maps use every thread. Vertices stay row-major: the
+        // compact and chunked meshes address them by grid index.
+        ThreadPool::shared().parallelFor(0, (int)cullChunks.size(), 1, [&](int first, int last)
+                                         {
+            for (int c = first; c < last; c++)
+            {
+                unsigned int *chunkIndices = &indices[cullChunks[c].firstIndex];
+                optimizeVertexCache(chunkIndices, chunkIndices, cullChunks[c].indexCount);
+            } });
+
+        VertexCacheStats after = analyzeVertexCache(indices.data(), indices.size(), (size_t)width * height);
+        printVertexCacheReport("Terrain", before, after);
     }
 
+    // Allocates the buffers and queues their contents on the upload ring, which reads vertexData
+    // and indexData until the uploads are flushed
     void setupMesh()
     {
         glGenVertexArrays(1, &VAO);
@@ -302,11 +714,14 @@ public:
 
         glBindVertexArray(VAO);
 
+        size_t vertexBytes = (size_t)width * height * 8 * sizeof(float);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+        uploads->queueBuffer(VBO, 0, vertexBytes, copyUploadFill(vertexData));
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+        uploads->queueBuffer(EBO, 0, indexCount * sizeof(unsigned int), copyUploadFill(indexData));
 
         // Position attribute
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
@@ -323,37 +738,43 @@ public:
         glBindVertexArray(0);
     }
 
-    void render()
+    // Draws every chunk, or with a frustum only the chunks inside it (one multi-draw). An
+    // occlusion buffer also skips the chunks hidden behind it.
+    void render(const Frustum *frustum = nullptr, const OcclusionBuffer *occlusion = nullptr)
     {
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        if (!frustum)
+        {
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        }
+        else
+        {
+            cullTerrainChunks(cullChunks, *frustum, sizeof(unsigned int), drawCounts, drawOffsets, cullStats,
+                              occlusion);
+            if (!drawCounts.empty())
+                glMultiDrawElements(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(),
+                                    (GLsizei)drawCounts.size());
+        }
         glBindVertexArray(0);
     }
 
-    float getHeight(float x, float z)
+    // Bilinear height under (x, z); 0 off the map
+    float getHeight(float x, float z) const
     {
-        // Convert world coordinates to grid coordinates
-        int gridX = (int)x;
-        int gridZ = (int)z;
-
-        if (gridX < 0 || gridX >= width - 1 || gridZ < 0 || gridZ >= height - 1)
-        {
-            return 0.0f;
-        }
-
-        // Bilinear interpolation for smooth height
-        float xCoord = x - gridX;
-        float zCoord = z - gridZ;
-
-        float h00 = heights[gridZ * width + gridX];
-        float h10 = heights[gridZ * width + gridX + 1];
-        float h01 = heights[(gridZ + 1) * width + gridX];
-        float h11 = heights[(gridZ + 1) * width + gridX + 1];
+        return sampleHeight(heightData, width, height, x, z);
+    }
 
-        float h0 = h00 * (1 - xCoord) + h10 * xCoord;
-        float h1 = h01 * (1 - xCoord) + h11 * xCoord;
+    // Nearest point where a ray (normalized direction) comes down onto the terrain
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, TerrainRayHit &hit) const
+    {
+        return pyramid.raycast(origin, direction, maxDistance, hit);
+    }
 
-        return h0 * (1 - zCoord) + h1 * zCoord;
+    // Heights (and optionally slopes) for many points at once, e.g. every wheel of every car
+    void getHeights(const float *x, const float *z, size_t count, float *out, float *gradientX = nullptr,
+                    float *gradientZ = nullptr) const
+    {
+        sampleHeights(heightData, width, height, x, z, count, out, gradientX, gradientZ);
     }
 };
 
@@ -429,17 +850,31 @@ public:
             20, 21, 22, 22, 23, 20  // Bottom
         };
 
+        // Same optimization stage as the terrain: triangle order first, then vertex order
+        VertexCacheStats before = analyzeVertexCache(indices, 36, 24);
+        optimizeVertexCache(indices, indices, 36);
+        optimizeVertexFetch(vertices, indices, 36, 24, 8 * sizeof(float));
+        printVertexCacheReport("Vehicle", before, analyzeVertexCache(indices, 36, 24));
+
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
         glBindVertexArray(VAO);
 
+        // The arrays are locals, so the uploads take copies
+        auto vertexBytes = std::make_shared<std::vector<uint8_t>>((const uint8_t *)vertices,
+                                                                  (const uint8_t *)vertices + sizeof(vertices));
+        auto indexBytes = std::make_shared<std::vector<uint8_t>>((const uint8_t *)indices,
+                                                                 (const uint8_t *)indices + sizeof(indices));
+
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), nullptr, GL_STATIC_DRAW);
+        uploads->queueBuffer(VBO, 0, sizeof(vertices), copyUploadFill(vertexBytes->data(), vertexBytes));
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), nullptr, GL_STATIC_DRAW);
+        uploads->queueBuffer(EBO, 0, sizeof(indices), copyUploadFill(indexBytes->data(), indexBytes));
 
         // Position attribute
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
@@ -456,13 +891,13 @@ public:
         glBindVertexArray(0);
     }
 
-    void update(float deltaTime, Terrain &terrain)
+    void update(float deltaTime, const std::function<float(float, float)> &groundHeight)
     {
         // Update position first
         position += velocity * deltaTime;
 
         // Get terrain height at current position
-        float terrainHeight = terrain.getHeight(position.x, position.z);
+        float terrainHeight = groundHeight(position.x, position.z);
 
         // Always adjust Y position to terrain height (with vehicle height offset)
         if (position.y > terrainHeight + height * 0.5f)
@@ -508,10 +943,6 @@ const char *vertexShaderSource = R"(
     layout (location = 1) in vec3 aNormal;
     layout (location = 2) in vec2 aTexCoord;
     
-    uniform mat4 model;
-    uniform mat4 view;
-    uniform mat4 projection;
-    
     out vec3 FragPos;
     out vec3 Normal;
     out vec2 TexCoord;
@@ -535,14 +966,14 @@ const char *fragmentShaderSource = R"(
     in vec3 Normal;
     in vec2 TexCoord;
     
-    uniform sampler2D grassTexture;
-    uniform sampler2D rockTexture;
-    uniform sampler2D sandTexture;
-    uniform sampler2D earthTexture;
-    uniform vec3 lightPos;
-    uniform vec3 viewPos;
-    uniform vec3 lightColor;
-    uniform vec3 objectColor;
+    // Material layers
+    const float GRASS = 0.0;
+    const float ROCK = 1.0;
+    const float SAND = 2.0;
+    const float EARTH = 3.0;
+    
+    uniform sampler2DArray materials; // one layer per material, in TerrainMaterial order
+    uniform sampler2D splatMap; // BAKED_SPLAT: (grass, rock, sand, earth) weights per heightfield sample
     
     void main()
     {
@@ -553,15 +984,23 @@ const char *fragmentShaderSource = R"(
         if (objectColor.x > 0.0 || objectColor.y > 0.0 || objectColor.z > 0.0) {
             finalColor = vec4(objectColor, 1.0);
         } else {
+#ifdef BAKED_SPLAT
+            // One filtered fetch of the baked weights replaces the height/slope blend below
+            vec4 weights = texture(splatMap, (FragPos.xz + 0.5) / vec2(textureSize(splatMap, 0)));
+            finalColor = weights.r * texture(materials, vec3(TexCoord, GRASS)) +
+                         weights.g * texture(materials, vec3(TexCoord, ROCK)) +
+                         weights.b * texture(materials, vec3(TexCoord, SAND)) +
+                         weights.a * texture(materials, vec3(TexCoord, EARTH));
+#else
             // Calculate height and slope for texture blending (terrain)
             float height = FragPos.y;
             float slope = 1.0 - dot(normalize(Normal), vec3(0.0, 1.0, 0.0));
             
             // Sample all textures
-            vec4 grass = texture(grassTexture, TexCoord);
-            vec4 rock = texture(rockTexture, TexCoord);
-            vec4 sand = texture(sandTexture, TexCoord);
-            vec4 earth = texture(earthTexture, TexCoord);
+            vec4 grass = texture(materials, vec3(TexCoord, GRASS));
+            vec4 rock = texture(materials, vec3(TexCoord, ROCK));
+            vec4 sand = texture(materials, vec3(TexCoord, SAND));
+            vec4 earth = texture(materials, vec3(TexCoord, EARTH));
             
             // Blend textures based on height and slope
             // Low areas get sand
@@ -581,6 +1020,7 @@ const char *fragmentShaderSource = R"(
             if (slope > 0.3) {
                 finalColor = mix(finalColor, rock, smoothstep(0.3, 0.7, slope));
             }
+#endif
         }
         
         // Lighting calculations
@@ -699,8 +1139,149 @@ void processInput(GLFWwindow *window)
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    // CPU-only benchmarks run without creating a window
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+        return runBenchmarks(argc, argv);
+
+    // "--seed <n>" swaps the sine pattern for seeded simplex fBm terrain
+    HeightRowFunction terrainSource = generateSineHeightRowFast;
+    NoiseSettings noise;
+    bool noiseTerrain = false;
+    bool streamTerrain = false;
+    bool lodTerrain = false;
+    bool compactTerrain = false;
+    bool chunkedTerrain = false;
+    bool clipmapTerrain = false;
+    bool reportCulling = false;
+    bool occlusionCulling = false;
+    bool checkMaterials = false;
+    const char *bakeTexturePath = nullptr;
+    bool bakeCompressed = false;
+    int terrainSize = 100;
+    const char *heightmapPath = nullptr;
+    const char *exportHeightmapPath = nullptr;
+    bool quantizeHeightmap = false;
+    bool useMeshCache = true;
+    bool reportUploads = false;
+    bool reportGLCalls = false;
+    UploadManagerSettings uploadSettings;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            noise.seed = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+            materialTextureSeed = noise.seed;
+            terrainSource = TerrainNoise(noise).rowFunction();
+            noiseTerrain = true;
+        }
+        // "--stream" pages an endless chunked world around the vehicle instead of the fixed grid
+        if (strcmp(argv[i], "--stream") == 0)
+            streamTerrain = true;
+        // "--lod" draws the terrain through the CDLOD quadtree; "--size <n>" sets the map size
+        if (strcmp(argv[i], "--lod") == 0)
+            lodTerrain = true;
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            terrainSize = std::max(2, atoi(argv[i + 1]));
+        // "--texture-size <n>" sets the side of the synthesized material textures
+        if (strcmp(argv[i], "--texture-size") == 0 && i + 1 < argc)
+            materialTextureSize = std::clamp(atoi(argv[i + 1]), 1, 16384);
+        // "--compact" draws the terrain from 4-byte quantized vertices rebuilt in the vertex shader
+        if (strcmp(argv[i], "--compact") == 0)
+            compactTerrain = true;
+        // "--chunked" draws the terrain as 16-bit strip chunks sharing one index buffer
+        if (strcmp(argv[i], "--chunked") == 0)
+            chunkedTerrain = true;
+        // "--clipmap" draws an endless world as nested grids around the camera, fed by a toroidal
+        // height texture
+        if (strcmp(argv[i], "--clipmap") == 0)
+            clipmapTerrain = true;
+        // "--cull-stats" prints the terrain chunks tested, visible and culled once a second
+        if (strcmp(argv[i], "--cull-stats") == 0)
+            reportCulling = true;
+        // "--occlusion" also skips terrain chunks and the car when hills hide them, using a small
+        // CPU depth buffer of the terrain
+        if (strcmp(argv[i], "--occlusion") == 0)
+            occlusionCulling = true;
+        // "--check-materials" reads the material texture array back and compares each layer with
+        // its material synthesized on its own
+        if (strcmp(argv[i], "--check-materials") == 0)
+            checkMaterials = true;
+        // "--textures <file>" loads baked material layers and mips; "--bake-textures <file>" bakes
+        // them at --texture-size and --seed with "--mip-filter box|kaiser" (default kaiser) and exits
+        if (strcmp(argv[i], "--textures") == 0 && i + 1 < argc)
+            bakedTexturePath = argv[i + 1];
+        if (strcmp(argv[i], "--bake-textures") == 0 && i + 1 < argc)
+            bakeTexturePath = argv[i + 1];
+        if (strcmp(argv[i], "--mip-filter") == 0 && i + 1 < argc)
+            materialMipFilter = strcmp(argv[i + 1], "box") == 0 ? MipFilter::Box : MipFilter::Kaiser;
+        // "--compress" stores baked textures as BC1; "--no-texture-compression" uploads the
+        // material array uncompressed even when the driver supports S3TC
+        if (strcmp(argv[i], "--compress") == 0)
+            bakeCompressed = true;
+        if (strcmp(argv[i], "--no-texture-compression") == 0)
+            compressMaterialTextures = false;
+        // "--heightmap <file>" maps a baked heightmap instead of generating one; "--export-heightmap
+        // <file>" bakes the current generator at --size (add "--quantize" for 16-bit tiles) and exits
+        if (strcmp(argv[i], "--heightmap") == 0 && i + 1 < argc)
+            heightmapPath = argv[i + 1];
+        if (strcmp(argv[i], "--export-heightmap") == 0 && i + 1 < argc)
+            exportHeightmapPath = argv[i + 1];
+        if (strcmp(argv[i], "--quantize") == 0)
+            quantizeHeightmap = true;
+        // "--no-mesh-cache" always rebuilds the generated terrain mesh instead of loading it from disk
+        if (strcmp(argv[i], "--no-mesh-cache") == 0)
+            useMeshCache = false;
+        // "--upload-budget <KB>" caps the bytes the upload ring copies per frame; "--upload-stats"
+        // prints its queue depth and bytes per frame once a second
+        if (strcmp(argv[i], "--upload-budget") == 0 && i + 1 < argc)
+            uploadSettings.frameBudget = (size_t)std::max(64, atoi(argv[i + 1])) << 10;
+        if (strcmp(argv[i], "--upload-stats") == 0)
+            reportUploads = true;
+        // "--gl-calls" counts the GL calls of each frame and prints the average once a second
+        if (strcmp(argv[i], "--gl-calls") == 0)
+            reportGLCalls = true;
+    }
+
+    if (exportHeightmapPath)
+    {
+        auto start = std::chrono::steady_clock::now();
+        HeightmapEncoding encoding = quantizeHeightmap ? HeightmapEncoding::Quantized16 : HeightmapEncoding::Float32;
+        if (!writeHeightmapFile(exportHeightmapPath, terrainSource, terrainSize, terrainSize, encoding, 256,
+                                &ThreadPool::shared()))
+            return -1;
+
+        std::cout << "Wrote " << terrainSize << "x" << terrainSize << " heightmap to " << exportHeightmapPath << " in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+        return 0;
+    }
+
+    if (bakeTexturePath)
+    {
+        auto start = std::chrono::steady_clock::now();
+        MipChain chain;
+        chain.width = chain.height = materialTextureSize;
+        chain.layers = TerrainMaterialCount;
+        chain.channels = 3;
+        chain.levels.resize(1);
+        chain.levels[0].resize(chain.levelLayerBytes(0) * chain.layers);
+        synthesizeMaterialLayers(materialTextureSize, materialTextureSize, materialTextureSeed, chain.levels[0].data(),
+                                 &ThreadPool::shared());
+        buildMipChain(chain, materialMipFilter, &ThreadPool::shared());
+        TextureCompression compression = bakeCompressed ? TextureCompression::BC1 : TextureCompression::None;
+        if (!writeTextureFile(bakeTexturePath, chain, materialMipFilter, compression, &ThreadPool::shared()))
+            return -1;
+
+        std::cout << "Baked " << TerrainMaterialCount << " material layers of " << materialTextureSize << "x"
+                  << materialTextureSize << " (" << chain.levels.size() << " levels, "
+                  << mipFilterName(materialMipFilter) << " mips" << (bakeCompressed ? ", BC1" : "") << ") to "
+                  << bakeTexturePath << " in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s"
+                  << std::endl;
+        return 0;
+    }
+
     // Initialize GLFW
     if (!glfwInit())
     {
@@ -749,6 +1330,12 @@ int main()
         glfwTerminate();
         return -1;
     }
+    if (reportGLCalls)
+        installGLCallCounters();
+
+    // Meshes and textures are written into staging buffers by loader threads and copied from there
+    std::unique_ptr<UploadManager> uploadManager = std::make_unique<UploadManager>(uploadSettings);
+    uploads = uploadManager.get();
 
     // Set initial viewport
     glViewport(0, 0, 800, 600);
@@ -756,55 +1343,22 @@ int main()
     // Enable depth testing
     glEnable(GL_DEPTH_TEST);
 
-    // Build and compile our shader program
-    // Vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Check for vertex shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
-    }
-
-    // Fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Check for fragment shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
-    }
-
-    // Link shaders
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // Check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                  << infoLog << std::endl;
-    }
-
-    // Delete shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Build and compile our shader program. The fixed map reads its material weights from a
+    // baked splat map; endless worlds have nothing to bake and keep the procedural blend.
+    bool endlessTerrain = streamTerrain || clipmapTerrain;
+    bool bakedMaterials = !endlessTerrain;
+    // Camera, lighting and per-object values come from the shared uniform blocks, written once a
+    // frame into a ring of buffer ranges; every terrain program declares and binds the same blocks.
+    std::string sceneVertexSource = addSharedUniformBlocks(vertexShaderSource);
+    std::string sceneFragmentSource = addSharedUniformBlocks(fragmentShaderSource);
+    std::string bakedFragmentShaderSource = addShaderDefine(sceneFragmentSource.c_str(), "BAKED_SPLAT");
+    const char *terrainFragmentSource =
+        bakedMaterials ? bakedFragmentShaderSource.c_str() : sceneFragmentSource.c_str();
+    ShaderProgram shaderProgram(sceneVertexSource.c_str(), terrainFragmentSource);
+    shaderProgram.setSampler("materials", 0);
+    shaderProgram.setSampler("splatMap", 5);
+    bindSharedUniformBlocks(shaderProgram);
+    std::unique_ptr<UniformBufferRing> uniformRing = std::make_unique<UniformBufferRing>();
 
     // Set up vertex data (and buffer(s)) and configure vertex attributes
     float vertices[] = {
@@ -837,15 +1391,180 @@ int main()
     // accidentally modifying this VAO, but this rarely happens.
     glBindVertexArray(0);
 
-    // Create terrain
-    Terrain terrain(100, 100);
+    // Create terrain: mapped from a baked heightmap, loaded from the mesh cache, or generated.
+    // Endless worlds only need its materials.
+    auto terrainStart = std::chrono::steady_clock::now();
+    HeightmapFile heightmap;
+    if (endlessTerrain)
+        heightmapPath = nullptr;
+    if (heightmapPath && !heightmap.open(heightmapPath, &ThreadPool::shared()))
+        heightmapPath = nullptr;
+
+    // Generated meshes are cached on disk under a hash of everything that shapes them
+    TerrainMeshCache meshCache;
+    uint64_t meshCacheKey = terrainMeshCacheKey(noiseTerrain ? &noise : nullptr, terrainSize, terrainSize);
+    std::string meshCachePath = terrainMeshCachePath("terrain_cache", meshCacheKey);
+    bool useFixedMeshCache = !endlessTerrain && !heightmapPath && useMeshCache;
+    bool meshCacheHit = useFixedMeshCache && meshCache.open(meshCachePath, meshCacheKey, 8);
+
+    Terrain terrain = endlessTerrain ? Terrain()
+                      : heightmapPath ? Terrain(heightmap)
+                      : meshCacheHit  ? Terrain(meshCache)
+                                      : Terrain(terrainSize, terrainSize, terrainSource);
+    uploads->flush();
+
+    if (!endlessTerrain)
+    {
+        const char *terrainOrigin = meshCacheHit ? "warm: mesh cache hit"
+                                    : !heightmapPath ? "cold: generated"
+                                    : heightmap.isZeroCopy() ? "mapped heightmap, zero-copy"
+                                                             : "mapped heightmap, decoded";
+        std::cout << "Terrain " << terrain.width << "x" << terrain.height << " ready in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - terrainStart).count()
+                  << " ms (" << terrainOrigin << "; " << uploads->getStats().frameBytes << " bytes uploaded in "
+                  << uploads->getStats().frameCopies << " copies through the staging ring)" << std::endl;
+    }
+
+    if (useFixedMeshCache && !meshCacheHit &&
+        writeTerrainMeshCache(meshCachePath, meshCacheKey, terrain.width, terrain.height, terrain.heightData,
+                              terrain.vertexData, 8, terrain.indexData, terrain.indexCount))
+        std::cout << "Terrain mesh cached to " << meshCachePath << std::endl;
+
+    if (checkMaterials)
+        std::cout << "Material array check: "
+                  << (checkMaterialArray(terrain.materialArray, terrain.materialCompressed) ? "every layer matches"
+                                                                                              : "MISMATCH")
+                  << std::endl;
+
+    if (bakedMaterials)
+    {
+        auto bakeStart = std::chrono::steady_clock::now();
+        terrain.bakeMaterials();
+        std::cout << "Terrain materials: " << terrain.width << "x" << terrain.height << " splat map ("
+                  << terrain.splatWeights.size() << " bytes) baked in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count()
+                  << " ms; blend per fragment (hand-counted estimate) " << BakedSplatCost.aluOps << " ALU ops, "
+                  << BakedSplatCost.textureFetches << " fetches, " << BakedSplatCost.branches
+                  << " branches (procedural: " << ProceduralSplatCost.aluOps << " ALU ops, "
+                  << ProceduralSplatCost.textureFetches << " fetches, " << ProceduralSplatCost.branches << " branches)"
+                  << std::endl;
+    }
+
+    // Report the full-float vertex layout next to the compact alternatives
+    if (!endlessTerrain)
+        CompactTerrainMesh::printMemoryReport((size_t)terrain.width * terrain.height);
+
+    // The fixed-grid renderers need the fixed grid, which endless worlds don't build
+    if (endlessTerrain)
+        lodTerrain = compactTerrain = chunkedTerrain = false;
+
+    // The alternative meshes carry the same normals as the float mesh
+    std::vector<glm::vec3> normals;
+    if (compactTerrain || chunkedTerrain)
+    {
+        normals.resize((size_t)terrain.width * terrain.height);
+        for (size_t i = 0; i < normals.size(); i++)
+            normals[i] = glm::make_vec3(&terrain.vertexData[i * 8 + 3]);
+    }
+
+    std::unique_ptr<CompactTerrainMesh> compactMesh;
+    if (compactTerrain)
+    {
+        compactMesh = std::make_unique<CompactTerrainMesh>(terrain.heightData, terrain.width, terrain.height,
+                                                           normals.data(), terrain.EBO, terrain.indexCount,
+                                                           terrainFragmentSource);
+    }
+
+    std::unique_ptr<TerrainChunkedMesh> chunkedMesh;
+    if (chunkedTerrain)
+    {
+        chunkedMesh = std::make_unique<TerrainChunkedMesh>(terrain.heightData, terrain.width, terrain.height,
+                                                           normals.data());
+        std::cout << "Terrain indices: " << chunkedMesh->getChunks().size() << " chunks share "
+                  << chunkedMesh->indexBufferBytes() << " bytes of 16-bit strips (triangle list: "
+                  << terrain.indexCount * sizeof(unsigned int) << " bytes)" << std::endl;
+    }
+
+    std::unique_ptr<TerrainLodRenderer> lodRenderer;
+    if (lodTerrain)
+        lodRenderer = std::make_unique<TerrainLodRenderer>(terrain.heightData, terrain.width, terrain.height,
+                                                           terrainFragmentSource);
+
+    std::unique_ptr<TerrainStreamer> streamer;
+    if (streamTerrain)
+        streamer = std::make_unique<TerrainStreamer>(terrainSource, TerrainStreamer::Settings());
+
+    std::unique_ptr<TerrainClipmapRenderer> clipmapRenderer;
+    if (clipmapTerrain && !streamer)
+    {
+        HeightStridedRowFunction stridedSource = noiseTerrain ? TerrainNoise(noise).stridedRowFunction() : nullptr;
+        clipmapRenderer = std::make_unique<TerrainClipmapRenderer>(terrainSource, sceneFragmentSource.c_str(),
+                                                                   TerrainClipmapSettings(), stridedSource);
+        const TerrainClipmap &clipmap = clipmapRenderer->getClipmap();
+        int reach = clipmap.getGridSize() << (clipmap.getLevelCount() - 1);
+        std::cout << "Terrain clipmap: " << clipmap.getLevelCount() << " levels of " << clipmap.getGridSize()
+                  << " quads reaching " << reach << " cells across, " << clipmapRenderer->meshBytes()
+                  << " bytes of mesh and " << clipmapRenderer->textureBytes() << " bytes of height texture (a static mesh"
+                  << " that size: " << (size_t)(reach + 1) * (reach + 1) * 8 * sizeof(float) << " bytes of vertices)"
+                  << std::endl;
+    }
+
+    auto groundHeight = [&](float x, float z)
+    {
+        return streamer          ? streamer->getHeight(x, z)
+               : clipmapRenderer ? clipmapRenderer->getClipmap().getHeight(x, z)
+                                 : terrain.getHeight(x, z);
+    };
 
-    // Create vehicle
+    // Create vehicle, then finish the uploads queued since the terrain (splat map and car mesh)
+    // before the first frame draws them
     Vehicle vehicle;
+    uploads->flush();
 
     // Global vehicle pointer
     globalVehicle = &vehicle;
 
+    // Runtime edits only apply to the fixed float mesh: C blasts a crater under the car and R
+    // toggles tyre ruts. Uploaded bytes are summed and reported once a second.
+    bool editableTerrain = !streamer && !clipmapRenderer && !lodRenderer && !compactMesh && !chunkedMesh;
+    bool craterKeyWasDown = false, rutKeyWasDown = false, leaveRuts = false;
+    glm::vec3 lastRutPosition = vehicle.position;
+    size_t editBytes = 0, maxFrameEditBytes = 0;
+    int editFrames = 0;
+    float lastEditReport = 0.0f;
+
+    // The fixed and chunked meshes only draw the chunks inside the view frustum
+    bool culledTerrain = !streamer && !clipmapRenderer && !lodRenderer && !compactMesh;
+    TerrainCullStats cullStats;
+    float lastCullReport = 0.0f;
+
+    // Upload ring activity, reported once a second
+    size_t uploadBytes = 0, maxFrameUploadBytes = 0, maxQueuedUploadBytes = 0;
+    int uploadFrames = 0, budgetLimitedFrames = 0;
+    float lastUploadReport = 0.0f;
+
+    // GL calls per frame (with --gl-calls), averaged and reported once a second
+    std::vector<GLCallCount> glCalls;
+    int glCallFrames = 0;
+    float lastGLCallReport = 0.0f;
+
+    // Height bytes the clipmap uploads as the camera moves, reported once a second
+    size_t clipmapBytes = 0, maxFrameClipmapBytes = 0;
+    int clipmapFrames = 0;
+    float lastClipmapReport = 0.0f;
+
+    // Occluders are the terrain pyramid's level-2 nodes (4x4 cells), rasterized on the CPU each frame
+    std::unique_ptr<OcclusionBuffer> occlusion;
+    if (occlusionCulling && culledTerrain)
+        occlusion = std::make_unique<OcclusionBuffer>();
+    std::vector<glm::vec3> occluderVertices;
+    std::vector<unsigned int> occluderIndices;
+    bool vehicleOccluded = false;
+
+    // Startup calls aren't part of any frame
+    if (reportGLCalls)
+        takeGLCallCounts();
+
     // Render loop
     while (!glfwWindowShouldClose(window))
     {
@@ -854,11 +1573,97 @@ int main()
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        // Copy whatever the loaders have staged since the last frame, within the frame budget
+        uploads->update();
+        const UploadStats &uploadStats = uploads->getStats();
+        uploadBytes += uploadStats.frameBytes;
+        maxFrameUploadBytes = std::max(maxFrameUploadBytes, uploadStats.frameBytes);
+        maxQueuedUploadBytes = std::max(maxQueuedUploadBytes, uploadStats.queuedBytes + uploadStats.stagedBytes);
+        budgetLimitedFrames += uploadStats.budgetLimited;
+        uploadFrames++;
+        if (reportUploads && currentFrame - lastUploadReport >= 1.0f)
+        {
+            std::cout << "Uploads: " << uploadBytes / uploadFrames << " bytes/frame avg, " << maxFrameUploadBytes
+                      << " max (budget " << uploads->getSettings().frameBudget << "), " << uploadStats.queuedPieces
+                      << " pieces queued, up to " << maxQueuedUploadBytes << " bytes waiting, "
+                      << uploadStats.segmentsInFlight << " staging buffers in flight, " << budgetLimitedFrames
+                      << " budget-limited frames, " << uploadStats.totalBytes << " bytes total" << std::endl;
+            uploadBytes = maxFrameUploadBytes = maxQueuedUploadBytes = 0;
+            uploadFrames = budgetLimitedFrames = 0;
+            lastUploadReport = currentFrame;
+        }
+
         // Input
+        glm::vec3 previousCameraPosition = camera.Position;
         processInput(window);
 
+        // Stop the free camera short of the ground instead of letting it fly through
+        if (!streamer && !clipmapRenderer)
+        {
+            const float cameraClearance = 0.5f;
+            glm::vec3 motion = camera.Position - previousCameraPosition;
+            float distance = glm::length(motion);
+            TerrainRayHit hit;
+            if (distance > 0.0f &&
+                terrain.raycast(previousCameraPosition, motion / distance, distance + cameraClearance, hit))
+                camera.Position = previousCameraPosition + motion / distance * std::max(hit.distance - cameraClearance, 0.0f);
+        }
+
         // Update vehicle
-        vehicle.update(deltaTime, terrain);
+        vehicle.update(deltaTime, groundHeight);
+
+        if (editableTerrain)
+        {
+            bool craterKey = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+            if (craterKey && !craterKeyWasDown)
+                terrain.deformCrater(vehicle.position.x, vehicle.position.z, 4.0f, 1.5f);
+            craterKeyWasDown = craterKey;
+
+            bool rutKey = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+            if (rutKey && !rutKeyWasDown)
+                leaveRuts = !leaveRuts;
+            rutKeyWasDown = rutKey;
+
+            // Stamp a short groove under each side of the car every quarter unit travelled
+            if (leaveRuts && glm::distance(vehicle.position, lastRutPosition) > 0.25f)
+            {
+                float angle = glm::radians(vehicle.rotation.y);
+                glm::vec2 side = glm::vec2(cos(angle), -sin(angle)) * (vehicle.width * 0.5f - 0.3f);
+                glm::vec2 from(lastRutPosition.x, lastRutPosition.z), to(vehicle.position.x, vehicle.position.z);
+                terrain.deformRut(from + side, to + side, 0.4f, 0.03f);
+                terrain.deformRut(from - side, to - side, 0.4f, 0.03f);
+                lastRutPosition = vehicle.position;
+            }
+
+            size_t bytes = terrain.flushEdits();
+            if (bytes > 0)
+            {
+                editBytes += bytes;
+                maxFrameEditBytes = std::max(maxFrameEditBytes, bytes);
+                editFrames++;
+            }
+
+            if (editFrames > 0 && currentFrame - lastEditReport >= 1.0f)
+            {
+                std::cout << "Terrain edits: " << editBytes << " bytes uploaded over " << editFrames
+                          << " frame(s), at most " << maxFrameEditBytes << " bytes/frame (full vertex buffer: "
+                          << (size_t)terrain.width * terrain.height * 8 * sizeof(float) << " bytes)" << std::endl;
+                editBytes = maxFrameEditBytes = 0;
+                editFrames = 0;
+                lastEditReport = currentFrame;
+            }
+        }
+
+        // Page terrain chunks around the vehicle; this only polls the background workers
+        if (streamer)
+        {
+            streamer->update(vehicle.position);
+
+            const TerrainStreamingStats &stats = streamer->getFrameStats();
+            if (stats.lateLoads > 0)
+                std::cout << "Terrain streaming: " << stats.lateLoads << " chunk load(s) finished late this frame ("
+                          << stats.missingRequired << " required chunk(s) still missing)" << std::endl;
+        }
 
         // Render
         // Set clear color (dark blue background)
@@ -866,69 +1671,179 @@ int main()
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Activate shader
-        glUseProgram(shaderProgram);
+        shaderProgram.use();
 
         // Create transformations
-        glm::mat4 model = glm::mat4(1.0f);
         glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 800.0f / 600.0f, 0.1f, 100.0f);
+        Frustum viewFrustum = Frustum::fromMatrix(projection * view);
 
-        // Retrieve the matrix uniform locations
-        unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
-        unsigned int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        unsigned int projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-
-        // Pass them to the shaders
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-        // Set lighting uniforms
-        glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), 50.0f, 20.0f, 50.0f);
-        glUniform3f(glGetUniformLocation(shaderProgram, "viewPos"), camera.Position.x, camera.Position.y, camera.Position.z);
-        glUniform3f(glGetUniformLocation(shaderProgram, "lightColor"), 1.0f, 1.0f, 1.0f);
+        if (occlusion)
+        {
+            occlusion->begin(projection * view);
+            occluderVertices.clear();
+            occluderIndices.clear();
+            appendTerrainOccluders(terrain.pyramid, 2, viewFrustum, occluderVertices, occluderIndices);
+            occlusion->addOccluders(occluderVertices.data(), occluderIndices.data(), occluderIndices.size() / 3);
+            occlusion->rasterize(&ThreadPool::shared());
+
+            // The car's box in any rotation fits inside its half-diagonal around the centre
+            glm::vec3 reach(glm::length(glm::vec3(vehicle.width, vehicle.height, vehicle.length)) * 0.5f);
+            vehicleOccluded = !occlusion->isVisible(vehicle.position - reach, vehicle.position + reach);
+        }
 
-        // Bind textures
+        // Write this frame's constants in one go: the camera and light, then one block per object
+        // (the terrain, and the car in red)
+        FrameConstants frameConstants = {};
+        frameConstants.view = view;
+        frameConstants.projection = projection;
+        frameConstants.viewPos = camera.Position;
+        frameConstants.lightPos = glm::vec3(50.0f, 20.0f, 50.0f);
+        frameConstants.lightColor = glm::vec3(1.0f);
+
+        ObjectConstants terrainConstants = {};
+        terrainConstants.model = glm::mat4(1.0f);
+        ObjectConstants vehicleConstants = {};
+        vehicleConstants.model = vehicle.getModelMatrix();
+        vehicleConstants.objectColor = glm::vec3(0.8f, 0.2f, 0.2f);
+
+        uniformRing->beginFrame();
+        size_t frameOffset = uniformRing->write(frameConstants);
+        size_t terrainOffset = uniformRing->write(terrainConstants);
+        size_t vehicleOffset = uniformRing->write(vehicleConstants);
+        uniformRing->unmap();
+
+        // Objects whose constants didn't fit the ring this frame are skipped rather than drawn
+        // with another object's
+        bool frameBound = uniformRing->bind(FrameUniformBinding, frameOffset, sizeof(FrameConstants));
+        bool terrainBound =
+            frameBound && uniformRing->bind(ObjectUniformBinding, terrainOffset, sizeof(ObjectConstants));
+
+        // Bind textures: all materials on unit 0, the splat map on unit 5 (samplers set once at startup)
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, terrain.grassTexture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "grassTexture"), 0);
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, terrain.rockTexture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "rockTexture"), 1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, terrain.materialArray);
 
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, terrain.sandTexture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "sandTexture"), 2);
-
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, terrain.earthTexture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "earthTexture"), 3);
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_2D, terrain.splatTexture);
+        glActiveTexture(GL_TEXTURE0);
 
         // Render terrain
-        terrain.render();
+        if (terrainBound)
+        {
+            if (streamer)
+            {
+                streamer->render();
+            }
+            else if (clipmapRenderer)
+            {
+                clipmapRenderer->render(camera.Position);
+                shaderProgram.use();
+
+                size_t bytes = clipmapRenderer->getClipmap().getStats().uploadBytes;
+                if (bytes > 0)
+                {
+                    clipmapBytes += bytes;
+                    maxFrameClipmapBytes = std::max(maxFrameClipmapBytes, bytes);
+                    clipmapFrames++;
+                }
+                if (clipmapFrames > 0 && currentFrame - lastClipmapReport >= 1.0f)
+                {
+                    std::cout << "Terrain clipmap: " << clipmapBytes << " bytes uploaded over " << clipmapFrames
+                              << " frame(s), at most " << maxFrameClipmapBytes << " bytes/frame (all levels: "
+                              << clipmapRenderer->textureBytes() << " bytes)" << std::endl;
+                    clipmapBytes = maxFrameClipmapBytes = 0;
+                    clipmapFrames = 0;
+                    lastClipmapReport = currentFrame;
+                }
+            }
+            else if (lodRenderer)
+            {
+                lodRenderer->render(view, projection, camera.Position);
+                shaderProgram.use();
+            }
+            else if (compactMesh)
+            {
+                compactMesh->render();
+                shaderProgram.use();
+            }
+            else if (chunkedMesh)
+            {
+                chunkedMesh->render(&viewFrustum, &cullStats, occlusion.get());
+            }
+            else
+            {
+                terrain.render(&viewFrustum, occlusion.get());
+                cullStats = terrain.cullStats;
+            }
+        }
 
-        // Render vehicle with its own model matrix
-        glm::mat4 vehicleModel = vehicle.getModelMatrix();
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(vehicleModel));
+        if (reportCulling && culledTerrain && currentFrame - lastCullReport >= 1.0f)
+        {
+            std::cout << "Terrain culling: " << cullStats.chunksVisible << "/" << cullStats.chunksTested
+                      << " chunks visible (" << cullStats.chunksCulled << " culled, " << cullStats.chunksOccluded
+                      << " occluded) in " << cullStats.drawRanges << " draw range(s), " << cullStats.triangles
+                      << " triangles" << std::endl;
+            if (occlusion)
+                std::cout << "Occlusion: " << occlusion->getTrianglesRasterized() << "/"
+                          << occlusion->getTrianglesSubmitted() << " occluder triangles rasterized, car "
+                          << (vehicleOccluded ? "hidden" : "visible") << std::endl;
+            lastCullReport = currentFrame;
+        }
 
-        // Use a simple color for the vehicle (red)
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.8f, 0.2f, 0.2f);
+        // Render vehicle with its own model matrix and colour
+        if (frameBound && uniformRing->bind(ObjectUniformBinding, vehicleOffset, sizeof(ObjectConstants)) &&
+            !vehicleOccluded)
+            vehicle.render();
 
-        vehicle.render();
+        // The ring region is reused once the GPU has finished this frame
+        uniformRing->endFrame();
 
-        // Reset objectColor to zero for terrain rendering
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.0f, 0.0f, 0.0f);
+        if (reportGLCalls)
+        {
+            for (const GLCallCount &count : takeGLCallCounts())
+            {
+                auto match = std::find_if(glCalls.begin(), glCalls.end(), [&](const GLCallCount &c)
+                                          { return strcmp(c.name, count.name) == 0; });
+                if (match == glCalls.end())
+                    glCalls.push_back(count);
+                else
+                    match->calls += count.calls;
+            }
+            glCallFrames++;
+            if (currentFrame - lastGLCallReport >= 1.0f)
+            {
+                uint64_t total = 0;
+                for (const GLCallCount &count : glCalls)
+                    total += count.calls;
+                std::cout << "GL calls/frame: " << (double)total / glCallFrames << " (";
+                for (size_t i = 0; i < glCalls.size(); i++)
+                    std::cout << (i ? ", " : "") << glCalls[i].name << " " << (double)glCalls[i].calls / glCallFrames;
+                std::cout << ")" << std::endl;
+                glCalls.clear();
+                glCallFrames = 0;
+                lastGLCallReport = currentFrame;
+            }
+        }
 
         // Swap buffers and poll IO events
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    // Release streamed chunks and alternative terrain renderers while the GL context is still alive
+    streamer.reset();
+    clipmapRenderer.reset();
+    lodRenderer.reset();
+    compactMesh.reset();
+    chunkedMesh.reset();
+    uploads = nullptr;
+    uploadManager.reset();
+    uniformRing.reset();
+
     // Optional: De-allocate all resources once they've outlived their purpose
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    shaderProgram = ShaderProgram();
 
     // Clean up
     glfwTerminate();
@@ -0,0 +1,119 @@
+#include "mapped_file.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char *path)
+{
+    close();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        std::cerr << "Failed to map empty or unreadable file " << path << std::endl;
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *address = view ? MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!address)
+    {
+        std::cerr << "Failed to map " << path << std::endl;
+        if (view)
+            CloseHandle(view);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = view;
+    mapping = address;
+    length = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mapping)
+        UnmapViewOfFile(mapping);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+
+    mapping = nullptr;
+    mappingHandle = fileHandle = nullptr;
+    length = 0;
+}
+
+#else
+
+bool MappedFile::open(const char *path)
+{
+    close();
+
+    int descriptor = ::open(path, O_RDONLY);
+    if (descriptor < 0)
+    {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+    {
+        std::cerr << "Failed to map empty or unreadable file " << path << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+
+    void *address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps its own reference to the file
+    ::close(descriptor);
+    if (address == MAP_FAILED)
+    {
+        std::cerr << "Failed to map " << path << std::endl;
+        return false;
+    }
+
+    mapping = address;
+    length = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mapping)
+        munmap(mapping, length);
+
+    mapping = nullptr;
+    length = 0;
+}
+
+#endif
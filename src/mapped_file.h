@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file (mmap on POSIX, a file mapping view on Windows).
+// Pages are faulted in on first access, so opening is cheap regardless of file size.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Maps path, replacing any previous mapping. Returns false (and prints why) on failure.
+    bool open(const char *path);
+    void close();
+
+    bool isOpen() const { return mapping != nullptr; }
+    const unsigned char *data() const { return static_cast<const unsigned char *>(mapping); }
+    size_t size() const { return length; }
+
+private:
+    void *mapping = nullptr;
+    size_t length = 0;
+
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,240 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // Forsyth's tuning constants
+    constexpr int ModelCacheSize = 32;
+    constexpr float CacheDecayPower = 1.5f;
+    constexpr float LastTriangleScore = 0.75f;
+    constexpr float ValenceBoostScale = 2.0f;
+    constexpr float ValenceBoostPower = 0.5f;
+    constexpr unsigned int MaxValence = 32;
+
+    struct ScoreTables
+    {
+        float cache[ModelCacheSize];
+        float valence[MaxValence + 1];
+
+        ScoreTables()
+        {
+            for (int i = 0; i < ModelCacheSize; i++)
+            {
+                // The last triangle's vertices get a fixed score so the next triangle doesn't
+                // simply reuse the same edge over and over
+                if (i < 3)
+                    cache[i] = LastTriangleScore;
+                else
+                    cache[i] = std::pow(1.0f - (float)(i - 3) / (ModelCacheSize - 3), CacheDecayPower);
+            }
+
+            valence[0] = 0.0f;
+            for (unsigned int i = 1; i <= MaxValence; i++)
+                valence[i] = ValenceBoostScale * std::pow((float)i, -ValenceBoostPower);
+        }
+    };
+
+    float vertexScore(int cachePosition, unsigned int remainingTriangles)
+    {
+        static const ScoreTables tables;
+
+        // Vertices with nothing left to draw should never attract a triangle
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+        return score + tables.valence[std::min(remainingTriangles, MaxValence)];
+    }
+}
+
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount, int cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3)
+        return stats;
+
+    // A vertex is still cached if fewer than cacheSize misses happened since it was inserted
+    std::vector<unsigned int> insertedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int time = cacheSize + 1;
+    size_t uniqueVertices = 0;
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unsigned int vertex = indices[i];
+        if (time - insertedAt[vertex] > (unsigned int)cacheSize)
+        {
+            insertedAt[vertex] = time++;
+            stats.misses++;
+        }
+
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            uniqueVertices++;
+        }
+    }
+
+    stats.acmr = (float)stats.misses / (indexCount / 3);
+    stats.atvr = (float)stats.misses / uniqueVertices;
+    return stats;
+}
+
+void optimizeVertexCache(unsigned int *destination, const unsigned int *indices, size_t indexCount)
+{
+    size_t faceCount = indexCount / 3;
+    if (faceCount == 0)
+        return;
+
+    // Work in ids relative to the smallest index so a slice of a big mesh only pays for the
+    // vertices it actually spans
+    auto range = std::minmax_element(indices, indices + faceCount * 3);
+    unsigned int firstVertex = *range.first;
+    size_t vertexCount = (size_t)(*range.second - firstVertex) + 1;
+
+    std::vector<unsigned int> source(faceCount * 3);
+    for (size_t i = 0; i < source.size(); i++)
+        source[i] = indices[i] - firstVertex;
+
+    // Triangles around each vertex; the first remaining[v] entries of a list are still undrawn
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int vertex : source)
+        remaining[vertex]++;
+
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(source.size());
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < source.size(); i++)
+        adjacency[fill[source[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScores(faceCount);
+    for (size_t f = 0; f < faceCount; f++)
+        triangleScores[f] = vertexScores[source[f * 3]] + vertexScores[source[f * 3 + 1]] + vertexScores[source[f * 3 + 2]];
+
+    std::vector<unsigned char> emitted(faceCount, 0);
+    unsigned int cache[ModelCacheSize + 3];
+    int cacheCount = 0;
+
+    size_t inputCursor = 0;
+    long long best = -1;
+
+    for (size_t out = 0; out < faceCount; out++)
+    {
+        // Nothing useful around the cache: continue with the next undrawn triangle in input order
+        if (best < 0)
+        {
+            while (emitted[inputCursor])
+                inputCursor++;
+            best = (long long)inputCursor;
+        }
+
+        unsigned int face = (unsigned int)best;
+        const unsigned int *corners = &source[face * 3];
+        for (int k = 0; k < 3; k++)
+            destination[out * 3 + k] = corners[k] + firstVertex;
+        emitted[face] = 1;
+
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int vertex = corners[k];
+            unsigned int *faces = &adjacency[offsets[vertex]];
+            unsigned int *last = faces + remaining[vertex] - 1;
+            std::iter_swap(std::find(faces, last, face), last);
+            remaining[vertex]--;
+        }
+
+        // Move the triangle's vertices to the front of the modelled LRU cache
+        unsigned int newCache[ModelCacheSize + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; k++)
+            newCache[newCount++] = corners[k];
+        for (int i = 0; i < cacheCount; i++)
+        {
+            unsigned int vertex = cache[i];
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                newCache[newCount++] = vertex;
+        }
+
+        // Rescore every vertex whose cache position changed, including those pushed out
+        for (int i = 0; i < newCount; i++)
+        {
+            unsigned int vertex = newCache[i];
+            int position = i < ModelCacheSize ? i : -1;
+
+            float score = vertexScore(position, remaining[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            const unsigned int *faces = &adjacency[offsets[vertex]];
+            for (unsigned int t = 0; t < remaining[vertex]; t++)
+                triangleScores[faces[t]] += delta;
+        }
+
+        cacheCount = std::min(newCount, ModelCacheSize);
+        for (int i = 0; i < cacheCount; i++)
+            cache[i] = newCache[i];
+
+        // The next triangle is the best one touching the cache
+        best = -1;
+        float bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; i++)
+        {
+            unsigned int vertex = cache[i];
+            const unsigned int *faces = &adjacency[offsets[vertex]];
+            for (unsigned int t = 0; t < remaining[vertex]; t++)
+            {
+                if (triangleScores[faces[t]] > bestScore)
+                {
+                    bestScore = triangleScores[faces[t]];
+                    best = faces[t];
+                }
+            }
+        }
+    }
+}
+
+size_t optimizeVertexFetch(void *vertices, unsigned int *indices, size_t indexCount, size_t vertexCount,
+                           size_t vertexSize)
+{
+    const unsigned int Unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, Unused);
+    unsigned int next = 0;
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unsigned int &target = remap[indices[i]];
+        if (target == Unused)
+            target = next++;
+        indices[i] = target;
+    }
+
+    unsigned char *bytes = static_cast<unsigned char *>(vertices);
+    std::vector<unsigned char> original(bytes, bytes + vertexCount * vertexSize);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] != Unused)
+            std::memcpy(bytes + remap[v] * vertexSize, &original[v * vertexSize], vertexSize);
+    }
+
+    return next;
+}
+
+void printVertexCacheReport(const char *name, const VertexCacheStats &before, const VertexCacheStats &after)
+{
+    std::cout << name << " vertex cache (FIFO " << DefaultVertexCacheSize << "): ACMR " << std::fixed
+              << std::setprecision(3) << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> "
+              << after.atvr << std::defaultfloat << std::setprecision(6) << std::endl;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+// Post-transform vertex cache statistics from a simulated FIFO cache.
+//   ACMR: cache misses per triangle (~0.5 is ideal for a large grid, 3.0 is no reuse at all)
+//   ATVR: cache misses per referenced vertex (1.0 means every vertex is transformed once)
+struct VertexCacheStats
+{
+    size_t misses = 0;
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// FIFO size of the simulated cache; small enough to be pessimistic for current hardware
+constexpr int DefaultVertexCacheSize = 16;
+
+// Runs the index buffer through a FIFO vertex cache of cacheSize entries
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount,
+                                    int cacheSize = DefaultVertexCacheSize);
+
+// Reorders triangles for the post-transform cache with Tom Forsyth's linear-speed algorithm:
+// greedily emits the best scoring triangle around the vertices in a modelled LRU cache, where
+// vertices score higher when recently used and when few of their triangles remain. Only the
+// vertex range the indices span is tracked, so slices of a large mesh can be optimized
+// independently. destination may alias indices.
+void optimizeVertexCache(unsigned int *destination, const unsigned int *indices, size_t indexCount);
+
+// Reorders vertices into the order the index buffer first references them, so vertex fetch walks
+// memory forwards, and remaps the indices to match. Unreferenced vertices are dropped. Returns
+// the new vertex count; vertices must hold vertexCount entries of vertexSize bytes.
+size_t optimizeVertexFetch(void *vertices, unsigned int *indices, size_t indexCount, size_t vertexCount,
+                           size_t vertexSize);
+
+// Prints "<name>: ACMR a -> b, ATVR c -> d" for a before/after pair
+void printVertexCacheReport(const char *name, const VertexCacheStats &before, const VertexCacheStats &after);
@@ -0,0 +1,249 @@
+#include "mip_filter.h"
+
+namespace
+{
+    // Separable 2x kernel: taps source texels per axis, centred between texels 2x and 2x + 1.
+    // Vertical weights sum to 64 so a weighted column of bytes fits in int16 (even with the
+    // Kaiser kernel's negative lobes), horizontal weights sum to 256 and accumulate in int32.
+    struct MipKernel
+    {
+        int taps;
+        int16_t vertical[8];
+        int16_t horizontal[8];
+    };
+
+    constexpr int MipShift = 14; // log2(64 * 256)
+
+    constexpr MipKernel BoxKernel = {2, {32, 32}, {128, 128}};
+
+    // Kaiser window (alpha 4) over a sinc with its first zeros two texels out, 4 texels either
+    // side, normalized and rounded to the weight sums above
+    constexpr MipKernel KaiserKernel = {8, {-1, -3, 7, 29, 29, 7, -3, -1}, {-3, -11, 30, 112, 112, 30, -11, -3}};
+
+    int wrap(int value, int size)
+    {
+        int remainder = value % size;
+        return remainder < 0 ? remainder + size : remainder;
+    }
+
+    // out[i] = sum over k of weights[k] * rows[k][i]
+    void verticalScalar(const uint8_t *const *rows, const int16_t *weights, int taps, int count, int16_t *out)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int sum = 0;
+            for (int k = 0; k < taps; k++)
+                sum += weights[k] * rows[k][i];
+            out[i] = (int16_t)sum;
+        }
+    }
+
+    // out[x] = sum over k of weights[k] * padded[2x + k]
+    void horizontalScalar(const int16_t *padded, const int16_t *weights, int taps, int count, int32_t *out)
+    {
+        for (int x = 0; x < count; x++)
+        {
+            int32_t sum = 0;
+            for (int k = 0; k < taps; k++)
+                sum += weights[k] * padded[2 * x + k];
+            out[x] = sum;
+        }
+    }
+
+#if RACING_SIMD_X86
+    // Multiplier for _mm_madd_epi16 against a pair of neighbouring texels
+    int32_t weightPair(const int16_t *weights, int m)
+    {
+        return (int32_t)((uint32_t)(uint16_t)weights[2 * m] | ((uint32_t)(uint16_t)weights[2 * m + 1] << 16));
+    }
+
+    void verticalSSE2(const uint8_t *const *rows, const int16_t *weights, int taps, int count, int16_t *out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i low = zero, high = zero;
+            for (int k = 0; k < taps; k++)
+            {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + i));
+                __m128i weight = _mm_set1_epi16(weights[k]);
+                low = _mm_add_epi16(low, _mm_mullo_epi16(_mm_unpacklo_epi8(bytes, zero), weight));
+                high = _mm_add_epi16(high, _mm_mullo_epi16(_mm_unpackhi_epi8(bytes, zero), weight));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), high);
+        }
+
+        const uint8_t *tails[8];
+        for (int k = 0; k < taps; k++)
+            tails[k] = rows[k] + i;
+        verticalScalar(tails, weights, taps, count - i, out + i);
+    }
+
+    // Each 32-bit lane pairs texels 2x + 2m and 2x + 2m + 1, so one madd per tap pair covers four
+    // outputs
+    void horizontalSSE2(const int16_t *padded, const int16_t *weights, int taps, int count, int32_t *out)
+    {
+        int x = 0;
+        for (; x + 4 <= count; x += 4)
+        {
+            __m128i sum = _mm_setzero_si128();
+            for (int m = 0; m < taps / 2; m++)
+            {
+                __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(padded + 2 * x + 2 * m));
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(texels, _mm_set1_epi32(weightPair(weights, m))));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), sum);
+        }
+        horizontalScalar(padded + 2 * x, weights, taps, count - x, out + x);
+    }
+
+    RACING_TARGET_AVX2 void verticalAVX2(const uint8_t *const *rows, const int16_t *weights, int taps, int count,
+                                         int16_t *out)
+    {
+        int i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            __m256i sum = _mm256_setzero_si256();
+            for (int k = 0; k < taps; k++)
+            {
+                __m256i texels =
+                    _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + i)));
+                sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(texels, _mm256_set1_epi16(weights[k])));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), sum);
+        }
+
+        const uint8_t *tails[8];
+        for (int k = 0; k < taps; k++)
+            tails[k] = rows[k] + i;
+        verticalScalar(tails, weights, taps, count - i, out + i);
+    }
+
+    RACING_TARGET_AVX2 void horizontalAVX2(const int16_t *padded, const int16_t *weights, int taps, int count,
+                                           int32_t *out)
+    {
+        int x = 0;
+        for (; x + 8 <= count; x += 8)
+        {
+            __m256i sum = _mm256_setzero_si256();
+            for (int m = 0; m < taps / 2; m++)
+            {
+                __m256i texels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(padded + 2 * x + 2 * m));
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(texels, _mm256_set1_epi32(weightPair(weights, m))));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), sum);
+        }
+        horizontalSSE2(padded + 2 * x, weights, taps, count - x, out + x);
+    }
+#endif
+
+    void verticalRow(const uint8_t *const *rows, const int16_t *weights, int taps, int count, int16_t *out,
+                     SimdLevel level)
+    {
+#if RACING_SIMD_X86
+        if (level == SimdLevel::AVX2)
+            return verticalAVX2(rows, weights, taps, count, out);
+        if (level == SimdLevel::SSE2)
+            return verticalSSE2(rows, weights, taps, count, out);
+#endif
+        verticalScalar(rows, weights, taps, count, out);
+    }
+
+    void horizontalRow(const int16_t *padded, const int16_t *weights, int taps, int count, int32_t *out,
+                       SimdLevel level)
+    {
+#if RACING_SIMD_X86
+        if (level == SimdLevel::AVX2)
+            return horizontalAVX2(padded, weights, taps, count, out);
+        if (level == SimdLevel::SSE2)
+            return horizontalSSE2(padded, weights, taps, count, out);
+#endif
+        horizontalScalar(padded, weights, taps, count, out);
+    }
+}
+
+const char *mipFilterName(MipFilter filter)
+{
+    return filter == MipFilter::Kaiser ? "kaiser" : "box";
+}
+
+int mipLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+void downsampleMip(const uint8_t *source, int width, int height, int channels, MipFilter filter, uint8_t *destination,
+                   ThreadPool *pool, SimdLevel level)
+{
+    if (level > detectSimdLevel())
+        level = detectSimdLevel();
+
+    const MipKernel &kernel = filter == MipFilter::Kaiser ? KaiserKernel : BoxKernel;
+    int first = 1 - kernel.taps / 2; // Offset of the first tap from texel 2x
+    int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+    size_t rowBytes = (size_t)width * channels;
+
+    auto rows = [&](int firstRow, int lastRow)
+    {
+        std::vector<int16_t> column(rowBytes);
+        std::vector<int16_t> padded((size_t)2 * outWidth + kernel.taps);
+        std::vector<int32_t> sums(outWidth);
+
+        for (int y = firstRow; y < lastRow; y++)
+        {
+            const uint8_t *taps[8];
+            for (int k = 0; k < kernel.taps; k++)
+                taps[k] = source + (size_t)wrap(2 * y + first + k, height) * rowBytes;
+            verticalRow(taps, kernel.vertical, kernel.taps, (int)rowBytes, column.data(), level);
+
+            uint8_t *out = destination + (size_t)y * outWidth * channels;
+            for (int c = 0; c < channels; c++)
+            {
+                // One channel, wrapped around both ends so every tap reads a real texel
+                int count = (int)padded.size();
+                for (int j = 0; j < count; j++)
+                {
+                    int x = j + first;
+                    if (x < 0 || x >= width)
+                        x = wrap(x, width);
+                    padded[j] = column[(size_t)x * channels + c];
+                }
+                horizontalRow(padded.data(), kernel.horizontal, kernel.taps, outWidth, sums.data(), level);
+
+                for (int x = 0; x < outWidth; x++)
+                {
+                    int value = (sums[x] + (1 << (MipShift - 1))) >> MipShift;
+                    out[(size_t)x * channels + c] = (uint8_t)std::clamp(value, 0, 255);
+                }
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, outHeight, 8, rows);
+    else
+        rows(0, outHeight);
+}
+
+void buildMipChain(MipChain &chain, MipFilter filter, ThreadPool *pool, SimdLevel level)
+{
+    int levels = mipLevelCount(chain.width, chain.height);
+    chain.levels.resize(levels);
+    for (int i = 1; i < levels; i++)
+    {
+        chain.levels[i].resize(chain.levelLayerBytes(i) * chain.layers);
+        for (int layer = 0; layer < chain.layers; layer++)
+            downsampleMip(chain.levels[i - 1].data() + layer * chain.levelLayerBytes(i - 1), chain.levelWidth(i - 1),
+                          chain.levelHeight(i - 1), chain.channels, filter,
+                          chain.levels[i].data() + layer * chain.levelLayerBytes(i), pool, level);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "simd.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU mip chain generation for 8-bit textures.
+//
+// Each level halves the previous one (rounding down, never below 1) with a separable 2x
+// downsampling kernel applied with wrap-around addressing, matching the REPEAT wrap the terrain
+// textures are sampled with. The filters run in fixed-point integer arithmetic, so every SIMD
+// level produces bit-identical output and a chain can be checked byte for byte without a GPU.
+
+enum class MipFilter : uint32_t
+{
+    Box = 0,    // 2x2 average
+    Kaiser = 1, // 8x8 Kaiser-windowed sinc (alpha 4): sharper, rings slightly on hard edges
+};
+
+const char *mipFilterName(MipFilter filter);
+
+// Levels from width x height down to 1x1 inclusive
+int mipLevelCount(int width, int height);
+
+// A layered 8-bit image and its mip chain. levels[i] holds every layer of level i back to back,
+// each layer levelWidth(i) x levelHeight(i) texels of channels bytes.
+struct MipChain
+{
+    int width = 0, height = 0;
+    int layers = 1;
+    int channels = 3;
+    std::vector<std::vector<uint8_t>> levels;
+
+    int levelWidth(int level) const { return std::max(1, width >> level); }
+    int levelHeight(int level) const { return std::max(1, height >> level); }
+    size_t levelLayerBytes(int level) const { return (size_t)levelWidth(level) * levelHeight(level) * channels; }
+};
+
+// Downsamples one width x height layer of channels-byte texels into the next level's
+// max(1, width / 2) x max(1, height / 2). Destination rows are spread over pool when one is given.
+void downsampleMip(const uint8_t *source, int width, int height, int channels, MipFilter filter, uint8_t *destination,
+                   ThreadPool *pool = nullptr, SimdLevel level = detectSimdLevel());
+
+// Fills levels 1 and up of chain from levels[0]
+void buildMipChain(MipChain &chain, MipFilter filter, ThreadPool *pool = nullptr, SimdLevel level = detectSimdLevel());
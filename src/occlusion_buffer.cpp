@@ -0,0 +1,377 @@
+#include "occlusion_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Signed distance to GL's near clip plane (z >= -w); negative is in front of the near plane
+    float nearDistance(const glm::vec4 &clip)
+    {
+        return clip.z + clip.w;
+    }
+
+    // Pixel containing screen coordinate v, clamped first so huge values stay representable
+    int pixelFloor(float v, int size)
+    {
+        return (int)std::floor(std::clamp(v, -1.0f, (float)size));
+    }
+
+    // Rows of one triangle within [x0, x1) x [y0, y1). Every path evaluates the edge and depth
+    // planes at each pixel centre with the same operations, so they agree bit for bit.
+    struct RowSpan
+    {
+        float *depth;
+        int rowStride;
+        int x0, x1, y0, y1;
+    };
+
+    void rasterizeScalar(const RowSpan &span, const float *edgeA, const float *edgeB, const float *edgeC,
+                         float depthX, float depthY, float depthC)
+    {
+        for (int y = span.y0; y < span.y1; y++)
+        {
+            float cy = (float)y + 0.5f;
+            float row0 = edgeB[0] * cy + edgeC[0];
+            float row1 = edgeB[1] * cy + edgeC[1];
+            float row2 = edgeB[2] * cy + edgeC[2];
+            float rowDepth = depthY * cy + depthC;
+            float *out = span.depth + (size_t)y * span.rowStride;
+
+            for (int x = span.x0; x < span.x1; x++)
+            {
+                float cx = (float)x + 0.5f;
+                if (edgeA[0] * cx + row0 >= 0.0f && edgeA[1] * cx + row1 >= 0.0f && edgeA[2] * cx + row2 >= 0.0f)
+                    out[x] = std::max(out[x], depthX * cx + rowDepth);
+            }
+        }
+    }
+
+#if RACING_SIMD_X86
+    // x0 and x1 are multiples of 4
+    void rasterizeSSE2(const RowSpan &span, const float *edgeA, const float *edgeB, const float *edgeC, float depthX,
+                       float depthY, float depthC)
+    {
+        const __m128 a0 = _mm_set1_ps(edgeA[0]), a1 = _mm_set1_ps(edgeA[1]), a2 = _mm_set1_ps(edgeA[2]);
+        const __m128 dx = _mm_set1_ps(depthX);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+        for (int y = span.y0; y < span.y1; y++)
+        {
+            float cy = (float)y + 0.5f;
+            __m128 row0 = _mm_set1_ps(edgeB[0] * cy + edgeC[0]);
+            __m128 row1 = _mm_set1_ps(edgeB[1] * cy + edgeC[1]);
+            __m128 row2 = _mm_set1_ps(edgeB[2] * cy + edgeC[2]);
+            __m128 rowDepth = _mm_set1_ps(depthY * cy + depthC);
+            float *out = span.depth + (size_t)y * span.rowStride;
+
+            for (int x = span.x0; x < span.x1; x += 4)
+            {
+                __m128 cx = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+                __m128 inside = _mm_and_ps(
+                    _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, cx), row0), zero),
+                               _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, cx), row1), zero)),
+                    _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, cx), row2), zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                __m128 current = _mm_loadu_ps(out + x);
+                __m128 nearer = _mm_max_ps(current, _mm_add_ps(_mm_mul_ps(dx, cx), rowDepth));
+                _mm_storeu_ps(out + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+            }
+        }
+    }
+
+    // x0 and x1 are multiples of 8
+    RACING_TARGET_AVX2 void rasterizeAVX2(const RowSpan &span, const float *edgeA, const float *edgeB,
+                                          const float *edgeC, float depthX, float depthY, float depthC)
+    {
+        const __m256 a0 = _mm256_set1_ps(edgeA[0]), a1 = _mm256_set1_ps(edgeA[1]), a2 = _mm256_set1_ps(edgeA[2]);
+        const __m256 dx = _mm256_set1_ps(depthX);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+
+        for (int y = span.y0; y < span.y1; y++)
+        {
+            float cy = (float)y + 0.5f;
+            __m256 row0 = _mm256_set1_ps(edgeB[0] * cy + edgeC[0]);
+            __m256 row1 = _mm256_set1_ps(edgeB[1] * cy + edgeC[1]);
+            __m256 row2 = _mm256_set1_ps(edgeB[2] * cy + edgeC[2]);
+            __m256 rowDepth = _mm256_set1_ps(depthY * cy + depthC);
+            float *out = span.depth + (size_t)y * span.rowStride;
+
+            for (int x = span.x0; x < span.x1; x += 8)
+            {
+                __m256 cx = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+                __m256 inside = _mm256_and_ps(
+                    _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a0, cx), row0), zero, _CMP_GE_OQ),
+                                  _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a1, cx), row1), zero, _CMP_GE_OQ)),
+                    _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a2, cx), row2), zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0)
+                    continue;
+
+                __m256 current = _mm256_loadu_ps(out + x);
+                __m256 nearer = _mm256_max_ps(current, _mm256_add_ps(_mm256_mul_ps(dx, cx), rowDepth));
+                _mm256_storeu_ps(out + x, _mm256_blendv_ps(current, nearer, inside));
+            }
+        }
+    }
+#endif
+}
+
+OcclusionBuffer::OcclusionBuffer(int w, int h)
+    : width((std::max(w, 1) + TileWidth - 1) / TileWidth * TileWidth),
+      height((std::max(h, 1) + TileHeight - 1) / TileHeight * TileHeight),
+      tilesX(width / TileWidth), tilesY(height / TileHeight),
+      bins((size_t)tilesX * tilesY)
+{
+    depthBuffer.resize((size_t)width * height);
+}
+
+void OcclusionBuffer::begin(const glm::mat4 &matrix)
+{
+    viewProjection = matrix;
+    std::fill(depthBuffer.begin(), depthBuffer.end(), 0.0f);
+    triangles.clear();
+    for (std::vector<int> &bin : bins)
+        bin.clear();
+    trianglesSubmitted = 0;
+}
+
+void OcclusionBuffer::addOccluders(const glm::vec3 *vertices, const unsigned int *indices, size_t triangleCount)
+{
+    trianglesSubmitted += triangleCount;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        glm::vec4 clip[3];
+        for (int k = 0; k < 3; k++)
+            clip[k] = viewProjection * glm::vec4(vertices[indices[t * 3 + k]], 1.0f);
+
+        int behind = (nearDistance(clip[0]) < 0.0f) + (nearDistance(clip[1]) < 0.0f) + (nearDistance(clip[2]) < 0.0f);
+        if (behind == 3)
+            continue;
+        if (behind == 0)
+        {
+            setupTriangle(clip);
+            continue;
+        }
+
+        // Clip against the near plane: walk the edges keeping the part beyond it. Geometry
+        // closer than the near plane isn't drawn by GL either, so it mustn't occlude.
+        glm::vec4 polygon[4];
+        int count = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            const glm::vec4 &a = clip[k], &b = clip[(k + 1) % 3];
+            float da = nearDistance(a), db = nearDistance(b);
+            if (da >= 0.0f)
+                polygon[count++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f))
+                polygon[count++] = a + (b - a) * (da / (da - db));
+        }
+        for (int k = 1; k + 1 < count; k++)
+        {
+            glm::vec4 fan[3] = {polygon[0], polygon[k], polygon[k + 1]};
+            setupTriangle(fan);
+        }
+    }
+}
+
+void OcclusionBuffer::setupTriangle(const glm::vec4 *clip)
+{
+    float x[3], y[3], z[3];
+    for (int k = 0; k < 3; k++)
+    {
+        float invW = 1.0f / clip[k].w;
+        x[k] = (clip[k].x * invW * 0.5f + 0.5f) * (float)width;
+        y[k] = (clip[k].y * invW * 0.5f + 0.5f) * (float)height;
+        z[k] = invW;
+    }
+
+    // Back-facing and degenerate triangles hide nothing a front face doesn't
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (!(area > 0.0f))
+        return;
+
+    Triangle triangle;
+    triangle.minX = std::max(0, pixelFloor(std::min({x[0], x[1], x[2]}), width));
+    triangle.minY = std::max(0, pixelFloor(std::min({y[0], y[1], y[2]}), height));
+    triangle.maxX = std::min(width - 1, pixelFloor(std::max({x[0], x[1], x[2]}), width));
+    triangle.maxY = std::min(height - 1, pixelFloor(std::max({y[0], y[1], y[2]}), height));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    // Edge k runs from vertex k to k + 1; the inside of a counter-clockwise triangle is on its left
+    for (int k = 0; k < 3; k++)
+    {
+        int next = (k + 1) % 3;
+        triangle.edgeA[k] = y[k] - y[next];
+        triangle.edgeB[k] = x[next] - x[k];
+        triangle.edgeC[k] = -(triangle.edgeA[k] * x[k] + triangle.edgeB[k] * y[k]);
+    }
+
+    triangle.depthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    triangle.depthY = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+    triangle.depthC = z[0] - triangle.depthX * x[0] - triangle.depthY * y[0];
+
+    int index = (int)triangles.size();
+    triangles.push_back(triangle);
+    for (int ty = triangle.minY / TileHeight; ty <= triangle.maxY / TileHeight; ty++)
+        for (int tx = triangle.minX / TileWidth; tx <= triangle.maxX / TileWidth; tx++)
+            bins[(size_t)ty * tilesX + tx].push_back(index);
+}
+
+void OcclusionBuffer::rasterize(ThreadPool *pool, SimdLevel level)
+{
+    int tileCount = tilesX * tilesY;
+    auto tiles = [&](int first, int last)
+    {
+        for (int tile = first; tile < last; tile++)
+            rasterizeTile(tile, level);
+    };
+
+    if (pool)
+        pool->parallelFor(0, tileCount, 1, tiles);
+    else
+        tiles(0, tileCount);
+}
+
+void OcclusionBuffer::rasterizeTile(int tile, SimdLevel level)
+{
+    int tileX0 = (tile % tilesX) * TileWidth;
+    int tileY0 = (tile / tilesX) * TileHeight;
+    int groupWidth = level >= SimdLevel::AVX2 ? 8 : level >= SimdLevel::SSE2 ? 4 : 1;
+
+    for (int index : bins[tile])
+    {
+        const Triangle &triangle = triangles[index];
+
+        // Round the span out to whole SIMD groups; the edge tests reject the extra pixels
+        RowSpan span;
+        span.depth = depthBuffer.data();
+        span.rowStride = width;
+        span.x0 = std::max(triangle.minX, tileX0) / groupWidth * groupWidth;
+        span.x1 = std::min((triangle.maxX + groupWidth) / groupWidth * groupWidth, tileX0 + TileWidth);
+        span.y0 = std::max(triangle.minY, tileY0);
+        span.y1 = std::min(triangle.maxY + 1, tileY0 + TileHeight);
+
+#if RACING_SIMD_X86
+        if (level >= SimdLevel::AVX2)
+        {
+            rasterizeAVX2(span, triangle.edgeA, triangle.edgeB, triangle.edgeC, triangle.depthX, triangle.depthY,
+                          triangle.depthC);
+            continue;
+        }
+        if (level >= SimdLevel::SSE2)
+        {
+            rasterizeSSE2(span, triangle.edgeA, triangle.edgeB, triangle.edgeC, triangle.depthX, triangle.depthY,
+                          triangle.depthC);
+            continue;
+        }
+#endif
+        rasterizeScalar(span, triangle.edgeA, triangle.edgeB, triangle.edgeC, triangle.depthX, triangle.depthY,
+                        triangle.depthC);
+    }
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const
+{
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    float nearest = 0.0f;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 point((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y,
+                        (corner & 4) ? boxMax.z : boxMin.z);
+        glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+        if (nearDistance(clip) < 0.0f)
+            return true;
+
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW * 0.5f + 0.5f) * (float)width;
+        float y = (clip.y * invW * 0.5f + 0.5f) * (float)height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::max(nearest, invW);
+    }
+
+    // Grow the rectangle by a pixel: occluders are sampled at pixel centres, so an occluder
+    // edge can cover a centre without covering the whole pixel
+    int x0 = std::max(0, pixelFloor(minX, width) - 1), x1 = std::min(width - 1, pixelFloor(maxX, width) + 1);
+    int y0 = std::max(0, pixelFloor(minY, height) - 1), y1 = std::min(height - 1, pixelFloor(maxY, height) + 1);
+    if (x0 > x1 || y0 > y1)
+        return false;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        const float *row = depthBuffer.data() + (size_t)y * width;
+        for (int x = x0; x <= x1; x++)
+        {
+            if (row[x] < nearest)
+                return true;
+        }
+    }
+    return false;
+}
+
+void appendTerrainOccluders(const TerrainHeightPyramid &pyramid, int level, const Frustum &frustum,
+                            std::vector<glm::vec3> &vertices, std::vector<unsigned int> &indices)
+{
+    if (!pyramid.isBuilt())
+        return;
+
+    level = std::clamp(level, 0, pyramid.getLevelCount() - 1);
+    int nodesX = pyramid.getNodesX(level), nodesZ = pyramid.getNodesZ(level);
+    int size = 1 << level;
+
+    // Lowest height of the nodes that share corner (i, j)
+    auto cornerHeight = [&](int i, int j)
+    {
+        float lowest = INFINITY;
+        for (int nj = std::max(j - 1, 0); nj <= std::min(j, nodesZ - 1); nj++)
+            for (int ni = std::max(i - 1, 0); ni <= std::min(i, nodesX - 1); ni++)
+                lowest = std::min(lowest, pyramid.nodeRange(level, ni, nj).x);
+        return lowest;
+    };
+    auto cornerPosition = [&](int i, int j)
+    {
+        return glm::vec3((float)std::min(i * size, pyramid.getWidth() - 1), cornerHeight(i, j),
+                         (float)std::min(j * size, pyramid.getHeight() - 1));
+    };
+
+    // Walk down from the root so whole branches outside the frustum are skipped at once
+    std::vector<glm::ivec3> stack = {glm::ivec3(pyramid.getLevelCount() - 1, 0, 0)};
+    while (!stack.empty())
+    {
+        glm::ivec3 node = stack.back();
+        stack.pop_back();
+        int nodeLevel = node.x, i = node.y, j = node.z;
+        int nodeSize = 1 << nodeLevel;
+
+        glm::vec2 range = pyramid.nodeRange(nodeLevel, i, j);
+        glm::vec3 boxMin((float)(i * nodeSize), range.x, (float)(j * nodeSize));
+        glm::vec3 boxMax((float)std::min((i + 1) * nodeSize, pyramid.getWidth() - 1), range.y,
+                         (float)std::min((j + 1) * nodeSize, pyramid.getHeight() - 1));
+        if (!frustum.intersectsAABB(boxMin, boxMax))
+            continue;
+
+        if (nodeLevel > level)
+        {
+            int childLevel = nodeLevel - 1;
+            for (int cj = 2 * j; cj < std::min(2 * j + 2, pyramid.getNodesZ(childLevel)); cj++)
+                for (int ci = 2 * i; ci < std::min(2 * i + 2, pyramid.getNodesX(childLevel)); ci++)
+                    stack.push_back(glm::ivec3(childLevel, ci, cj));
+            continue;
+        }
+
+        // Counter-clockwise seen from above
+        unsigned int base = (unsigned int)vertices.size();
+        vertices.push_back(cornerPosition(i, j));
+        vertices.push_back(cornerPosition(i, j + 1));
+        vertices.push_back(cornerPosition(i + 1, j));
+        vertices.push_back(cornerPosition(i + 1, j + 1));
+        indices.insert(indices.end(), {base, base + 1, base + 2, base + 2, base + 1, base + 3});
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "frustum.h"
+#include "simd.h"
+#include "terrain_raycast.h"
+#include "thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Low-resolution CPU depth buffer for occlusion culling.
+//
+// Occluder triangles are transformed by the frame's view-projection, clipped against the near
+// plane and binned into screen tiles; tiles are then rasterized in parallel, several pixels at a
+// time with SSE2/AVX2. Depth is stored as 1 / w (larger is nearer), which interpolates linearly
+// across the screen. Bounding boxes are then tested against the result: a box is occluded when
+// every pixel under its (slightly dilated) screen rectangle holds an occluder nearer than the
+// box's nearest corner. Everything is CPU-side, so it runs in benchmarks without a GPU.
+//
+// Occluders must lie inside the real geometry for the test to be conservative; see
+// appendTerrainOccluders. Every SIMD level writes the same depth buffer.
+class OcclusionBuffer
+{
+public:
+    static constexpr int TileWidth = 32;
+    static constexpr int TileHeight = 16;
+
+    // width is rounded up to a multiple of TileWidth and height to a multiple of TileHeight
+    explicit OcclusionBuffer(int width = 256, int height = 192);
+
+    // Starts a frame: clears the depth and drops the previous occluders
+    void begin(const glm::mat4 &viewProjection);
+
+    // Queues triangles (three indices each); nothing is drawn until rasterize. Triangles are
+    // one-sided, counter-clockwise on screen as with GL's default front face.
+    void addOccluders(const glm::vec3 *vertices, const unsigned int *indices, size_t triangleCount);
+
+    // Draws the queued occluders, one tile per task when a pool is given
+    void rasterize(ThreadPool *pool = nullptr, SimdLevel level = detectSimdLevel());
+
+    // False only when the box is certainly hidden behind the rasterized occluders. Boxes that
+    // reach in front of the near plane are always visible.
+    bool isVisible(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Row-major 1 / w per pixel, row 0 at the bottom of the screen; 0 where nothing was drawn
+    const float *depth() const { return depthBuffer.data(); }
+
+    size_t getTrianglesSubmitted() const { return trianglesSubmitted; }
+    size_t getTrianglesRasterized() const { return triangles.size(); }
+
+private:
+    // Screen-space triangle: inside where all three edge functions a x + b y + c are >= 0, with
+    // depth dx x + dy y + dc
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthX, depthY, depthC;
+        int minX, minY, maxX, maxY; // Pixel bounds, inclusive and clamped to the buffer
+    };
+
+    void setupTriangle(const glm::vec4 *clip);
+    void rasterizeTile(int tile, SimdLevel level);
+
+    int width, height;
+    int tilesX, tilesY;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<float> depthBuffer;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<int>> bins; // Triangle indices per tile
+    size_t trianglesSubmitted = 0;
+};
+
+// Appends a coarse, conservative copy of the terrain inside the frustum as occluder triangles.
+// Each quad spans one pyramid node of the given level, and its corners take the lowest height of
+// the nodes around them. The occluder therefore never rises above the real surface, and
+// anything it hides is also hidden by the real terrain.
+void appendTerrainOccluders(const TerrainHeightPyramid &pyramid, int level, const Frustum &frustum,
+                            std::vector<glm::vec3> &vertices, std::vector<unsigned int> &indices);
@@ -0,0 +1,237 @@
+#include "shader_program.h"
+#include "gl_utils.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+template <>
+void Uniform<int>::set(const int &value) const
+{
+    glUniform1i(location, value);
+}
+
+template <>
+void Uniform<float>::set(const float &value) const
+{
+    glUniform1f(location, value);
+}
+
+template <>
+void Uniform<glm::vec2>::set(const glm::vec2 &value) const
+{
+    glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+template <>
+void Uniform<glm::vec3>::set(const glm::vec3 &value) const
+{
+    glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+template <>
+void Uniform<glm::vec4>::set(const glm::vec4 &value) const
+{
+    glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+template <>
+void Uniform<glm::ivec2>::set(const glm::ivec2 &value) const
+{
+    glUniform2iv(location, 1, glm::value_ptr(value));
+}
+
+template <>
+void Uniform<glm::mat4>::set(const glm::mat4 &value) const
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+// glUniform1i also sets bools and samplers
+template <>
+bool ShaderProgram::uniformTypeMatches<int>(unsigned int type)
+{
+    return type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D || type == GL_SAMPLER_2D_ARRAY;
+}
+
+template <>
+bool ShaderProgram::uniformTypeMatches<float>(unsigned int type)
+{
+    return type == GL_FLOAT;
+}
+
+template <>
+bool ShaderProgram::uniformTypeMatches<glm::vec2>(unsigned int type)
+{
+    return type == GL_FLOAT_VEC2;
+}
+
+template <>
+bool ShaderProgram::uniformTypeMatches<glm::vec3>(unsigned int type)
+{
+    return type == GL_FLOAT_VEC3;
+}
+
+template <>
+bool ShaderProgram::uniformTypeMatches<glm::vec4>(unsigned int type)
+{
+    return type == GL_FLOAT_VEC4;
+}
+
+template <>
+bool ShaderProgram::uniformTypeMatches<glm::ivec2>(unsigned int type)
+{
+    return type == GL_INT_VEC2;
+}
+
+template <>
+bool ShaderProgram::uniformTypeMatches<glm::mat4>(unsigned int type)
+{
+    return type == GL_FLOAT_MAT4;
+}
+
+ShaderProgram::ShaderProgram(const char *vertexSource, const char *fragmentSource)
+    : program(compileShaderProgram(vertexSource, fragmentSource))
+{
+    int status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    linked = status != 0;
+    if (linked)
+        reflect();
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    release();
+}
+
+ShaderProgram::ShaderProgram(ShaderProgram &&other) noexcept
+    : program(std::exchange(other.program, 0)), linked(std::exchange(other.linked, false)),
+      uniforms(std::move(other.uniforms)), attributes(std::move(other.attributes)), blocks(std::move(other.blocks))
+{
+}
+
+ShaderProgram &ShaderProgram::operator=(ShaderProgram &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        program = std::exchange(other.program, 0);
+        linked = std::exchange(other.linked, false);
+        uniforms = std::move(other.uniforms);
+        attributes = std::move(other.attributes);
+        blocks = std::move(other.blocks);
+    }
+    return *this;
+}
+
+void ShaderProgram::release()
+{
+    if (program)
+        glDeleteProgram(program);
+    program = 0;
+}
+
+void ShaderProgram::use() const
+{
+    glUseProgram(program);
+}
+
+void ShaderProgram::setSampler(const char *name, int unit) const
+{
+    use();
+    uniform<int>(name).set(unit);
+}
+
+int ShaderProgram::attribute(const char *name) const
+{
+    for (const Variable &variable : attributes)
+        if (variable.name == name)
+            return variable.location;
+    return -1;
+}
+
+const ShaderProgram::Block *ShaderProgram::uniformBlock(const char *name) const
+{
+    for (const Block &block : blocks)
+        if (block.name == name)
+            return &block;
+    return nullptr;
+}
+
+bool ShaderProgram::bindUniformBlock(const char *name, unsigned int binding) const
+{
+    const Block *block = uniformBlock(name);
+    if (!block)
+        return false;
+    glUniformBlockBinding(program, block->index, binding);
+    return true;
+}
+
+int ShaderProgram::findUniform(const char *name, bool (*typeMatches)(unsigned int)) const
+{
+    for (const Variable &variable : uniforms)
+    {
+        if (variable.name != name)
+            continue;
+        if (!typeMatches(variable.type))
+        {
+            std::cerr << "Uniform " << name << " has GL type 0x" << std::hex << variable.type << std::dec
+                      << ", which the handle can't set" << std::endl;
+            return -1;
+        }
+        return variable.location;
+    }
+    return -1;
+}
+
+void ShaderProgram::reflect()
+{
+    char name[256];
+    auto reflectAll = [&](GLenum countQuery, bool uniform, std::vector<Variable> &out)
+    {
+        int count = 0;
+        glGetProgramiv(program, countQuery, &count);
+        out.clear();
+        out.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            if (uniform)
+                glGetActiveUniform(program, i, sizeof(name), &length, &size, &type, name);
+            else
+                glGetActiveAttrib(program, i, sizeof(name), &length, &size, &type, name);
+
+            // Arrays are reported as "name[0]"; the location of element 0 is the array's
+            Variable variable;
+            variable.name.assign(name, length);
+            if (variable.name.size() > 3 && variable.name.compare(variable.name.size() - 3, 3, "[0]") == 0)
+                variable.name.resize(variable.name.size() - 3);
+            variable.type = type;
+            variable.size = size;
+            variable.location = uniform ? glGetUniformLocation(program, name) : glGetAttribLocation(program, name);
+            out.push_back(std::move(variable));
+        }
+    };
+    reflectAll(GL_ACTIVE_UNIFORMS, true, uniforms);
+    reflectAll(GL_ACTIVE_ATTRIBUTES, false, attributes);
+
+    int blockCount = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    blocks.clear();
+    for (int i = 0; i < blockCount; i++)
+    {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program, i, sizeof(name), &length, name);
+        Block block;
+        block.name.assign(name, length);
+        block.index = i;
+        glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+        blocks.push_back(std::move(block));
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Handle to one uniform of a linked program, looked up once. Handles to uniforms the program
+// doesn't use (or that the compiler removed) have location -1 and set nothing, as in GL.
+template <typename T>
+class Uniform
+{
+public:
+    Uniform() = default;
+    explicit Uniform(int location) : location(location) {}
+
+    // Sets the value on the currently bound program
+    void set(const T &value) const;
+
+    bool isActive() const { return location >= 0; }
+    int getLocation() const { return location; }
+
+private:
+    int location = -1;
+};
+
+template <> void Uniform<int>::set(const int &value) const;
+template <> void Uniform<float>::set(const float &value) const;
+template <> void Uniform<glm::vec2>::set(const glm::vec2 &value) const;
+template <> void Uniform<glm::vec3>::set(const glm::vec3 &value) const;
+template <> void Uniform<glm::vec4>::set(const glm::vec4 &value) const;
+template <> void Uniform<glm::ivec2>::set(const glm::ivec2 &value) const;
+template <> void Uniform<glm::mat4>::set(const glm::mat4 &value) const;
+
+// A linked vertex/fragment program with every active uniform and attribute reflected at link
+// time, so drawing code holds typed handles instead of looking names up each frame
+class ShaderProgram
+{
+public:
+    // One active uniform or attribute as reflected (array names without their "[0]")
+    struct Variable
+    {
+        std::string name;
+        unsigned int type; // GL_FLOAT_VEC3, GL_SAMPLER_2D, ...
+        int size;          // Array length, 1 for plain variables
+        int location;      // -1 for uniforms inside a block
+    };
+
+    // One active uniform block
+    struct Block
+    {
+        std::string name;
+        unsigned int index;
+        int dataSize; // Bytes the block's layout occupies
+    };
+
+    ShaderProgram() = default;
+
+    // Compiles and links the pair (errors are printed to std::cerr) and reflects the result
+    ShaderProgram(const char *vertexSource, const char *fragmentSource);
+    ~ShaderProgram();
+
+    ShaderProgram(ShaderProgram &&other) noexcept;
+    ShaderProgram &operator=(ShaderProgram &&other) noexcept;
+    ShaderProgram(const ShaderProgram &) = delete;
+    ShaderProgram &operator=(const ShaderProgram &) = delete;
+
+    bool isLinked() const { return linked; }
+    unsigned int getId() const { return program; }
+    void use() const;
+
+    // Handle to a uniform of type T. Unknown names give an inactive handle; a uniform declared
+    // with a different type is reported and also gives an inactive handle.
+    template <typename T>
+    Uniform<T> uniform(const char *name) const
+    {
+        return Uniform<T>(findUniform(name, uniformTypeMatches<T>));
+    }
+
+    // Binds a sampler uniform to a texture unit (binds the program)
+    void setSampler(const char *name, int unit) const;
+
+    // Attribute location, or -1 when the program has no such active attribute
+    int attribute(const char *name) const;
+
+    // Active uniform block, or null when the program doesn't use one by that name
+    const Block *uniformBlock(const char *name) const;
+
+    // Points the named block at a uniform buffer binding point; false when it isn't active
+    bool bindUniformBlock(const char *name, unsigned int binding) const;
+
+    const std::vector<Variable> &getUniforms() const { return uniforms; }
+    const std::vector<Variable> &getAttributes() const { return attributes; }
+    const std::vector<Block> &getUniformBlocks() const { return blocks; }
+
+private:
+    template <typename T>
+    static bool uniformTypeMatches(unsigned int type);
+
+    int findUniform(const char *name, bool (*typeMatches)(unsigned int)) const;
+    void reflect();
+    void release();
+
+    unsigned int program = 0;
+    bool linked = false;
+    std::vector<Variable> uniforms;
+    std::vector<Variable> attributes;
+    std::vector<Block> blocks;
+};
+
+template <> bool ShaderProgram::uniformTypeMatches<int>(unsigned int type);
+template <> bool ShaderProgram::uniformTypeMatches<float>(unsigned int type);
+template <> bool ShaderProgram::uniformTypeMatches<glm::vec2>(unsigned int type);
+template <> bool ShaderProgram::uniformTypeMatches<glm::vec3>(unsigned int type);
+template <> bool ShaderProgram::uniformTypeMatches<glm::vec4>(unsigned int type);
+template <> bool ShaderProgram::uniformTypeMatches<glm::ivec2>(unsigned int type);
+template <> bool ShaderProgram::uniformTypeMatches<glm::mat4>(unsigned int type);
@@ -0,0 +1,57 @@
+#include "simd.h"
+
+#if RACING_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    SimdLevel queryCpu()
+    {
+#if RACING_SIMD_X86
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] >= 7)
+        {
+            __cpuidex(info, 1, 0);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            __cpuidex(info, 7, 0);
+            bool avx2 = (info[1] & (1 << 5)) != 0;
+
+            // The OS must also save the upper halves of the YMM registers
+            if (osxsave && avx && avx2 && (_xgetbv(0) & 0x6) == 0x6)
+                return SimdLevel::AVX2;
+        }
+        return SimdLevel::SSE2;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+        return SimdLevel::SSE2;
+#endif
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+}
+
+SimdLevel detectSimdLevel()
+{
+    static const SimdLevel level = queryCpu();
+    return level;
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// x86-64 always has SSE2; wider paths are compiled per function and picked at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define RACING_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define RACING_SIMD_X86 0
+#endif
+
+// Lets a single function use AVX2 intrinsics without building the whole file with -mavx2
+#if RACING_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define RACING_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RACING_TARGET_AVX2
+#endif
+
+// Instruction set levels a kernel can be dispatched to, in increasing order
+enum class SimdLevel
+{
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Best level supported by both this build and the running CPU (detected once)
+SimdLevel detectSimdLevel();
+
+const char *simdLevelName(SimdLevel level);
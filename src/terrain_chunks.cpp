@@ -0,0 +1,130 @@
+#include "terrain_chunks.h"
+#include "occlusion_buffer.h"
+#include "terrain_indices.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int FloatsPerVertex = 8;
+}
+
+TerrainChunkedMesh::TerrainChunkedMesh(const float *heights, int width, int height, const glm::vec3 *normals,
+                                       int chunkSize)
+    : chunkSize(std::clamp(chunkSize, 1, MaxStripGridSamples - 1))
+{
+    int samples = this->chunkSize + 1;
+    int chunksX = (width - 2) / this->chunkSize + 1;
+    int chunksZ = (height - 2) / this->chunkSize + 1;
+
+    std::vector<float> vertices;
+    vertices.reserve((size_t)chunksX * chunksZ * samples * samples * FloatsPerVertex);
+
+    for (int cz = 0; cz < chunksZ; cz++)
+    {
+        for (int cx = 0; cx < chunksX; cx++)
+        {
+            Chunk chunk;
+            chunk.x0 = cx * this->chunkSize;
+            chunk.z0 = cz * this->chunkSize;
+            chunk.baseVertex = (int)(vertices.size() / FloatsPerVertex);
+            chunk.boxMin = glm::vec3((float)chunk.x0, INFINITY, (float)chunk.z0);
+            chunk.boxMax = glm::vec3((float)std::min(chunk.x0 + this->chunkSize, width - 1), -INFINITY,
+                                     (float)std::min(chunk.z0 + this->chunkSize, height - 1));
+
+            for (int z = 0; z < samples; z++)
+            {
+                int gridZ = std::min(chunk.z0 + z, height - 1);
+                for (int x = 0; x < samples; x++)
+                {
+                    int gridX = std::min(chunk.x0 + x, width - 1);
+                    size_t sample = (size_t)gridZ * width + gridX;
+                    glm::vec3 normal = normals ? normals[sample] : glm::vec3(0.0f, 1.0f, 0.0f);
+                    chunk.boxMin.y = std::min(chunk.boxMin.y, heights[sample]);
+                    chunk.boxMax.y = std::max(chunk.boxMax.y, heights[sample]);
+
+                    // Same interleaved layout as Terrain::generateMesh
+                    vertices.insert(vertices.end(), {(float)gridX, heights[sample], (float)gridZ,
+                                                     normal.x, normal.y, normal.z,
+                                                     gridX * 0.1f, gridZ * 0.1f});
+                }
+            }
+            chunks.push_back(chunk);
+        }
+    }
+
+    std::vector<uint16_t> strip;
+    buildGridTriangleStrip(samples, samples, strip);
+    indexCount = strip.size();
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, strip.size() * sizeof(uint16_t), strip.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, FloatsPerVertex * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, FloatsPerVertex * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, FloatsPerVertex * sizeof(float), (void *)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+}
+
+TerrainChunkedMesh::~TerrainChunkedMesh()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+void TerrainChunkedMesh::render(const Frustum *frustum, TerrainCullStats *stats, const OcclusionBuffer *occlusion)
+{
+    // Every chunk draws the same strip, so only the base vertex differs between draws
+    drawBaseVertices.clear();
+    TerrainCullStats frameStats;
+    for (const Chunk &chunk : chunks)
+    {
+        frameStats.chunksTested++;
+        if (frustum && !frustum->intersectsAABB(chunk.boxMin, chunk.boxMax))
+        {
+            frameStats.chunksCulled++;
+            continue;
+        }
+        if (occlusion && !occlusion->isVisible(chunk.boxMin, chunk.boxMax))
+        {
+            frameStats.chunksOccluded++;
+            continue;
+        }
+        drawBaseVertices.push_back(chunk.baseVertex);
+    }
+    frameStats.chunksVisible = frameStats.drawRanges = (int)drawBaseVertices.size();
+    frameStats.triangles = (size_t)frameStats.chunksVisible * chunkSize * chunkSize * 2;
+    if (stats)
+        *stats = frameStats;
+
+    drawCounts.assign(drawBaseVertices.size(), (int)indexCount);
+    drawOffsets.assign(drawBaseVertices.size(), nullptr);
+
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(PrimitiveRestartIndex16);
+
+    glBindVertexArray(VAO);
+    if (!drawBaseVertices.empty())
+        glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP, drawCounts.data(), GL_UNSIGNED_SHORT, drawOffsets.data(),
+                                      (GLsizei)drawBaseVertices.size(), drawBaseVertices.data());
+    glBindVertexArray(0);
+
+    glDisable(GL_PRIMITIVE_RESTART);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "frustum.h"
+#include "terrain_culling.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Fixed terrain split into equally sized chunks so every chunk can use the same 16-bit strip
+// index buffer. Chunk vertices are stored back to back in one buffer and the chunks are drawn
+// with one glMultiDrawElementsBaseVertex. Chunks on the far map edge are padded by clamping to the last sample,
+// which only adds zero-area triangles.
+class TerrainChunkedMesh
+{
+public:
+    struct Chunk
+    {
+        int x0, z0;     // First grid sample covered by the chunk
+        int baseVertex; // Offset of the chunk's first vertex in the shared buffer
+        glm::vec3 boxMin, boxMax;
+    };
+
+    // normals may be null for flat (0, 1, 0) normals. chunkSize is in quads and is limited so a
+    // chunk's vertices fit 16-bit indices.
+    TerrainChunkedMesh(const float *heights, int width, int height, const glm::vec3 *normals, int chunkSize = 64);
+    ~TerrainChunkedMesh();
+
+    TerrainChunkedMesh(const TerrainChunkedMesh &) = delete;
+    TerrainChunkedMesh &operator=(const TerrainChunkedMesh &) = delete;
+
+    // Draws every chunk with the currently bound program (same attributes as Terrain::setupMesh).
+    // With a frustum only the chunks whose boxes it touches are drawn, in one multi-draw; an
+    // occlusion buffer also skips the chunks hidden behind it.
+    void render(const Frustum *frustum = nullptr, TerrainCullStats *stats = nullptr,
+                const OcclusionBuffer *occlusion = nullptr);
+
+    const std::vector<Chunk> &getChunks() const { return chunks; }
+    int getChunkSize() const { return chunkSize; }
+    size_t indexBufferBytes() const { return indexCount * sizeof(unsigned short); }
+
+private:
+    int chunkSize;
+    std::vector<Chunk> chunks;
+    size_t indexCount = 0;
+
+    // glMultiDrawElementsBaseVertex arguments, rebuilt every frame
+    std::vector<int> drawCounts;
+    std::vector<const void *> drawOffsets;
+    std::vector<int> drawBaseVertices;
+
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+};
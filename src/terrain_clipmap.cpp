@@ -0,0 +1,166 @@
+#include "terrain_clipmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    int floorDiv(int value, int divisor)
+    {
+        int quotient = value / divisor;
+        if (value % divisor != 0 && value < 0)
+            quotient--;
+        return quotient;
+    }
+
+    int wrap(int value, int size)
+    {
+        int remainder = value % size;
+        return remainder < 0 ? remainder + size : remainder;
+    }
+
+    // Splits [first, first + count) (count <= size) into at most two runs of toroidal texels
+    int splitWrapped(int first, int count, int size, int *starts, int *counts)
+    {
+        int start = wrap(first, size);
+        int head = std::min(count, size - start);
+        starts[0] = start;
+        counts[0] = head;
+        if (head == count)
+            return 1;
+        starts[1] = 0;
+        counts[1] = count - head;
+        return 2;
+    }
+}
+
+TerrainClipmap::TerrainClipmap(HeightRowFunction source, const TerrainClipmapSettings &settings,
+                               HeightStridedRowFunction stridedSource)
+    : source(std::move(source)), stridedSource(std::move(stridedSource)), settings(settings)
+{
+    if (!this->stridedSource)
+        this->stridedSource = stridedRowsFromRowFunction(this->source);
+    this->settings.gridSize = std::clamp(settings.gridSize / 4 * 4, 4, TerrainClipmapMaxGridSize);
+    this->settings.levels = std::clamp(settings.levels, 1, TerrainClipmapMaxLevels);
+
+    int size = getTextureSize();
+    levels.resize(this->settings.levels);
+    for (Level &level : levels)
+        level.heights.assign((size_t)size * size, 0.0f);
+}
+
+glm::ivec2 TerrainClipmap::getHoleOffset(int level) const
+{
+    // The finer origin is even in its own samples, so halving it lands on this level's grid
+    glm::ivec2 finer = levels[level - 1].origin;
+    return glm::ivec2(finer.x / 2, finer.y / 2) - levels[level].origin;
+}
+
+void TerrainClipmap::update(const glm::vec3 &camera)
+{
+    uploads.clear();
+    stats = TerrainClipmapStats();
+
+    int size = getTextureSize();
+    int half = settings.gridSize / 2;
+    int cellX = (int)std::floor(camera.x), cellZ = (int)std::floor(camera.z);
+
+    for (int k = 0; k < settings.levels; k++)
+    {
+        Level &level = levels[k];
+
+        // Snap to even samples so the coarser level's grid runs through this one's
+        glm::ivec2 origin(floorDiv(floorDiv(cellX, 1 << k), 2) * 2 - half,
+                          floorDiv(floorDiv(cellZ, 1 << k), 2) * 2 - half);
+        if (level.filled && origin == level.origin)
+            continue;
+
+        stats.levelsMoved++;
+        glm::ivec2 old = level.origin;
+        level.origin = origin;
+
+        if (!level.filled || std::abs(origin.x - old.x) >= size || std::abs(origin.y - old.y) >= size)
+        {
+            fillRegion(k, origin.x, origin.y, origin.x + size, origin.y + size);
+            level.filled = true;
+            continue;
+        }
+
+        // Columns that entered the window, over its full height
+        if (origin.x > old.x)
+            fillRegion(k, old.x + size, origin.y, origin.x + size, origin.y + size);
+        else if (origin.x < old.x)
+            fillRegion(k, origin.x, origin.y, old.x, origin.y + size);
+
+        // Rows that entered the window, over the columns both windows share
+        int sharedX0 = std::max(origin.x, old.x), sharedX1 = std::min(origin.x, old.x) + size;
+        if (origin.y > old.y)
+            fillRegion(k, sharedX0, old.y + size, sharedX1, origin.y + size);
+        else if (origin.y < old.y)
+            fillRegion(k, sharedX0, origin.y, sharedX1, old.y);
+    }
+}
+
+void TerrainClipmap::fillRegion(int level, int x0, int z0, int x1, int z1)
+{
+    if (x1 <= x0 || z1 <= z0)
+        return;
+
+    int size = getTextureSize();
+    int count = x1 - x0;
+    float *heights = levels[level].heights.data();
+    rowScratch.resize(count);
+
+    for (int z = z0; z < z1; z++)
+    {
+        // Level 0 is one contiguous row; coarser levels skip 2^k - 1 cells between samples
+        if (level == 0)
+            source(x0, z, count, rowScratch.data());
+        else
+            stridedSource(x0 * (1 << level), z * (1 << level), 1 << level, count, rowScratch.data());
+
+        float *row = heights + (size_t)wrap(z, size) * size;
+        for (int i = 0; i < count; i++)
+            row[wrap(x0 + i, size)] = rowScratch[i];
+    }
+
+    int xStarts[2], xCounts[2], zStarts[2], zCounts[2];
+    int xRuns = splitWrapped(x0, count, size, xStarts, xCounts);
+    int zRuns = splitWrapped(z0, z1 - z0, size, zStarts, zCounts);
+    for (int j = 0; j < zRuns; j++)
+    {
+        for (int i = 0; i < xRuns; i++)
+        {
+            TerrainClipmapUpload upload;
+            upload.level = level;
+            upload.x = xStarts[i];
+            upload.z = zStarts[j];
+            upload.width = xCounts[i];
+            upload.height = zCounts[j];
+            uploads.push_back(upload);
+        }
+    }
+
+    size_t samples = (size_t)count * (z1 - z0);
+    stats.uploadRects += xRuns * zRuns;
+    stats.samplesGenerated += samples;
+    stats.uploadBytes += samples * sizeof(float);
+}
+
+float TerrainClipmap::getHeight(float x, float z) const
+{
+    int gridX = (int)std::floor(x);
+    int gridZ = (int)std::floor(z);
+    float xCoord = x - gridX;
+    float zCoord = z - gridZ;
+
+    float row0[2], row1[2];
+    source(gridX, gridZ, 2, row0);
+    source(gridX, gridZ + 1, 2, row1);
+
+    float h0 = row0[0] * (1 - xCoord) + row0[1] * xCoord;
+    float h1 = row1[0] * (1 - xCoord) + row1[1] * xCoord;
+
+    return h0 * (1 - zCoord) + h1 * zCoord;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "heightfield.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Geometry clipmap over an unbounded heightfield.
+//
+// Level k is a (gridSize + 1)^2 window of samples spaced 2^k cells apart, centred on the camera
+// and snapped to even level-k samples so every level nests inside the next coarser one with its
+// samples on the coarse grid. Each level's heights live in a toroidal array (sample (x, z) is
+// stored at (x mod size, z mod size)), so when the camera moves only the strips entering the
+// window are generated and uploaded; the rest stay where they are. Vertex data is one shared
+// grid no matter how large the world is. This class is CPU-only; TerrainClipmapRenderer mirrors
+// the arrays into a texture.
+struct TerrainClipmapSettings
+{
+    int gridSize = 64; // Quads per level side, a multiple of 4 up to TerrainClipmapMaxGridSize
+    int levels = 6;    // Level k has a vertex spacing of 2^k cells, 1 to TerrainClipmapMaxLevels
+};
+
+// Keep 2^k sample spacings and the outermost window (gridSize << (levels - 1) cells) well
+// inside int range
+constexpr int TerrainClipmapMaxGridSize = 1024;
+constexpr int TerrainClipmapMaxLevels = 16;
+
+// Rectangle of one level's toroidal array that changed, in texels. Never wraps.
+struct TerrainClipmapUpload
+{
+    int level = 0;
+    int x = 0, z = 0, width = 0, height = 0;
+};
+
+struct TerrainClipmapStats
+{
+    int levelsMoved = 0;
+    int uploadRects = 0;
+    size_t samplesGenerated = 0;
+    size_t uploadBytes = 0;
+};
+
+class TerrainClipmap
+{
+public:
+    // Levels and grid size are clamped to the supported range (see getSettings). Coarse levels
+    // sample every 2^k-th cell through stridedSource, or one source call per sample without one.
+    TerrainClipmap(HeightRowFunction source, const TerrainClipmapSettings &settings = TerrainClipmapSettings(),
+                   HeightStridedRowFunction stridedSource = nullptr);
+
+    // Recentres every level on the camera, generating the samples that entered each window.
+    // getUploads lists the texels that changed; the first call fills every level.
+    void update(const glm::vec3 &camera);
+
+    const TerrainClipmapSettings &getSettings() const { return settings; }
+    int getLevelCount() const { return settings.levels; }
+    int getGridSize() const { return settings.gridSize; }
+
+    // Side of each level's toroidal array: exactly one window of samples
+    int getTextureSize() const { return settings.gridSize + 1; }
+
+    // First sample of a level's window, in level-k samples (multiply by 2^k for cells)
+    glm::ivec2 getOrigin(int level) const { return levels[level].origin; }
+
+    // Where the next finer level's window starts inside this one, in this level's quads. Always
+    // gridSize / 4 plus 0 or 1 on each axis, so rings only need four hole positions.
+    glm::ivec2 getHoleOffset(int level) const;
+
+    // getTextureSize()^2 toroidal heights of a level, row-major
+    const float *getHeights(int level) const { return levels[level].heights.data(); }
+
+    const std::vector<TerrainClipmapUpload> &getUploads() const { return uploads; }
+    const TerrainClipmapStats &getStats() const { return stats; }
+
+    // Bilinear height at a world position straight from the source, wherever the camera is
+    float getHeight(float x, float z) const;
+
+private:
+    struct Level
+    {
+        glm::ivec2 origin = glm::ivec2(0);
+        bool filled = false;
+        std::vector<float> heights;
+    };
+
+    // Generates samples [x0, x1) x [z0, z1) of a level (level-k sample coordinates) into its
+    // toroidal array and records the upload rectangles
+    void fillRegion(int level, int x0, int z0, int x1, int z1);
+
+    HeightRowFunction source;
+    HeightStridedRowFunction stridedSource;
+    TerrainClipmapSettings settings;
+    std::vector<Level> levels;
+    std::vector<TerrainClipmapUpload> uploads;
+    TerrainClipmapStats stats;
+    std::vector<float> rowScratch;
+};
@@ -0,0 +1,215 @@
+#include "terrain_clipmap_renderer.h"
+#include "terrain_indices.h"
+#include "uniform_buffers.h"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+namespace
+{
+    // Grid vertices only carry their coordinate in the level's window; world position, height and
+    // normal come from the level uniforms and the toroidal height layer
+    const char *clipmapVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aGrid;
+
+    uniform sampler2DArray heightMap;
+    uniform int level;
+    uniform ivec2 origin;        // first sample of the window, in level samples
+    uniform ivec2 wrappedOrigin; // origin modulo the layer size
+    uniform float spacing;       // cells between samples
+    uniform float morphWidth;    // quads over which the outer edge blends into the coarser level
+
+    out vec3 FragPos;
+    out vec3 Normal;
+    out vec2 TexCoord;
+
+    float heightAt(ivec2 g)
+    {
+        int size = textureSize(heightMap, 0).x;
+        g = clamp(g, ivec2(0), ivec2(size - 1));
+        return texelFetch(heightMap, ivec3((wrappedOrigin + g) % size, level), 0).r;
+    }
+
+    void main()
+    {
+        ivec2 g = ivec2(aGrid);
+        int gridSize = textureSize(heightMap, 0).x - 1;
+        float y = heightAt(g);
+
+        // Near the outer edge, odd vertices slide onto the coarser level's triangles (whose
+        // diagonals run from +x-z to -x+z like the grid's), so neighbouring levels meet without
+        // cracks or popping
+        float coarse = y;
+        if ((g.x & 1) == 1 && (g.y & 1) == 1)
+            coarse = 0.5 * (heightAt(g + ivec2(1, -1)) + heightAt(g + ivec2(-1, 1)));
+        else if ((g.x & 1) == 1)
+            coarse = 0.5 * (heightAt(g - ivec2(1, 0)) + heightAt(g + ivec2(1, 0)));
+        else if ((g.y & 1) == 1)
+            coarse = 0.5 * (heightAt(g - ivec2(0, 1)) + heightAt(g + ivec2(0, 1)));
+        int edge = min(min(g.x, g.y), min(gridSize - g.x, gridSize - g.y));
+        float blend = morphWidth > 0.0 ? clamp(1.0 - float(edge) / morphWidth, 0.0, 1.0) : 0.0;
+        y = mix(y, coarse, blend);
+
+        vec2 world = vec2(origin + g) * spacing;
+        Normal = normalize(vec3(heightAt(g - ivec2(1, 0)) - heightAt(g + ivec2(1, 0)), 2.0 * spacing,
+                                heightAt(g - ivec2(0, 1)) - heightAt(g + ivec2(0, 1))));
+        FragPos = vec3(world.x, y, world.y);
+        TexCoord = world * 0.1;
+
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+    }
+)";
+
+    int wrap(int value, int size)
+    {
+        int remainder = value % size;
+        return remainder < 0 ? remainder + size : remainder;
+    }
+}
+
+TerrainClipmapRenderer::TerrainClipmapRenderer(HeightRowFunction source, const char *fragmentSource,
+                                               const TerrainClipmapSettings &settings,
+                                               HeightStridedRowFunction stridedSource)
+    : clipmap(std::move(source), settings, std::move(stridedSource))
+{
+    program = ShaderProgram(addSharedUniformBlocks(clipmapVertexShaderSource).c_str(), fragmentSource);
+    bindSharedUniformBlocks(program);
+    levelUniform = program.uniform<int>("level");
+    originUniform = program.uniform<glm::ivec2>("origin");
+    wrappedOriginUniform = program.uniform<glm::ivec2>("wrappedOrigin");
+    spacingUniform = program.uniform<float>("spacing");
+    morphWidthUniform = program.uniform<float>("morphWidth");
+
+    program.setSampler("materials", 0);
+    program.setSampler("heightMap", 4);
+    glUseProgram(0);
+
+    // One single-channel float layer per level, filled strip by strip in render
+    int size = clipmap.getTextureSize();
+    glGenTextures(1, &heightTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heightTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, size, size, clipmap.getLevelCount(), 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    int grid = clipmap.getGridSize();
+    std::vector<float> vertices;
+    vertices.reserve((size_t)size * size * 2);
+    for (int z = 0; z < size; z++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            vertices.push_back((float)x);
+            vertices.push_back((float)z);
+        }
+    }
+
+    // The finer window covers half of a coarser level's quads, starting a quarter in (plus one
+    // quad on either axis depending on where the camera sits), so four rings cover every case
+    std::vector<unsigned int> indices;
+    appendGridTriangles(size, 0, 0, grid, grid, indices);
+    rangeCount[0] = (int)indices.size();
+    for (int ring = 1; ring < 5; ring++)
+    {
+        int holeX0 = grid / 4 + ((ring - 1) & 1), holeZ0 = grid / 4 + ((ring - 1) >> 1);
+        int holeX1 = holeX0 + grid / 2, holeZ1 = holeZ0 + grid / 2;
+
+        rangeFirst[ring] = (int)indices.size();
+        appendGridTriangles(size, 0, 0, grid, holeZ0, indices);
+        appendGridTriangles(size, 0, holeZ0, holeX0, holeZ1, indices);
+        appendGridTriangles(size, holeX1, holeZ0, grid, holeZ1, indices);
+        appendGridTriangles(size, 0, holeZ1, grid, grid, indices);
+        rangeCount[ring] = (int)indices.size() - rangeFirst[ring];
+    }
+    meshSize = vertices.size() * sizeof(float) + indices.size() * sizeof(unsigned int);
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    // Grid coordinate attribute
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+}
+
+TerrainClipmapRenderer::~TerrainClipmapRenderer()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteTextures(1, &heightTexture);
+}
+
+size_t TerrainClipmapRenderer::textureBytes() const
+{
+    size_t size = (size_t)clipmap.getTextureSize();
+    return size * size * clipmap.getLevelCount() * sizeof(float);
+}
+
+void TerrainClipmapRenderer::render(const glm::vec3 &viewPos)
+{
+    clipmap.update(viewPos);
+
+    // Each rectangle is a sub-rectangle of the level's CPU array, uploaded in place
+    int size = clipmap.getTextureSize();
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heightTexture);
+    if (!clipmap.getUploads().empty())
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, size);
+        for (const TerrainClipmapUpload &upload : clipmap.getUploads())
+        {
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, upload.x);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, upload.z);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, upload.x, upload.z, upload.level, upload.width, upload.height, 1,
+                            GL_RED, GL_FLOAT, clipmap.getHeights(upload.level));
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    }
+
+    program.use();
+
+    glBindVertexArray(VAO);
+
+    for (int level = 0; level < clipmap.getLevelCount(); level++)
+    {
+        glm::ivec2 origin = clipmap.getOrigin(level);
+        levelUniform.set(level);
+        originUniform.set(origin);
+        wrappedOriginUniform.set(glm::ivec2(wrap(origin.x, size), wrap(origin.y, size)));
+        spacingUniform.set((float)(1 << level));
+
+        // The coarsest level has nothing to blend into
+        bool coarsest = level == clipmap.getLevelCount() - 1;
+        morphWidthUniform.set(coarsest ? 0.0f : (float)(clipmap.getGridSize() / 8));
+
+        int range = 0;
+        if (level > 0)
+        {
+            glm::ivec2 hole = clipmap.getHoleOffset(level) - glm::ivec2(clipmap.getGridSize() / 4);
+            range = 1 + hole.x + 2 * hole.y;
+        }
+        glDrawElements(GL_TRIANGLES, rangeCount[range], GL_UNSIGNED_INT,
+                       (void *)(rangeFirst[range] * sizeof(unsigned int)));
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "shader_program.h"
+#include "terrain_clipmap.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Draws a TerrainClipmap: one shared (gridSize + 1)^2 grid of vertices, heights fetched in the
+// vertex shader from a float texture array with one toroidal layer per level. Level 0 draws the
+// whole grid; every coarser level draws it as a ring around the finer level's window.
+class TerrainClipmapRenderer
+{
+public:
+    // fragmentSource is the regular terrain fragment shader, shared uniform blocks included (the
+    // clipmap vertex shader produces the same FragPos/Normal/TexCoord outputs). stridedSource,
+    // when given, generates the coarse levels in batches (see TerrainClipmap).
+    TerrainClipmapRenderer(HeightRowFunction source, const char *fragmentSource,
+                           const TerrainClipmapSettings &settings = TerrainClipmapSettings(),
+                           HeightStridedRowFunction stridedSource = nullptr);
+    ~TerrainClipmapRenderer();
+
+    TerrainClipmapRenderer(const TerrainClipmapRenderer &) = delete;
+    TerrainClipmapRenderer &operator=(const TerrainClipmapRenderer &) = delete;
+
+    // Recentres the clipmap on viewPos, uploads the strips that changed and draws every level.
+    // The frame and object uniform blocks (uniform_buffers.h) and the materials (unit 0) must
+    // already be bound; the heights use unit 4. Leaves the clipmap program bound.
+    void render(const glm::vec3 &viewPos);
+
+    const TerrainClipmap &getClipmap() const { return clipmap; }
+
+    // GPU memory, fixed at construction: the shared grid and index buffer, and the height texture
+    size_t meshBytes() const { return meshSize; }
+    size_t textureBytes() const;
+
+private:
+    TerrainClipmap clipmap;
+
+    ShaderProgram program;
+    unsigned int heightTexture = 0;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    size_t meshSize = 0;
+
+    // Index ranges: the full grid, then rings for hole offsets (0, 0), (1, 0), (0, 1) and (1, 1)
+    int rangeFirst[5] = {}, rangeCount[5] = {};
+
+    Uniform<int> levelUniform;
+    Uniform<glm::ivec2> originUniform, wrappedOriginUniform;
+    Uniform<float> spacingUniform, morphWidthUniform;
+};
@@ -0,0 +1,187 @@
+#include "terrain_compact.h"
+#include "uniform_buffers.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    // Position and texture coordinates come from gl_VertexID (the grid index), the height from a
+    // normalized 16-bit attribute and the normal from an octahedral snorm8 pair
+    const char *compactVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in float aHeight;
+    layout (location = 1) in vec2 aOctNormal;
+
+    uniform int gridWidth;
+    uniform vec2 heightRange; // min, scale
+    uniform bool hasNormals;
+
+    out vec3 FragPos;
+    out vec3 Normal;
+    out vec2 TexCoord;
+
+    vec3 octDecode(vec2 e)
+    {
+        vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+        float t = max(-n.z, 0.0);
+        n.x += n.x >= 0.0 ? -t : t;
+        n.y += n.y >= 0.0 ? -t : t;
+        return normalize(n);
+    }
+
+    void main()
+    {
+        float x = float(gl_VertexID % gridWidth);
+        float z = float(gl_VertexID / gridWidth);
+        float y = heightRange.x + aHeight * heightRange.y;
+
+        FragPos = vec3(x, y, z);
+        Normal = hasNormals ? octDecode(aOctNormal) : vec3(0.0, 1.0, 0.0);
+        TexCoord = vec2(x, z) * 0.1;
+
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+    }
+)";
+
+    int8_t toSnorm8(float value)
+    {
+        return (int8_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f);
+    }
+
+    void printLayout(const char *name, size_t bytesPerVertex, size_t vertexCount)
+    {
+        double megabytes = bytesPerVertex * vertexCount / (1024.0 * 1024.0);
+        std::cout << "  " << std::left << std::setw(36) << name << std::right << std::setw(3) << bytesPerVertex
+                  << " B/vertex  " << std::fixed << std::setprecision(2) << megabytes << " MB";
+        if (bytesPerVertex != FloatTerrainVertexBytes)
+            std::cout << "  (" << std::setprecision(1) << (double)FloatTerrainVertexBytes / bytesPerVertex << "x smaller)";
+        std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+}
+
+glm::vec2 octEncode(const glm::vec3 &normal)
+{
+    glm::vec2 p = glm::vec2(normal.x, normal.y) / (std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z));
+    if (normal.z < 0.0f)
+    {
+        // Fold the lower hemisphere over the diagonals
+        glm::vec2 folded = 1.0f - glm::abs(glm::vec2(p.y, p.x));
+        p = glm::vec2(p.x >= 0.0f ? folded.x : -folded.x, p.y >= 0.0f ? folded.y : -folded.y);
+    }
+    return p;
+}
+
+glm::vec3 octDecode(const glm::vec2 &encoded)
+{
+    glm::vec3 n(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+void buildCompactTerrainVertices(const float *heights, int width, int height, const glm::vec3 *normals,
+                                 std::vector<CompactTerrainVertex> &out, float &heightMin, float &heightScale)
+{
+    size_t count = (size_t)width * height;
+    auto range = std::minmax_element(heights, heights + count);
+    heightMin = *range.first;
+    heightScale = std::max(*range.second - *range.first, 1e-6f);
+
+    out.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        float normalized = (heights[i] - heightMin) / heightScale;
+        out[i].height = (uint16_t)std::lround(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+
+        glm::vec2 encoded = normals ? octEncode(normals[i]) : glm::vec2(0.0f);
+        out[i].normal[0] = toSnorm8(encoded.x);
+        out[i].normal[1] = toSnorm8(encoded.y);
+    }
+}
+
+CompactTerrainMesh::CompactTerrainMesh(const float *heights, int width, int height, const glm::vec3 *normals,
+                                       unsigned int sharedEBO, size_t indexCount, const char *fragmentSource)
+    : indexCount(indexCount)
+{
+    std::vector<CompactTerrainVertex> vertices;
+    float heightMin, heightScale;
+    buildCompactTerrainVertices(heights, width, height, normals, vertices, heightMin, heightScale);
+
+    program = ShaderProgram(addSharedUniformBlocks(compactVertexShaderSource).c_str(), fragmentSource);
+    bindSharedUniformBlocks(program);
+
+    program.use();
+    program.uniform<int>("gridWidth").set(width);
+    program.uniform<glm::vec2>("heightRange").set(glm::vec2(heightMin, heightScale));
+    program.uniform<int>("hasNormals").set(normals != nullptr);
+    program.setSampler("materials", 0);
+    program.setSampler("splatMap", 5);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    if (normals)
+    {
+        bufferBytes = vertices.size() * sizeof(CompactTerrainVertex);
+        glBufferData(GL_ARRAY_BUFFER, bufferBytes, vertices.data(), GL_STATIC_DRAW);
+
+        // Quantized height
+        glVertexAttribPointer(0, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactTerrainVertex), (void *)0);
+        glEnableVertexAttribArray(0);
+
+        // Octahedral normal
+        glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, sizeof(CompactTerrainVertex), (void *)offsetof(CompactTerrainVertex, normal));
+        glEnableVertexAttribArray(1);
+    }
+    else
+    {
+        // Heights only: a tightly packed 16-bit stream
+        std::vector<uint16_t> packed(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            packed[i] = vertices[i].height;
+
+        bufferBytes = packed.size() * sizeof(uint16_t);
+        glBufferData(GL_ARRAY_BUFFER, bufferBytes, packed.data(), GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(uint16_t), (void *)0);
+        glEnableVertexAttribArray(0);
+    }
+
+    // Indices are grid indices, which is exactly what gl_VertexID needs
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedEBO);
+
+    glBindVertexArray(0);
+}
+
+CompactTerrainMesh::~CompactTerrainMesh()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+}
+
+void CompactTerrainMesh::render()
+{
+    program.use();
+
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+void CompactTerrainMesh::printMemoryReport(size_t vertexCount)
+{
+    std::cout << "Terrain vertex memory (" << vertexCount << " vertices):" << std::endl;
+    printLayout("float layout (Terrain::setupMesh)", FloatTerrainVertexBytes, vertexCount);
+    printLayout("compact height + octahedral normal", sizeof(CompactTerrainVertex), vertexCount);
+    printLayout("compact height only", sizeof(uint16_t), vertexCount);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "shader_program.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact terrain vertices: x/z and texture coordinates follow from the grid index
+// (gl_VertexID), so a vertex only stores a 16-bit quantized height and, optionally, an
+// octahedral-encoded normal in two signed bytes.
+struct CompactTerrainVertex
+{
+    uint16_t height;
+    int8_t normal[2];
+};
+
+static_assert(sizeof(CompactTerrainVertex) == 4, "compact terrain vertex must stay 4 bytes");
+
+// Bytes per vertex of the interleaved float layout in Terrain::setupMesh (position, normal, uv)
+constexpr size_t FloatTerrainVertexBytes = 8 * sizeof(float);
+
+// Octahedral normal encoding into [-1, 1]^2, stored as snorm8
+glm::vec2 octEncode(const glm::vec3 &normal);
+glm::vec3 octDecode(const glm::vec2 &encoded);
+
+// Quantizes a heightfield into compact vertices. heightMin/heightScale receive the dequantization
+// parameters (height = heightMin + q / 65535 * heightScale).
+void buildCompactTerrainVertices(const float *heights, int width, int height, const glm::vec3 *normals,
+                                 std::vector<CompactTerrainVertex> &out, float &heightMin, float &heightScale);
+
+// Draws a terrain grid from compact vertices, reusing the terrain's existing index buffer
+class CompactTerrainMesh
+{
+public:
+    // normals may be null, in which case only heights are stored (2 bytes per vertex)
+    CompactTerrainMesh(const float *heights, int width, int height, const glm::vec3 *normals,
+                       unsigned int sharedEBO, size_t indexCount, const char *fragmentSource);
+    ~CompactTerrainMesh();
+
+    CompactTerrainMesh(const CompactTerrainMesh &) = delete;
+    CompactTerrainMesh &operator=(const CompactTerrainMesh &) = delete;
+
+    // The frame and object uniform blocks (uniform_buffers.h) and the terrain textures must
+    // already be bound: materials to unit 0 (and the splat map to unit 5 for a BAKED_SPLAT
+    // fragment shader). Leaves the compact program bound.
+    void render();
+
+    size_t vertexBufferBytes() const { return bufferBytes; }
+
+    // Prints the float layout next to the compact layouts for vertexCount vertices
+    static void printMemoryReport(size_t vertexCount);
+
+private:
+    ShaderProgram program;
+    unsigned int VAO = 0, VBO = 0;
+    size_t indexCount = 0;
+    size_t bufferBytes = 0;
+};
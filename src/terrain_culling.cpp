@@ -0,0 +1,112 @@
+#include "terrain_culling.h"
+#include "occlusion_buffer.h"
+#include "terrain_indices.h"
+
+#include <algorithm>
+#include <cmath>
+
+void layoutTerrainChunks(int width, int height, int chunkSize, std::vector<TerrainCullChunk> &chunks)
+{
+    chunks.clear();
+    size_t firstIndex = 0;
+    for (int z0 = 0; z0 < height - 1; z0 += chunkSize)
+    {
+        for (int x0 = 0; x0 < width - 1; x0 += chunkSize)
+        {
+            TerrainCullChunk chunk;
+            chunk.x0 = x0;
+            chunk.z0 = z0;
+            chunk.x1 = std::min(x0 + chunkSize, width - 1);
+            chunk.z1 = std::min(z0 + chunkSize, height - 1);
+            chunk.firstIndex = firstIndex;
+            chunk.indexCount = (size_t)(chunk.x1 - chunk.x0) * (chunk.z1 - chunk.z0) * 6;
+            chunk.boxMin = glm::vec3((float)chunk.x0, 0.0f, (float)chunk.z0);
+            chunk.boxMax = glm::vec3((float)chunk.x1, 0.0f, (float)chunk.z1);
+            chunks.push_back(chunk);
+            firstIndex += chunk.indexCount;
+        }
+    }
+}
+
+void buildChunkedTriangleList(int width, int height, int chunkSize, std::vector<unsigned int> &indices,
+                              std::vector<TerrainCullChunk> &chunks)
+{
+    layoutTerrainChunks(width, height, chunkSize, chunks);
+
+    indices.clear();
+    indices.reserve((size_t)(width - 1) * (height - 1) * 6);
+    for (const TerrainCullChunk &chunk : chunks)
+        appendGridTriangles(width, chunk.x0, chunk.z0, chunk.x1, chunk.z1, indices);
+}
+
+void updateChunkBounds(const float *heights, int width, int x0, int z0, int x1, int z1,
+                       std::vector<TerrainCullChunk> &chunks, ThreadPool *pool)
+{
+    // A chunk's vertices run from sample x0 to sample x1 inclusive
+    auto updateChunks = [&](int first, int last)
+    {
+        for (int c = first; c < last; c++)
+        {
+            TerrainCullChunk &chunk = chunks[c];
+            if (chunk.x1 < x0 || chunk.x0 >= x1 || chunk.z1 < z0 || chunk.z0 >= z1)
+                continue;
+
+            float minHeight = INFINITY, maxHeight = -INFINITY;
+            for (int z = chunk.z0; z <= chunk.z1; z++)
+            {
+                const float *row = heights + (size_t)z * width;
+                auto range = std::minmax_element(row + chunk.x0, row + chunk.x1 + 1);
+                minHeight = std::min(minHeight, *range.first);
+                maxHeight = std::max(maxHeight, *range.second);
+            }
+            chunk.boxMin.y = minHeight;
+            chunk.boxMax.y = maxHeight;
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, (int)chunks.size(), 16, updateChunks);
+    else
+        updateChunks(0, (int)chunks.size());
+}
+
+void cullTerrainChunks(const std::vector<TerrainCullChunk> &chunks, const Frustum &frustum, size_t indexSize,
+                       std::vector<int> &counts, std::vector<const void *> &offsets, TerrainCullStats &stats,
+                       const OcclusionBuffer *occlusion)
+{
+    counts.clear();
+    offsets.clear();
+    stats = TerrainCullStats();
+
+    size_t rangeEnd = 0;
+    for (const TerrainCullChunk &chunk : chunks)
+    {
+        stats.chunksTested++;
+        if (!frustum.intersectsAABB(chunk.boxMin, chunk.boxMax))
+        {
+            stats.chunksCulled++;
+            continue;
+        }
+        if (occlusion && !occlusion->isVisible(chunk.boxMin, chunk.boxMax))
+        {
+            stats.chunksOccluded++;
+            continue;
+        }
+
+        stats.chunksVisible++;
+        stats.triangles += chunk.indexCount / 3;
+
+        // Extend the previous range when this chunk follows it directly in the index buffer
+        if (!counts.empty() && rangeEnd == chunk.firstIndex)
+        {
+            counts.back() += (int)chunk.indexCount;
+        }
+        else
+        {
+            counts.push_back((int)chunk.indexCount);
+            offsets.push_back(reinterpret_cast<const void *>(chunk.firstIndex * indexSize));
+        }
+        rangeEnd = chunk.firstIndex + chunk.indexCount;
+    }
+    stats.drawRanges = (int)counts.size();
+}
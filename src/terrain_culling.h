@@ -0,0 +1,54 @@
+#pragma once
+
+#include "frustum.h"
+#include "thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+class OcclusionBuffer;
+
+// Cells per side of a culling chunk. 64 keeps the boxes tight without the per-frame test list
+// growing past a few thousand chunks on a 4k map.
+constexpr int TerrainCullChunkSize = 64;
+
+// Square block of terrain cells whose triangles form one contiguous range of the index buffer
+struct TerrainCullChunk
+{
+    int x0 = 0, z0 = 0, x1 = 0, z1 = 0; // Cells [x0, x1) x [z0, z1)
+    size_t firstIndex = 0, indexCount = 0;
+    glm::vec3 boxMin = glm::vec3(0.0f), boxMax = glm::vec3(0.0f);
+};
+
+struct TerrainCullStats
+{
+    int chunksTested = 0;
+    int chunksVisible = 0;
+    int chunksCulled = 0;
+    int chunksOccluded = 0; // Inside the frustum but hidden behind the occlusion buffer
+    int drawRanges = 0; // Visible chunks that are neighbours in the index buffer share one range
+    size_t triangles = 0;
+};
+
+// Chunk layout of a width x height grid: chunks in row-major order, each holding
+// chunkSize x chunkSize cells (fewer on the far edges) and two triangles per cell. Boxes are
+// left flat until updateChunkBounds fills in the heights.
+void layoutTerrainChunks(int width, int height, int chunkSize, std::vector<TerrainCullChunk> &chunks);
+
+// GL_TRIANGLES list for the grid in the order layoutTerrainChunks describes, so each chunk can
+// be drawn (and its triangles reordered) on its own
+void buildChunkedTriangleList(int width, int height, int chunkSize, std::vector<unsigned int> &indices,
+                              std::vector<TerrainCullChunk> &chunks);
+
+// Recomputes the box height range of every chunk touching the samples [x0, x1) x [z0, z1)
+void updateChunkBounds(const float *heights, int width, int x0, int z0, int x1, int z1,
+                       std::vector<TerrainCullChunk> &chunks, ThreadPool *pool = nullptr);
+
+// Tests every chunk against the frustum (and, when given, the rasterized occlusion buffer) and
+// writes glMultiDrawElements arguments for the visible ones: counts[i] indices starting at byte
+// offsets[i] of the element buffer
+void cullTerrainChunks(const std::vector<TerrainCullChunk> &chunks, const Frustum &frustum, size_t indexSize,
+                       std::vector<int> &counts, std::vector<const void *> &offsets, TerrainCullStats &stats,
+                       const OcclusionBuffer *occlusion = nullptr);
@@ -0,0 +1,134 @@
+#include "terrain_deform.h"
+
+#include <algorithm>
+#include <cmath>
+
+TerrainRect TerrainRect::clamped(int width, int height) const
+{
+    return {std::max(x0, 0), std::max(z0, 0), std::min(x1, width), std::min(z1, height)};
+}
+
+bool TerrainRect::touches(const TerrainRect &other) const
+{
+    return x0 <= other.x1 && other.x0 <= x1 && z0 <= other.z1 && other.z0 <= z1;
+}
+
+TerrainRect TerrainRect::united(const TerrainRect &other) const
+{
+    return {std::min(x0, other.x0), std::min(z0, other.z0), std::max(x1, other.x1), std::max(z1, other.z1)};
+}
+
+void DirtyRegionTracker::add(const TerrainRect &rect)
+{
+    if (rect.isEmpty())
+        return;
+
+    // Merge into an existing rectangle when the union doesn't waste much more than it saves;
+    // merging can make the result touch others, so keep going until nothing changes
+    TerrainRect merged = rect;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 0; i < rects.size(); i++)
+        {
+            TerrainRect candidate = merged.united(rects[i]);
+            if (merged.touches(rects[i]) && candidate.area() <= 2 * (merged.area() + rects[i].area()))
+            {
+                merged = candidate;
+                rects.erase(rects.begin() + i);
+                changed = true;
+                break;
+            }
+        }
+    }
+    rects.push_back(merged);
+}
+
+void collectVertexUploadSpans(const std::vector<TerrainRect> &rects, int width, size_t bytesPerVertex,
+                              std::vector<VertexUploadSpan> &out)
+{
+    out.clear();
+    for (const TerrainRect &rect : rects)
+    {
+        if (rect.isEmpty())
+            continue;
+
+        if (rect.x0 == 0 && rect.x1 == width)
+        {
+            out.push_back({(size_t)rect.z0 * width * bytesPerVertex, rect.area() * bytesPerVertex});
+            continue;
+        }
+
+        for (int z = rect.z0; z < rect.z1; z++)
+            out.push_back({((size_t)z * width + rect.x0) * bytesPerVertex, (size_t)(rect.x1 - rect.x0) * bytesPerVertex});
+    }
+}
+
+TerrainRect applyCrater(float *heights, int width, int height, float x, float z, float radius, float depth)
+{
+    // The rim reaches out to 1.5 radii
+    float reach = radius * 1.5f;
+    TerrainRect rect = TerrainRect{(int)std::floor(x - reach), (int)std::floor(z - reach),
+                                   (int)std::ceil(x + reach) + 1, (int)std::ceil(z + reach) + 1}
+                           .clamped(width, height);
+
+    for (int gz = rect.z0; gz < rect.z1; gz++)
+    {
+        for (int gx = rect.x0; gx < rect.x1; gx++)
+        {
+            float t = std::sqrt((gx - x) * (gx - x) + (gz - z) * (gz - z)) / radius;
+            float delta = 0.0f;
+            if (t < 1.0f)
+                delta = -depth * (1.0f - t * t);
+            else if (t < 1.5f)
+                delta = depth * 0.2f * std::sin((t - 1.0f) * 2.0f * 3.14159265f);
+            heights[(size_t)gz * width + gx] += delta;
+        }
+    }
+    return rect;
+}
+
+TerrainRect applyRut(float *heights, int width, int height, const glm::vec2 &from, const glm::vec2 &to,
+                     float halfWidth, float depth)
+{
+    TerrainRect rect = TerrainRect{(int)std::floor(std::min(from.x, to.x) - halfWidth),
+                                   (int)std::floor(std::min(from.y, to.y) - halfWidth),
+                                   (int)std::ceil(std::max(from.x, to.x) + halfWidth) + 1,
+                                   (int)std::ceil(std::max(from.y, to.y) + halfWidth) + 1}
+                           .clamped(width, height);
+
+    glm::vec2 segment = to - from;
+    float lengthSquared = std::max(glm::dot(segment, segment), 1e-12f);
+
+    for (int gz = rect.z0; gz < rect.z1; gz++)
+    {
+        for (int gx = rect.x0; gx < rect.x1; gx++)
+        {
+            glm::vec2 p((float)gx, (float)gz);
+            float along = std::clamp(glm::dot(p - from, segment) / lengthSquared, 0.0f, 1.0f);
+            float distance = glm::length(p - (from + segment * along));
+            if (distance < halfWidth)
+            {
+                float t = distance / halfWidth;
+                heights[(size_t)gz * width + gx] -= depth * (1.0f - t * t);
+            }
+        }
+    }
+    return rect;
+}
+
+TerrainRect applyHeightEdit(float *heights, int width, int height, const TerrainRect &rect,
+                            const std::function<float(int, int, float)> &edit)
+{
+    TerrainRect clampedRect = rect.clamped(width, height);
+    for (int z = clampedRect.z0; z < clampedRect.z1; z++)
+    {
+        for (int x = clampedRect.x0; x < clampedRect.x1; x++)
+        {
+            float &value = heights[(size_t)z * width + x];
+            value = edit(x, z, value);
+        }
+    }
+    return clampedRect;
+}
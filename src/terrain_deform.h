@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Half-open rectangle of heightfield samples, [x0, x1) x [z0, z1)
+struct TerrainRect
+{
+    int x0 = 0, z0 = 0, x1 = 0, z1 = 0;
+
+    bool isEmpty() const { return x0 >= x1 || z0 >= z1; }
+    size_t area() const { return isEmpty() ? 0 : (size_t)(x1 - x0) * (z1 - z0); }
+
+    TerrainRect grown(int amount) const { return {x0 - amount, z0 - amount, x1 + amount, z1 + amount}; }
+    TerrainRect clamped(int width, int height) const;
+    bool touches(const TerrainRect &other) const;
+    TerrainRect united(const TerrainRect &other) const;
+};
+
+// Rectangles edited since the last upload. Touching rectangles are merged, so a brush dragged
+// across the map stays a handful of rectangles instead of one per stamp.
+class DirtyRegionTracker
+{
+public:
+    void add(const TerrainRect &rect);
+    void clear() { rects.clear(); }
+
+    bool isEmpty() const { return rects.empty(); }
+    const std::vector<TerrainRect> &getRects() const { return rects; }
+
+private:
+    std::vector<TerrainRect> rects;
+};
+
+// Contiguous byte range of an interleaved, row-major vertex buffer
+struct VertexUploadSpan
+{
+    size_t offset, size;
+};
+
+// Byte ranges covering the vertices of rects: one span per rect row, or one span for the whole
+// rect when it covers full rows, which makes the rows contiguous in the buffer
+void collectVertexUploadSpans(const std::vector<TerrainRect> &rects, int width, size_t bytesPerVertex,
+                              std::vector<VertexUploadSpan> &out);
+
+// Brushes. Each edits a width x height heightfield in place and returns the samples it changed.
+
+// Bowl of the given depth with a slight raised rim, centred on (x, z)
+TerrainRect applyCrater(float *heights, int width, int height, float x, float z, float radius, float depth);
+
+// Groove along the segment from -> to (world x/z), deepest on the centre line
+TerrainRect applyRut(float *heights, int width, int height, const glm::vec2 &from, const glm::vec2 &to,
+                     float halfWidth, float depth);
+
+// Scripted edit: replaces every height in rect with edit(x, z, oldHeight)
+TerrainRect applyHeightEdit(float *heights, int width, int height, const TerrainRect &rect,
+                            const std::function<float(int, int, float)> &edit);
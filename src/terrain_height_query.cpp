@@ -0,0 +1,191 @@
+#include "terrain_height_query.h"
+
+namespace
+{
+    void samplePoint(const float *heights, int width, int height, float x, float z, float *out, float *gradientX,
+                     float *gradientZ)
+    {
+        // Written so NaN fails the test too
+        if (!(x >= 0.0f && x < (float)(width - 1) && z >= 0.0f && z < (float)(height - 1)))
+        {
+            *out = 0.0f;
+            if (gradientX)
+                *gradientX = 0.0f;
+            if (gradientZ)
+                *gradientZ = 0.0f;
+            return;
+        }
+
+        int gridX = (int)x;
+        int gridZ = (int)z;
+        float xCoord = x - (float)gridX;
+        float zCoord = z - (float)gridZ;
+
+        const float *cell = heights + (size_t)gridZ * width + gridX;
+        float h00 = cell[0];
+        float h10 = cell[1];
+        float h01 = cell[width];
+        float h11 = cell[width + 1];
+
+        float h0 = h00 * (1.0f - xCoord) + h10 * xCoord;
+        float h1 = h01 * (1.0f - xCoord) + h11 * xCoord;
+        *out = h0 * (1.0f - zCoord) + h1 * zCoord;
+
+        if (gradientX)
+            *gradientX = (h10 - h00) * (1.0f - zCoord) + (h11 - h01) * zCoord;
+        if (gradientZ)
+            *gradientZ = h1 - h0;
+    }
+
+    void sampleScalar(const float *heights, int width, int height, const float *x, const float *z, size_t count,
+                      float *out, float *gradientX, float *gradientZ)
+    {
+        for (size_t i = 0; i < count; i++)
+            samplePoint(heights, width, height, x[i], z[i], out + i, gradientX ? gradientX + i : nullptr,
+                        gradientZ ? gradientZ + i : nullptr);
+    }
+
+#if RACING_SIMD_X86
+    // SSE2 has no gather: cell indices are computed four at a time, the corners loaded one by one
+    void sampleSSE2(const float *heights, int width, int height, const float *x, const float *z, size_t count,
+                    float *out, float *gradientX, float *gradientZ)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 maxX = _mm_set1_ps((float)(width - 1));
+        const __m128 maxZ = _mm_set1_ps((float)(height - 1));
+
+        size_t i = 0;
+        alignas(16) int cellX[4], cellZ[4];
+        alignas(16) float c00[4], c10[4], c01[4], c11[4];
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 px = _mm_loadu_ps(x + i);
+            __m128 pz = _mm_loadu_ps(z + i);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(px, zero), _mm_cmplt_ps(px, maxX)),
+                                       _mm_and_ps(_mm_cmpge_ps(pz, zero), _mm_cmplt_ps(pz, maxZ)));
+
+            // Outside lanes read cell (0, 0) and are zeroed at the end
+            px = _mm_and_ps(px, inside);
+            pz = _mm_and_ps(pz, inside);
+            __m128i gridX = _mm_cvttps_epi32(px);
+            __m128i gridZ = _mm_cvttps_epi32(pz);
+            __m128 xCoord = _mm_sub_ps(px, _mm_cvtepi32_ps(gridX));
+            __m128 zCoord = _mm_sub_ps(pz, _mm_cvtepi32_ps(gridZ));
+
+            _mm_store_si128(reinterpret_cast<__m128i *>(cellX), gridX);
+            _mm_store_si128(reinterpret_cast<__m128i *>(cellZ), gridZ);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                const float *cell = heights + (size_t)cellZ[lane] * width + cellX[lane];
+                c00[lane] = cell[0];
+                c10[lane] = cell[1];
+                c01[lane] = cell[width];
+                c11[lane] = cell[width + 1];
+            }
+            __m128 h00 = _mm_load_ps(c00), h10 = _mm_load_ps(c10);
+            __m128 h01 = _mm_load_ps(c01), h11 = _mm_load_ps(c11);
+
+            __m128 xInverse = _mm_sub_ps(one, xCoord);
+            __m128 zInverse = _mm_sub_ps(one, zCoord);
+            __m128 h0 = _mm_add_ps(_mm_mul_ps(h00, xInverse), _mm_mul_ps(h10, xCoord));
+            __m128 h1 = _mm_add_ps(_mm_mul_ps(h01, xInverse), _mm_mul_ps(h11, xCoord));
+            __m128 h = _mm_add_ps(_mm_mul_ps(h0, zInverse), _mm_mul_ps(h1, zCoord));
+            _mm_storeu_ps(out + i, _mm_and_ps(h, inside));
+
+            if (gradientX)
+            {
+                __m128 dx = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(h10, h00), zInverse),
+                                       _mm_mul_ps(_mm_sub_ps(h11, h01), zCoord));
+                _mm_storeu_ps(gradientX + i, _mm_and_ps(dx, inside));
+            }
+            if (gradientZ)
+                _mm_storeu_ps(gradientZ + i, _mm_and_ps(_mm_sub_ps(h1, h0), inside));
+        }
+        sampleScalar(heights, width, height, x + i, z + i, count - i, out + i, gradientX ? gradientX + i : nullptr,
+                     gradientZ ? gradientZ + i : nullptr);
+    }
+
+    RACING_TARGET_AVX2 void sampleAVX2(const float *heights, int width, int height, const float *x, const float *z,
+                                       size_t count, float *out, float *gradientX, float *gradientZ)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 maxX = _mm256_set1_ps((float)(width - 1));
+        const __m256 maxZ = _mm256_set1_ps((float)(height - 1));
+        const __m256i rowStride = _mm256_set1_epi32(width);
+        const __m256i step = _mm256_set1_epi32(1);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 px = _mm256_loadu_ps(x + i);
+            __m256 pz = _mm256_loadu_ps(z + i);
+            __m256 inside = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(px, zero, _CMP_GE_OQ), _mm256_cmp_ps(px, maxX, _CMP_LT_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(pz, zero, _CMP_GE_OQ), _mm256_cmp_ps(pz, maxZ, _CMP_LT_OQ)));
+
+            // Outside lanes gather cell (0, 0) and are zeroed at the end
+            px = _mm256_and_ps(px, inside);
+            pz = _mm256_and_ps(pz, inside);
+            __m256i gridX = _mm256_cvttps_epi32(px);
+            __m256i gridZ = _mm256_cvttps_epi32(pz);
+            __m256 xCoord = _mm256_sub_ps(px, _mm256_cvtepi32_ps(gridX));
+            __m256 zCoord = _mm256_sub_ps(pz, _mm256_cvtepi32_ps(gridZ));
+
+            __m256i index00 = _mm256_add_epi32(_mm256_mullo_epi32(gridZ, rowStride), gridX);
+            __m256i index01 = _mm256_add_epi32(index00, rowStride);
+            __m256 h00 = _mm256_i32gather_ps(heights, index00, 4);
+            __m256 h10 = _mm256_i32gather_ps(heights, _mm256_add_epi32(index00, step), 4);
+            __m256 h01 = _mm256_i32gather_ps(heights, index01, 4);
+            __m256 h11 = _mm256_i32gather_ps(heights, _mm256_add_epi32(index01, step), 4);
+
+            __m256 xInverse = _mm256_sub_ps(one, xCoord);
+            __m256 zInverse = _mm256_sub_ps(one, zCoord);
+            __m256 h0 = _mm256_add_ps(_mm256_mul_ps(h00, xInverse), _mm256_mul_ps(h10, xCoord));
+            __m256 h1 = _mm256_add_ps(_mm256_mul_ps(h01, xInverse), _mm256_mul_ps(h11, xCoord));
+            __m256 h = _mm256_add_ps(_mm256_mul_ps(h0, zInverse), _mm256_mul_ps(h1, zCoord));
+            _mm256_storeu_ps(out + i, _mm256_and_ps(h, inside));
+
+            if (gradientX)
+            {
+                __m256 dx = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(h10, h00), zInverse),
+                                          _mm256_mul_ps(_mm256_sub_ps(h11, h01), zCoord));
+                _mm256_storeu_ps(gradientX + i, _mm256_and_ps(dx, inside));
+            }
+            if (gradientZ)
+                _mm256_storeu_ps(gradientZ + i, _mm256_and_ps(_mm256_sub_ps(h1, h0), inside));
+        }
+        sampleSSE2(heights, width, height, x + i, z + i, count - i, out + i, gradientX ? gradientX + i : nullptr,
+                   gradientZ ? gradientZ + i : nullptr);
+    }
+#endif
+}
+
+float sampleHeight(const float *heights, int width, int height, float x, float z)
+{
+    float result;
+    samplePoint(heights, width, height, x, z, &result, nullptr, nullptr);
+    return result;
+}
+
+void sampleHeights(const float *heights, int width, int height, const float *x, const float *z, size_t count,
+                   float *out, float *gradientX, float *gradientZ, SimdLevel level)
+{
+    if (level > detectSimdLevel())
+        level = detectSimdLevel();
+
+#if RACING_SIMD_X86
+    if (level >= SimdLevel::AVX2)
+    {
+        sampleAVX2(heights, width, height, x, z, count, out, gradientX, gradientZ);
+        return;
+    }
+    if (level >= SimdLevel::SSE2)
+    {
+        sampleSSE2(heights, width, height, x, z, count, out, gradientX, gradientZ);
+        return;
+    }
+#endif
+    sampleScalar(heights, width, height, x, z, count, out, gradientX, gradientZ);
+}
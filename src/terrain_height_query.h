@@ -0,0 +1,22 @@
+#pragma once
+
+#include "simd.h"
+
+#include <cstddef>
+
+// Bilinear height queries against a width x height row-major heightfield.
+//
+// A point is inside when 0 <= x < width - 1 and 0 <= z < height - 1. Points outside (NaN
+// included) get height 0 and a zero gradient, on every path. Interpolation is
+//   h0 = h00 * (1 - fx) + h10 * fx,  h1 = h01 * (1 - fx) + h11 * fx,  h = h0 * (1 - fz) + h1 * fz
+// evaluated in that order without FMA, so the scalar and SIMD paths return bit-identical results.
+
+float sampleHeight(const float *heights, int width, int height, float x, float z);
+
+// Heights for count points given as separate x and z arrays (SoA). gradientX/gradientZ, when not
+// null, receive dh/dx and dh/dz of the bilinear patch under each point; a surface normal is
+// normalize(-gradientX, 1, -gradientZ). The AVX2 path fetches the four corners with gathers.
+// Needs width * height < 2^31.
+void sampleHeights(const float *heights, int width, int height, const float *x, const float *z, size_t count,
+                   float *out, float *gradientX = nullptr, float *gradientZ = nullptr,
+                   SimdLevel level = detectSimdLevel());
@@ -0,0 +1,101 @@
+#include "terrain_indices.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    using Triangle = std::array<unsigned int, 3>;
+
+    // Rotates a triangle so its smallest index comes first, keeping the winding
+    Triangle canonical(unsigned int a, unsigned int b, unsigned int c)
+    {
+        if (b < a && b < c)
+            return {b, c, a};
+        if (c < a && c < b)
+            return {c, a, b};
+        return {a, b, c};
+    }
+}
+
+void appendGridTriangles(int rowStride, int x0, int z0, int x1, int z1, std::vector<unsigned int> &out)
+{
+    out.reserve(out.size() + (size_t)(x1 - x0) * (z1 - z0) * 6);
+    for (int z = z0; z < z1; z++)
+    {
+        for (int x = x0; x < x1; x++)
+        {
+            unsigned int topLeft = z * rowStride + x;
+            unsigned int topRight = topLeft + 1;
+            unsigned int bottomLeft = (z + 1) * rowStride + x;
+            unsigned int bottomRight = bottomLeft + 1;
+
+            // First triangle
+            out.push_back(topLeft);
+            out.push_back(bottomLeft);
+            out.push_back(topRight);
+
+            // Second triangle
+            out.push_back(topRight);
+            out.push_back(bottomLeft);
+            out.push_back(bottomRight);
+        }
+    }
+}
+
+void buildGridTriangleList(int samplesX, int samplesZ, std::vector<unsigned int> &out)
+{
+    out.clear();
+    appendGridTriangles(samplesX, 0, 0, samplesX - 1, samplesZ - 1, out);
+}
+
+void buildGridTriangleStrip(int samplesX, int samplesZ, std::vector<uint16_t> &out)
+{
+    out.clear();
+    out.reserve((size_t)(samplesZ - 1) * (2 * samplesX + 1));
+
+    for (int z = 0; z < samplesZ - 1; z++)
+    {
+        // Zig-zag down the row: top, bottom, top, bottom, ...
+        for (int x = 0; x < samplesX; x++)
+        {
+            out.push_back((uint16_t)(z * samplesX + x));
+            out.push_back((uint16_t)((z + 1) * samplesX + x));
+        }
+
+        if (z < samplesZ - 2)
+            out.push_back(PrimitiveRestartIndex16);
+    }
+}
+
+bool stripMatchesTriangleList(const std::vector<uint16_t> &strip, const std::vector<unsigned int> &list)
+{
+    std::vector<Triangle> fromStrip;
+    size_t stripStart = 0;
+    for (size_t i = 0; i <= strip.size(); i++)
+    {
+        if (i < strip.size() && strip[i] != PrimitiveRestartIndex16)
+            continue;
+
+        for (size_t k = stripStart; k + 2 < i; k++)
+        {
+            unsigned int a = strip[k], b = strip[k + 1], c = strip[k + 2];
+            if (a == b || b == c || a == c)
+                continue;
+
+            // GL keeps a consistent winding by swapping the first two vertices of odd triangles
+            if ((k - stripStart) & 1)
+                std::swap(a, b);
+            fromStrip.push_back(canonical(a, b, c));
+        }
+        stripStart = i + 1;
+    }
+
+    std::vector<Triangle> fromList;
+    for (size_t i = 0; i + 2 < list.size(); i += 3)
+        fromList.push_back(canonical(list[i], list[i + 1], list[i + 2]));
+
+    std::sort(fromStrip.begin(), fromStrip.end());
+    std::sort(fromList.begin(), fromList.end());
+    return fromStrip == fromList;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Index value that ends a strip when GL_PRIMITIVE_RESTART is enabled
+constexpr uint16_t PrimitiveRestartIndex16 = 0xFFFF;
+
+// Largest grid side (in samples) whose vertices can be addressed by 16-bit strip indices
+// without colliding with the restart value
+constexpr int MaxStripGridSamples = 255;
+
+// Appends the GL_TRIANGLES list for the quads in [x0, x1) x [z0, z1) of a grid whose rows are
+// rowStride vertices apart, two triangles per quad in the order Terrain::generateMesh uses
+void appendGridTriangles(int rowStride, int x0, int z0, int x1, int z1, std::vector<unsigned int> &out);
+
+// Full triangle list for a samplesX x samplesZ grid
+void buildGridTriangleList(int samplesX, int samplesZ, std::vector<unsigned int> &out);
+
+// One GL_TRIANGLE_STRIP per quad row, separated by PrimitiveRestartIndex16. The strip produces
+// the same triangles with the same winding as buildGridTriangleList, with about a third of the
+// indices at half the size each. samplesX * samplesZ must stay below the restart value.
+void buildGridTriangleStrip(int samplesX, int samplesZ, std::vector<uint16_t> &out);
+
+// Expands a restart-separated strip into triangles the way GL does (odd triangles swap their
+// first two vertices, degenerate triangles are dropped) and checks that it produces exactly the
+// same set of wound triangles as the list
+bool stripMatchesTriangleList(const std::vector<uint16_t> &strip, const std::vector<unsigned int> &list);
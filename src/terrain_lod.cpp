@@ -0,0 +1,193 @@
+#include "terrain_lod.h"
+
+#include <algorithm>
+
+namespace
+{
+    // The coarsest level is always considered in range so the whole map is covered
+    constexpr float UnlimitedRange = 1e30f;
+
+    bool sphereIntersectsBox(const glm::vec3 &center, float radius, const glm::vec3 &boxMin, const glm::vec3 &boxMax)
+    {
+        glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+        glm::vec3 offset = center - closest;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+}
+
+void TerrainQuadtree::build(const float *heights, int w, int h, const TerrainLodSettings &lodSettings)
+{
+    settings = lodSettings;
+    width = w;
+    height = h;
+
+    int cells = std::max(1, std::max(width, height) - 1);
+    levelCount = 1;
+    while (settings.patchSize * (1 << (levelCount - 1)) < cells)
+        levelCount++;
+
+    levels.assign(levelCount, LevelBounds());
+
+    // Leaves read the heightfield directly, including the edge they share with the next leaf
+    LevelBounds &leaves = levels[0];
+    leaves.nodesX = std::max(1, (width - 1 + settings.patchSize - 1) / settings.patchSize);
+    leaves.nodesZ = std::max(1, (height - 1 + settings.patchSize - 1) / settings.patchSize);
+    leaves.minMax.resize((size_t)leaves.nodesX * leaves.nodesZ);
+
+    for (int j = 0; j < leaves.nodesZ; j++)
+    {
+        for (int i = 0; i < leaves.nodesX; i++)
+        {
+            int x0 = i * settings.patchSize, x1 = std::min(x0 + settings.patchSize, width - 1);
+            int z0 = j * settings.patchSize, z1 = std::min(z0 + settings.patchSize, height - 1);
+
+            glm::vec2 range(heights[(size_t)z0 * width + x0]);
+            for (int z = z0; z <= z1; z++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    float y = heights[(size_t)z * width + x];
+                    range.x = std::min(range.x, y);
+                    range.y = std::max(range.y, y);
+                }
+            }
+            leaves.minMax[(size_t)j * leaves.nodesX + i] = range;
+        }
+    }
+
+    // Each coarser level merges up to four children
+    for (int level = 1; level < levelCount; level++)
+    {
+        const LevelBounds &children = levels[level - 1];
+        LevelBounds &parents = levels[level];
+        parents.nodesX = (children.nodesX + 1) / 2;
+        parents.nodesZ = (children.nodesZ + 1) / 2;
+        parents.minMax.resize((size_t)parents.nodesX * parents.nodesZ);
+
+        for (int j = 0; j < parents.nodesZ; j++)
+        {
+            for (int i = 0; i < parents.nodesX; i++)
+            {
+                glm::vec2 range = children.minMax[(size_t)(2 * j) * children.nodesX + 2 * i];
+                for (int q = 1; q < 4; q++)
+                {
+                    int ci = 2 * i + (q & 1), cj = 2 * j + (q >> 1);
+                    if (ci >= children.nodesX || cj >= children.nodesZ)
+                        continue;
+
+                    glm::vec2 child = children.minMax[(size_t)cj * children.nodesX + ci];
+                    range.x = std::min(range.x, child.x);
+                    range.y = std::max(range.y, child.y);
+                }
+                parents.minMax[(size_t)j * parents.nodesX + i] = range;
+            }
+        }
+    }
+
+    ranges.resize(levelCount);
+    for (int level = 0; level < levelCount; level++)
+        ranges[level] = settings.lodDistance * (float)(1 << level);
+    ranges[levelCount - 1] = UnlimitedRange;
+}
+
+glm::vec2 TerrainQuadtree::morphRange(int level) const
+{
+    if (level >= levelCount - 1)
+        return glm::vec2(UnlimitedRange, 2.0f * UnlimitedRange);
+
+    float previous = level > 0 ? ranges[level - 1] : 0.0f;
+    float end = ranges[level];
+    return glm::vec2(previous + (end - previous) * settings.morphStart, end);
+}
+
+bool TerrainQuadtree::nodeExists(int level, int i, int j) const
+{
+    return i < levels[level].nodesX && j < levels[level].nodesZ;
+}
+
+void TerrainQuadtree::nodeBox(int level, int i, int j, glm::vec3 &boxMin, glm::vec3 &boxMax) const
+{
+    int size = settings.patchSize << level;
+    glm::vec2 range = levels[level].minMax[(size_t)j * levels[level].nodesX + i];
+
+    boxMin = glm::vec3((float)(i * size), range.x, (float)(j * size));
+    boxMax = glm::vec3((float)std::min((i + 1) * size, width - 1), range.y, (float)std::min((j + 1) * size, height - 1));
+}
+
+void TerrainQuadtree::select(const glm::vec3 &camera, const Frustum *frustum, std::vector<TerrainLodNode> &out,
+                             TerrainLodStats *stats) const
+{
+    out.clear();
+
+    TerrainLodStats localStats;
+    int top = levelCount - 1;
+    for (int j = 0; j < levels[top].nodesZ; j++)
+        for (int i = 0; i < levels[top].nodesX; i++)
+            selectNode(top, i, j, camera, frustum, out, localStats);
+
+    if (stats)
+    {
+        localStats.nodesSelected = (int)out.size();
+        localStats.triangles = (size_t)localStats.quadrantsDrawn * trianglesPerQuadrant();
+        *stats = localStats;
+    }
+}
+
+bool TerrainQuadtree::selectNode(int level, int i, int j, const glm::vec3 &camera, const Frustum *frustum,
+                                 std::vector<TerrainLodNode> &out, TerrainLodStats &stats) const
+{
+    stats.nodesVisited++;
+
+    glm::vec3 boxMin, boxMax;
+    nodeBox(level, i, j, boxMin, boxMax);
+
+    if (!sphereIntersectsBox(camera, ranges[level], boxMin, boxMax))
+        return false;
+
+    // Culled nodes count as handled so the parent does not draw them either
+    if (frustum && !frustum->intersectsAABB(boxMin, boxMax))
+    {
+        stats.nodesCulled++;
+        return true;
+    }
+
+    TerrainLodNode node;
+    node.x = (int)boxMin.x;
+    node.z = (int)boxMin.z;
+    node.size = settings.patchSize << level;
+    node.level = level;
+    node.minHeight = boxMin.y;
+    node.maxHeight = boxMax.y;
+    node.quadrantMask = 0;
+
+    if (level == 0 || !sphereIntersectsBox(camera, ranges[level - 1], boxMin, boxMax))
+    {
+        // Children are all out of range: draw the whole node at this level, skipping
+        // quadrants that lie entirely past the map edge
+        for (int q = 0; q < 4; q++)
+        {
+            if (level == 0 || nodeExists(level - 1, 2 * i + (q & 1), 2 * j + (q >> 1)))
+                node.quadrantMask |= 1 << q;
+        }
+    }
+    else
+    {
+        // Refine; quadrants whose child is out of range are drawn here instead
+        for (int q = 0; q < 4; q++)
+        {
+            int ci = 2 * i + (q & 1), cj = 2 * j + (q >> 1);
+            if (!nodeExists(level - 1, ci, cj))
+                continue;
+            if (!selectNode(level - 1, ci, cj, camera, frustum, out, stats))
+                node.quadrantMask |= 1 << q;
+        }
+    }
+
+    if (node.quadrantMask)
+    {
+        for (int q = 0; q < 4; q++)
+            stats.quadrantsDrawn += (node.quadrantMask >> q) & 1;
+        out.push_back(node);
+    }
+    return true;
+}
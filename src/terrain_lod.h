@@ -0,0 +1,83 @@
+#pragma once
+
+#include "frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Continuous distance-dependent LOD (CDLOD) over a heightfield.
+//
+// Every node of the quadtree is drawn with the same patchSize x patchSize grid, so a node at
+// level k has a vertex spacing of 2^k cells. A node is refined while its children are within
+// their LOD range of the camera, which keeps the number of selected nodes (and triangles)
+// roughly constant regardless of map size. Near the end of each range vertices morph towards
+// the next coarser grid so there is no popping. Selection is pure CPU code.
+struct TerrainLodSettings
+{
+    int patchSize = 32;         // Quads per node side, also the leaf size in cells
+    float lodDistance = 48.0f;  // Range of the finest level; each coarser level doubles it
+    float morphStart = 0.7f;    // Fraction of a level's range where morphing begins
+};
+
+// One node (or some of its quadrants) picked for drawing this frame
+struct TerrainLodNode
+{
+    int x = 0, z = 0; // Grid origin
+    int size = 0;     // Side length in cells
+    int level = 0;    // 0 = finest
+    uint8_t quadrantMask = 0xF; // Bit q set: draw quadrant q (x-major: 0 = -x-z, 1 = +x-z, 2 = -x+z, 3 = +x+z)
+    float minHeight = 0.0f, maxHeight = 0.0f;
+};
+
+struct TerrainLodStats
+{
+    int nodesVisited = 0;
+    int nodesCulled = 0;
+    int nodesSelected = 0;
+    int quadrantsDrawn = 0;
+    size_t triangles = 0;
+};
+
+class TerrainQuadtree
+{
+public:
+    // Builds per-level min/max heights for a width x height row-major heightfield
+    void build(const float *heights, int width, int height, const TerrainLodSettings &settings);
+
+    // Picks the nodes to draw for a camera position. frustum may be null to skip culling.
+    void select(const glm::vec3 &camera, const Frustum *frustum, std::vector<TerrainLodNode> &out,
+                TerrainLodStats *stats = nullptr) const;
+
+    int getLevelCount() const { return levelCount; }
+    const TerrainLodSettings &getSettings() const { return settings; }
+
+    // Distance from the camera at which a level gives way to the next coarser one
+    float lodRange(int level) const { return ranges[level]; }
+
+    // Distances over which vertices of a level morph into the next level's grid
+    glm::vec2 morphRange(int level) const;
+
+    size_t trianglesPerQuadrant() const { return (size_t)settings.patchSize * settings.patchSize / 2; }
+
+private:
+    struct LevelBounds
+    {
+        int nodesX = 0, nodesZ = 0;
+        std::vector<glm::vec2> minMax; // nodesX * nodesZ (min, max)
+    };
+
+    // Returns false when the node is outside its level's range so the parent must cover it
+    bool selectNode(int level, int i, int j, const glm::vec3 &camera, const Frustum *frustum,
+                    std::vector<TerrainLodNode> &out, TerrainLodStats &stats) const;
+
+    void nodeBox(int level, int i, int j, glm::vec3 &boxMin, glm::vec3 &boxMax) const;
+    bool nodeExists(int level, int i, int j) const;
+
+    TerrainLodSettings settings;
+    int width = 0, height = 0;
+    int levelCount = 0;
+    std::vector<LevelBounds> levels;
+    std::vector<float> ranges;
+};
@@ -0,0 +1,162 @@
+#include "terrain_lod_renderer.h"
+#include "terrain_indices.h"
+#include "uniform_buffers.h"
+
+#include <glad/glad.h>
+
+namespace
+{
+    // Patch vertices only carry their grid coordinate; position, height and normal are rebuilt
+    // from the node uniforms and the heightmap
+    const char *lodVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aGrid;
+
+    uniform sampler2D heightMap;
+    uniform vec4 node;       // origin x, origin z, size in cells, patch size in quads
+    uniform vec2 morphRange; // distances where morphing to the next level starts and ends
+
+    out vec3 FragPos;
+    out vec3 Normal;
+    out vec2 TexCoord;
+
+    float heightAt(vec2 p)
+    {
+        vec2 size = vec2(textureSize(heightMap, 0));
+        return texture(heightMap, (clamp(p, vec2(0.0), size - 1.0) + 0.5) / size).r;
+    }
+
+    void main()
+    {
+        float spacing = node.z / node.w;
+        vec2 world = node.xy + aGrid * spacing;
+
+        // Slide odd vertices onto the next level's grid as the node nears the end of its range
+        float distanceToCamera = distance(viewPos, vec3(world.x, heightAt(world), world.y));
+        float morph = clamp((distanceToCamera - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+        world -= fract(aGrid * 0.5) * 2.0 * spacing * morph;
+
+        // Nodes on the map edge are clamped onto it, collapsing triangles past the edge
+        world = clamp(world, vec2(0.0), vec2(textureSize(heightMap, 0)) - 1.0);
+
+        float y = heightAt(world);
+        Normal = normalize(vec3(heightAt(world - vec2(1.0, 0.0)) - heightAt(world + vec2(1.0, 0.0)), 2.0,
+                                heightAt(world - vec2(0.0, 1.0)) - heightAt(world + vec2(0.0, 1.0))));
+        FragPos = vec3(world.x, y, world.y);
+        TexCoord = world * 0.1;
+
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+    }
+)";
+}
+
+TerrainLodRenderer::TerrainLodRenderer(const float *heights, int width, int height, const char *fragmentSource,
+                                       const TerrainLodSettings &settings)
+{
+    quadtree.build(heights, width, height, settings);
+
+    program = ShaderProgram(addSharedUniformBlocks(lodVertexShaderSource).c_str(), fragmentSource);
+    bindSharedUniformBlocks(program);
+    nodeUniform = program.uniform<glm::vec4>("node");
+    morphRangeUniform = program.uniform<glm::vec2>("morphRange");
+
+    program.setSampler("materials", 0);
+    program.setSampler("heightMap", 4);
+    program.setSampler("splatMap", 5);
+    glUseProgram(0);
+
+    // Heights as a single-channel float texture
+    glGenTextures(1, &heightTexture);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, heights);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // One patch grid shared by every node, indexed quadrant by quadrant so that a node can draw
+    // any subset of its quadrants as contiguous index ranges
+    int patch = settings.patchSize;
+    std::vector<float> grid;
+    grid.reserve((size_t)(patch + 1) * (patch + 1) * 2);
+    for (int z = 0; z <= patch; z++)
+    {
+        for (int x = 0; x <= patch; x++)
+        {
+            grid.push_back((float)x);
+            grid.push_back((float)z);
+        }
+    }
+
+    int half = patch / 2;
+    std::vector<unsigned int> indices;
+    for (int q = 0; q < 4; q++)
+    {
+        int qx = (q & 1) * half, qz = (q >> 1) * half;
+        appendGridTriangles(patch + 1, qx, qz, qx + half, qz + half, indices);
+    }
+    indicesPerQuadrant = half * half * 6;
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, grid.size() * sizeof(float), grid.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    // Grid coordinate attribute
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+}
+
+TerrainLodRenderer::~TerrainLodRenderer()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteTextures(1, &heightTexture);
+}
+
+void TerrainLodRenderer::render(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos)
+{
+    Frustum frustum = Frustum::fromMatrix(projection * view);
+    quadtree.select(viewPos, &frustum, selection, &stats);
+
+    program.use();
+
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+
+    glBindVertexArray(VAO);
+
+    float patch = (float)quadtree.getSettings().patchSize;
+    for (const TerrainLodNode &node : selection)
+    {
+        nodeUniform.set(glm::vec4((float)node.x, (float)node.z, (float)node.size, patch));
+        morphRangeUniform.set(quadtree.morphRange(node.level));
+
+        if (node.quadrantMask == 0xF)
+        {
+            glDrawElements(GL_TRIANGLES, 4 * indicesPerQuadrant, GL_UNSIGNED_INT, 0);
+            continue;
+        }
+
+        for (int q = 0; q < 4; q++)
+        {
+            if (node.quadrantMask & (1 << q))
+                glDrawElements(GL_TRIANGLES, indicesPerQuadrant, GL_UNSIGNED_INT,
+                               (void *)(q * indicesPerQuadrant * sizeof(unsigned int)));
+        }
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+}
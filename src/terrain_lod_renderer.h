@@ -0,0 +1,47 @@
+#pragma once
+
+#include "shader_program.h"
+#include "terrain_lod.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Draws a heightfield with CDLOD: one shared patch mesh, heights read from a float texture in
+// the vertex shader, one draw per selected node quadrant.
+class TerrainLodRenderer
+{
+public:
+    // Uploads the heightfield and builds the quadtree; fragmentSource is the regular terrain
+    // fragment shader, shared uniform blocks included (the LOD vertex shader produces the same
+    // FragPos/Normal/TexCoord outputs)
+    TerrainLodRenderer(const float *heights, int width, int height, const char *fragmentSource,
+                       const TerrainLodSettings &settings = TerrainLodSettings());
+    ~TerrainLodRenderer();
+
+    TerrainLodRenderer(const TerrainLodRenderer &) = delete;
+    TerrainLodRenderer &operator=(const TerrainLodRenderer &) = delete;
+
+    // Selects nodes for this camera and draws them. The frame and object uniform blocks
+    // (uniform_buffers.h) and the terrain textures must already be bound: materials to unit 0 (and
+    // the splat map to unit 5 for a BAKED_SPLAT fragment shader); the heightmap uses unit 4.
+    // Leaves the LOD program bound.
+    void render(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos);
+
+    const TerrainLodStats &getStats() const { return stats; }
+    const TerrainQuadtree &getQuadtree() const { return quadtree; }
+    const ShaderProgram &getProgram() const { return program; }
+
+private:
+    TerrainQuadtree quadtree;
+    std::vector<TerrainLodNode> selection;
+    TerrainLodStats stats;
+
+    ShaderProgram program;
+    unsigned int heightTexture = 0;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    int indicesPerQuadrant = 0;
+
+    Uniform<glm::vec4> nodeUniform;
+    Uniform<glm::vec2> morphRangeUniform;
+};
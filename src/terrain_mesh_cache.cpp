@@ -0,0 +1,177 @@
+#include "terrain_mesh_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    constexpr char MeshCacheMagic[4] = {'R', 'T', 'M', 'C'};
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+void Fnv1a::add(const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+uint64_t terrainMeshCacheKey(const NoiseSettings *noise, int width, int height)
+{
+    Fnv1a hash;
+    hash.addValue(TerrainMeshCacheVersion);
+    hash.addValue(width);
+    hash.addValue(height);
+
+    if (!noise)
+    {
+        hash.add(std::string("sine"));
+        return hash.value();
+    }
+
+    hash.add(std::string("simplex"));
+    hash.addValue(noise->seed);
+    hash.addValue((int)noise->fractal);
+    hash.addValue(noise->octaves);
+    hash.addValue(noise->frequency);
+    hash.addValue(noise->lacunarity);
+    hash.addValue(noise->gain);
+    hash.addValue(noise->amplitude);
+    hash.addValue(noise->warpStrength);
+    hash.addValue(noise->warpFrequency);
+    return hash.value();
+}
+
+std::string terrainMeshCachePath(const std::string &directory, uint64_t key)
+{
+    char name[40];
+    std::snprintf(name, sizeof(name), "terrain_%016llx.rtmc", (unsigned long long)key);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool writeTerrainMeshCache(const std::string &path, uint64_t key, int width, int height, const float *heights,
+                           const float *vertices, int floatsPerVertex, const unsigned int *indices, size_t indexCount)
+{
+    size_t sampleCount = (size_t)width * height;
+
+    TerrainMeshCacheHeader header = {};
+    std::memcpy(header.magic, MeshCacheMagic, sizeof(header.magic));
+    header.version = TerrainMeshCacheVersion;
+    header.key = key;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.floatsPerVertex = (uint32_t)floatsPerVertex;
+    header.indexCount = indexCount;
+    header.heightsOffset = alignUp(sizeof(header), 64);
+    header.verticesOffset = alignUp(header.heightsOffset + sampleCount * sizeof(float), 64);
+    header.indicesOffset = alignUp(header.verticesOffset + sampleCount * floatsPerVertex * sizeof(float), 64);
+
+    std::error_code error;
+    std::filesystem::path target(path);
+    if (target.has_parent_path())
+        std::filesystem::create_directories(target.parent_path(), error);
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cerr << "Failed to create terrain mesh cache " << temporary << std::endl;
+            return false;
+        }
+
+        auto writeAt = [&](uint64_t offset, const void *data, size_t size)
+        {
+            // Zero padding up to the aligned offset
+            static const char zeros[64] = {};
+            file.write(zeros, (std::streamsize)(offset - (uint64_t)file.tellp()));
+            file.write(static_cast<const char *>(data), (std::streamsize)size);
+        };
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        writeAt(header.heightsOffset, heights, sampleCount * sizeof(float));
+        writeAt(header.verticesOffset, vertices, sampleCount * floatsPerVertex * sizeof(float));
+        writeAt(header.indicesOffset, indices, indexCount * sizeof(unsigned int));
+
+        if (!file.good())
+        {
+            std::cerr << "Failed to write terrain mesh cache " << temporary << std::endl;
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::cerr << "Failed to rename terrain mesh cache to " << path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+bool TerrainMeshCache::open(const std::string &path, uint64_t key, int floatsPerVertex)
+{
+    header = nullptr;
+
+    std::error_code error;
+    if (!std::filesystem::exists(path, error) || !file.open(path.c_str()))
+        return false;
+
+    auto reject = [&](const char *reason)
+    {
+        std::cerr << "Ignoring terrain mesh cache " << path << ": " << reason << std::endl;
+        file.close();
+        header = nullptr;
+        return false;
+    };
+
+    if (file.size() < sizeof(TerrainMeshCacheHeader))
+        return reject("file too small");
+
+    header = reinterpret_cast<const TerrainMeshCacheHeader *>(file.data());
+    if (std::memcmp(header->magic, MeshCacheMagic, sizeof(header->magic)) != 0)
+        return reject("not a mesh cache");
+    if (header->version != TerrainMeshCacheVersion || header->key != key)
+        return reject("built with different parameters");
+    if (header->width < 2 || header->height < 2)
+        return reject("inconsistent dimensions");
+    if (header->floatsPerVertex != (uint32_t)floatsPerVertex)
+        return reject("different vertex format");
+
+    uint64_t sampleCount = (uint64_t)header->width * header->height;
+    if (header->heightsOffset % 64 != 0 || header->verticesOffset % 64 != 0 || header->indicesOffset % 64 != 0 ||
+        header->heightsOffset + sampleCount * sizeof(float) > file.size() ||
+        header->verticesOffset + sampleCount * header->floatsPerVertex * sizeof(float) > file.size() ||
+        header->indicesOffset + header->indexCount * sizeof(unsigned int) > file.size())
+        return reject("truncated");
+
+    return true;
+}
+
+const float *TerrainMeshCache::heights() const
+{
+    return reinterpret_cast<const float *>(file.data() + header->heightsOffset);
+}
+
+const float *TerrainMeshCache::vertices() const
+{
+    return reinterpret_cast<const float *>(file.data() + header->verticesOffset);
+}
+
+const unsigned int *TerrainMeshCache::indices() const
+{
+    return reinterpret_cast<const unsigned int *>(file.data() + header->indicesOffset);
+}
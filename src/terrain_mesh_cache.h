@@ -0,0 +1,78 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "terrain_noise.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Bump whenever the terrain mesh builder changes what it produces (vertex layout, normals, index
+// order), so stale cache files stop matching
+constexpr uint32_t TerrainMeshCacheVersion = 2;
+
+// 64-bit FNV-1a, fed field by field so struct padding never reaches the hash
+class Fnv1a
+{
+public:
+    void add(const void *data, size_t size);
+    void add(const std::string &text) { add(text.data(), text.size()); }
+
+    template <typename T>
+    void addValue(const T &value) { add(&value, sizeof(value)); }
+
+    uint64_t value() const { return hash; }
+
+private:
+    uint64_t hash = 14695981039346656037ull;
+};
+
+// Key for a generated terrain: the height source (noise == nullptr for the sine pattern), the
+// grid size and the cache version
+uint64_t terrainMeshCacheKey(const NoiseSettings *noise, int width, int height);
+
+// "<directory>/terrain_<key in hex>.rtmc"
+std::string terrainMeshCachePath(const std::string &directory, uint64_t key);
+
+struct TerrainMeshCacheHeader
+{
+    char magic[4]; // "RTMC"
+    uint32_t version;
+    uint64_t key;
+    uint32_t width, height;
+    uint32_t floatsPerVertex;
+    uint32_t reserved;
+    uint64_t indexCount;
+    uint64_t heightsOffset;  // width * height floats
+    uint64_t verticesOffset; // width * height * floatsPerVertex floats (interleaved, normals included)
+    uint64_t indicesOffset;  // indexCount unsigned ints
+};
+
+static_assert(sizeof(TerrainMeshCacheHeader) == 64, "mesh cache header layout is part of the file format");
+
+// Writes a finished terrain mesh. The file is written under a temporary name and renamed, so an
+// interrupted write never leaves a truncated cache behind. Returns false on I/O failure.
+bool writeTerrainMeshCache(const std::string &path, uint64_t key, int width, int height, const float *heights,
+                           const float *vertices, int floatsPerVertex, const unsigned int *indices, size_t indexCount);
+
+// A cache file mapped for reading; the buffers point straight into the mapping
+class TerrainMeshCache
+{
+public:
+    // Returns false without printing when the file doesn't exist (an ordinary miss), and prints
+    // why when it exists but doesn't match key and the caller's vertex format, or is damaged
+    bool open(const std::string &path, uint64_t key, int floatsPerVertex);
+
+    int getWidth() const { return (int)header->width; }
+    int getHeight() const { return (int)header->height; }
+    int getFloatsPerVertex() const { return (int)header->floatsPerVertex; }
+    size_t getIndexCount() const { return (size_t)header->indexCount; }
+
+    const float *heights() const;
+    const float *vertices() const;
+    const unsigned int *indices() const;
+
+private:
+    MappedFile file;
+    const TerrainMeshCacheHeader *header = nullptr;
+};
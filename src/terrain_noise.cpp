@@ -0,0 +1,302 @@
+#include "terrain_noise.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Skew/unskew factors for the 2D simplex grid
+    constexpr float F2 = 0.36602540378f; // (sqrt(3) - 1) / 2
+    constexpr float G2 = 0.21132486540f; // (3 - sqrt(3)) / 6
+    constexpr float G2x2 = 2.0f * G2;
+
+    // Brings the sum of the three corner contributions to roughly [-1, 1]
+    constexpr float SimplexScale = 45.0f;
+
+    // Seeds for the octaves and the two warp fields are derived from the base seed
+    constexpr uint32_t OctaveSeedStep = 0x9E3779B9u;
+    constexpr uint32_t WarpSeedX = 0x68E31DA4u;
+    constexpr uint32_t WarpSeedZ = 0xB5297A4Du;
+
+    uint32_t hashCell(int32_t i, int32_t j, uint32_t seed)
+    {
+        uint32_t h = seed;
+        h ^= (uint32_t)i * 0x27D4EB2Du;
+        h ^= (uint32_t)j * 0x165667B1u;
+        h ^= h >> 15;
+        h *= 0x2C1B3C6Du;
+        h ^= h >> 12;
+        h *= 0x297A2D39u;
+        h ^= h >> 15;
+        return h;
+    }
+
+    // Dot product with one of eight gradients picked by the low hash bits
+    float gradient(uint32_t h, float x, float y)
+    {
+        float u = (h & 4) ? y : x;
+        float v = (h & 4) ? x : y;
+        float a = (h & 1) ? -u : u;
+        float b = (h & 2) ? -(2.0f * v) : 2.0f * v;
+        return a + b;
+    }
+
+    float corner(uint32_t h, float x, float y)
+    {
+        float t = 0.5f - x * x - y * y;
+        t = std::max(t, 0.0f);
+        t = t * t;
+        return t * t * gradient(h, x, y);
+    }
+
+    float simplexScalar(float x, float y, uint32_t seed)
+    {
+        float s = (x + y) * F2;
+        float fi = std::floor(x + s);
+        float fj = std::floor(y + s);
+        float t = (fi + fj) * G2;
+        float x0 = x - (fi - t);
+        float y0 = y - (fj - t);
+
+        // Which of the two triangles in the skewed cell we are in
+        float i1 = x0 > y0 ? 1.0f : 0.0f;
+        float j1 = 1.0f - i1;
+
+        float x1 = (x0 - i1) + G2;
+        float y1 = (y0 - j1) + G2;
+        float x2 = (x0 - 1.0f) + G2x2;
+        float y2 = (y0 - 1.0f) + G2x2;
+
+        int32_t i = (int32_t)fi;
+        int32_t j = (int32_t)fj;
+        float n = corner(hashCell(i, j, seed), x0, y0) +
+                  corner(hashCell(i + (int32_t)i1, j + (int32_t)j1, seed), x1, y1);
+        n = n + corner(hashCell(i + 1, j + 1, seed), x2, y2);
+        return n * SimplexScale;
+    }
+
+#if RACING_SIMD_X86
+    RACING_TARGET_AVX2 __m256i hashCellAVX2(__m256i i, __m256i j, __m256i seed)
+    {
+        __m256i h = _mm256_xor_si256(seed, _mm256_mullo_epi32(i, _mm256_set1_epi32((int)0x27D4EB2Du)));
+        h = _mm256_xor_si256(h, _mm256_mullo_epi32(j, _mm256_set1_epi32((int)0x165667B1u)));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0x2C1B3C6Du));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0x297A2D39u));
+        return _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    }
+
+    RACING_TARGET_AVX2 __m256 cornerAVX2(__m256i h, __m256 x, __m256 y)
+    {
+        __m256i zero = _mm256_setzero_si256();
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(4)), zero));
+        __m256 u = _mm256_blendv_ps(y, x, swap);
+        __m256 v = _mm256_blendv_ps(x, y, swap);
+        __m256 signU = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+        __m256 signV = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+        __m256 a = _mm256_xor_ps(u, signU);
+        __m256 b = _mm256_xor_ps(_mm256_mul_ps(_mm256_set1_ps(2.0f), v), signV);
+        __m256 g = _mm256_add_ps(a, b);
+
+        __m256 t = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(x, x)), _mm256_mul_ps(y, y));
+        t = _mm256_max_ps(t, _mm256_setzero_ps());
+        t = _mm256_mul_ps(t, t);
+        return _mm256_mul_ps(_mm256_mul_ps(t, t), g);
+    }
+
+    RACING_TARGET_AVX2 void simplexAVX2(const float *xs, const float *ys, int count, uint32_t seed, float *out)
+    {
+        __m256i seedv = _mm256_set1_epi32((int)seed);
+        __m256 one = _mm256_set1_ps(1.0f);
+        __m256 g2 = _mm256_set1_ps(G2);
+        __m256 g2x2 = _mm256_set1_ps(G2x2);
+
+        int k = 0;
+        for (; k + 8 <= count; k += 8)
+        {
+            __m256 x = _mm256_loadu_ps(xs + k);
+            __m256 y = _mm256_loadu_ps(ys + k);
+
+            __m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(F2));
+            __m256 fi = _mm256_floor_ps(_mm256_add_ps(x, s));
+            __m256 fj = _mm256_floor_ps(_mm256_add_ps(y, s));
+            __m256 t = _mm256_mul_ps(_mm256_add_ps(fi, fj), g2);
+            __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(fi, t));
+            __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(fj, t));
+
+            __m256 i1 = _mm256_and_ps(_mm256_cmp_ps(x0, y0, _CMP_GT_OQ), one);
+            __m256 j1 = _mm256_sub_ps(one, i1);
+
+            __m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, i1), g2);
+            __m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, j1), g2);
+            __m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, one), g2x2);
+            __m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, one), g2x2);
+
+            __m256i i = _mm256_cvttps_epi32(fi);
+            __m256i j = _mm256_cvttps_epi32(fj);
+            __m256i ione = _mm256_set1_epi32(1);
+
+            __m256 n = _mm256_add_ps(
+                cornerAVX2(hashCellAVX2(i, j, seedv), x0, y0),
+                cornerAVX2(hashCellAVX2(_mm256_add_epi32(i, _mm256_cvttps_epi32(i1)),
+                                        _mm256_add_epi32(j, _mm256_cvttps_epi32(j1)), seedv),
+                           x1, y1));
+            n = _mm256_add_ps(n, cornerAVX2(hashCellAVX2(_mm256_add_epi32(i, ione), _mm256_add_epi32(j, ione), seedv), x2, y2));
+            _mm256_storeu_ps(out + k, _mm256_mul_ps(n, _mm256_set1_ps(SimplexScale)));
+        }
+
+        for (; k < count; k++)
+            out[k] = simplexScalar(xs[k], ys[k], seed);
+    }
+#endif
+}
+
+TerrainNoise::TerrainNoise(const NoiseSettings &settings) : settings(settings)
+{
+    // Normalise the octave sum so that the fractal stays in the range of a single octave
+    float total = 0.0f;
+    float amplitude = 1.0f;
+    for (int octave = 0; octave < settings.octaves; octave++)
+    {
+        total += amplitude;
+        amplitude *= settings.gain;
+    }
+    fractalNormalization = total > 0.0f ? 1.0f / total : 0.0f;
+}
+
+float TerrainNoise::simplex(float x, float y, uint32_t seed) const
+{
+    return simplexScalar(x, y, seed);
+}
+
+void TerrainNoise::simplexBatch(const float *xs, const float *ys, int count, uint32_t seed, float *out, SimdLevel level)
+{
+#if RACING_SIMD_X86
+    if (level == SimdLevel::AVX2 && detectSimdLevel() == SimdLevel::AVX2)
+        return simplexAVX2(xs, ys, count, seed, out);
+#endif
+    for (int k = 0; k < count; k++)
+        out[k] = simplexScalar(xs[k], ys[k], seed);
+}
+
+void TerrainNoise::fractalBatch(const float *xs, const float *zs, int count, float *out) const
+{
+    float tx[BatchSize], tz[BatchSize], noise[BatchSize];
+
+    std::fill(out, out + count, 0.0f);
+
+    float frequency = settings.frequency;
+    float amplitude = 1.0f;
+    for (int octave = 0; octave < settings.octaves; octave++)
+    {
+        for (int k = 0; k < count; k++)
+        {
+            tx[k] = xs[k] * frequency;
+            tz[k] = zs[k] * frequency;
+        }
+        simplexBatch(tx, tz, count, settings.seed + octave * OctaveSeedStep, noise);
+
+        if (settings.fractal == NoiseFractal::Ridged)
+        {
+            for (int k = 0; k < count; k++)
+            {
+                float ridge = 1.0f - std::fabs(noise[k]);
+                out[k] += ridge * ridge * amplitude;
+            }
+        }
+        else
+        {
+            for (int k = 0; k < count; k++)
+                out[k] += noise[k] * amplitude;
+        }
+
+        frequency *= settings.lacunarity;
+        amplitude *= settings.gain;
+    }
+
+    float scale = settings.amplitude * fractalNormalization;
+    for (int k = 0; k < count; k++)
+        out[k] *= scale;
+}
+
+void TerrainNoise::warpedBatch(float *xs, float *zs, int count, float *out) const
+{
+    if (settings.warpStrength != 0.0f)
+    {
+        // Zeroed: GCC can't tell simplexBatch only reads the first count entries
+        float wx[BatchSize] = {}, wz[BatchSize] = {}, dx[BatchSize], dz[BatchSize];
+        for (int k = 0; k < count; k++)
+        {
+            wx[k] = xs[k] * settings.warpFrequency;
+            wz[k] = zs[k] * settings.warpFrequency;
+        }
+        simplexBatch(wx, wz, count, settings.seed ^ WarpSeedX, dx);
+        simplexBatch(wx, wz, count, settings.seed ^ WarpSeedZ, dz);
+        for (int k = 0; k < count; k++)
+        {
+            xs[k] = xs[k] + dx[k] * settings.warpStrength;
+            zs[k] = zs[k] + dz[k] * settings.warpStrength;
+        }
+    }
+
+    fractalBatch(xs, zs, count, out);
+}
+
+float TerrainNoise::sample(float x, float z) const
+{
+    // Goes through the batch path so single-point queries match sampleRow exactly
+    float height;
+    warpedBatch(&x, &z, 1, &height);
+    return height;
+}
+
+void TerrainNoise::sampleRow(int x0, int z, int count, float *out) const
+{
+    sampleStridedRow(x0, z, 1, count, out);
+}
+
+void TerrainNoise::sampleStridedRow(int x0, int z, int step, int count, float *out) const
+{
+    float xs[BatchSize], zs[BatchSize];
+
+    for (int start = 0; start < count; start += BatchSize)
+    {
+        int n = std::min(BatchSize, count - start);
+        for (int k = 0; k < n; k++)
+        {
+            xs[k] = (float)(x0 + (start + k) * step);
+            zs[k] = (float)z;
+        }
+        warpedBatch(xs, zs, n, out + start);
+    }
+}
+
+void TerrainNoise::sampleRect(int x0, int z0, int w, int h, float *out, size_t rowStride, ThreadPool *pool) const
+{
+    auto rows = [&](int zBegin, int zEnd)
+    {
+        for (int z = zBegin; z < zEnd; z++)
+            sampleRow(x0, z0 + z, w, out + (size_t)z * rowStride);
+    };
+
+    if (pool)
+        pool->parallelFor(0, h, 8, rows);
+    else
+        rows(0, h);
+}
+
+HeightRowFunction TerrainNoise::rowFunction() const
+{
+    TerrainNoise noise = *this;
+    return [noise](int x0, int z, int count, float *out)
+    { noise.sampleRow(x0, z, count, out); };
+}
+
+HeightStridedRowFunction TerrainNoise::stridedRowFunction() const
+{
+    TerrainNoise noise = *this;
+    return [noise](int x0, int z, int step, int count, float *out)
+    { noise.sampleStridedRow(x0, z, step, count, out); };
+}
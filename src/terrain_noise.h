@@ -0,0 +1,82 @@
+#pragma once
+
+#include "heightfield.h"
+#include "simd.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+enum class NoiseFractal
+{
+    FBm,   // Sum of octaves, roughly in [-1, 1]
+    Ridged // Sharp crests from 1 - |noise|, in [0, 1]
+};
+
+// Everything that determines the generated terrain. Two machines with the same settings
+// produce bit-identical heights, so only these need to go over the wire.
+struct NoiseSettings
+{
+    uint32_t seed = 1337;
+    NoiseFractal fractal = NoiseFractal::FBm;
+    int octaves = 5;
+    float frequency = 0.02f; // Base frequency in cycles per grid cell
+    float lacunarity = 2.0f; // Frequency multiplier per octave
+    float gain = 0.5f;       // Amplitude multiplier per octave
+    float amplitude = 6.0f;  // World-space height scale
+    float warpStrength = 0.0f; // Domain warp offset in grid cells (0 disables warping)
+    float warpFrequency = 0.01f;
+};
+
+// Seedable 2D simplex noise with fBm/ridged octaves and domain warping.
+//
+// Lattice gradients come from an integer hash of (cell, seed) rather than a shuffled table, so
+// evaluation uses only integer ops, float add/mul and floor. Together with -ffp-contract=off this
+// makes results independent of platform, thread count and SIMD level (scalar and AVX2 paths
+// perform identical operations).
+class TerrainNoise
+{
+public:
+    explicit TerrainNoise(const NoiseSettings &settings = NoiseSettings());
+
+    const NoiseSettings &getSettings() const { return settings; }
+
+    // Single octave of simplex noise, roughly in [-1, 1]
+    float simplex(float x, float y, uint32_t seed) const;
+
+    // Terrain height at a grid position (warp, octaves and amplitude applied)
+    float sample(float x, float z) const;
+
+    // Evaluates count grid cells of row z starting at column x0 (matches HeightRowFunction)
+    void sampleRow(int x0, int z, int count, float *out) const;
+
+    // Evaluates count cells of row z at columns x0, x0 + step, ... (matches HeightStridedRowFunction)
+    void sampleStridedRow(int x0, int z, int step, int count, float *out) const;
+
+    // Evaluates the rectangle [x0, x0 + w) x [z0, z0 + h) into out, rowStride floats apart.
+    // Rows are spread across pool when one is given.
+    void sampleRect(int x0, int z0, int w, int h, float *out, size_t rowStride, ThreadPool *pool = nullptr) const;
+
+    // Adapter for generateHeightfield; the returned function holds its own copy of the noise
+    HeightRowFunction rowFunction() const;
+
+    // Strided counterpart of rowFunction, for sparse grids such as coarse clipmap levels
+    HeightStridedRowFunction stridedRowFunction() const;
+
+    // Batch simplex over SoA coordinates: out[i] = simplex(xs[i], ys[i], seed)
+    static void simplexBatch(const float *xs, const float *ys, int count, uint32_t seed, float *out,
+                             SimdLevel level = detectSimdLevel());
+
+private:
+    // Applies the domain warp to the coordinates in place, then evaluates the fractal (count <= BatchSize)
+    void warpedBatch(float *xs, float *zs, int count, float *out) const;
+
+    // Fractal sum over precomputed coordinates, count <= BatchSize
+    void fractalBatch(const float *xs, const float *zs, int count, float *out) const;
+
+    static constexpr int BatchSize = 256;
+
+    NoiseSettings settings;
+    float fractalNormalization;
+};
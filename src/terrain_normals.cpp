@@ -0,0 +1,158 @@
+#include "terrain_normals.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    void storeNormal(float dx, float dz, float *out)
+    {
+        float invLength = 1.0f / std::sqrt(dx * dx + 4.0f + dz * dz);
+        out[0] = dx * invLength;
+        out[1] = 2.0f * invLength;
+        out[2] = dz * invLength;
+    }
+
+    void normalRowScalar(const float *above, const float *center, const float *below, int count, float *out,
+                         size_t stride)
+    {
+        for (int i = 0; i < count; i++)
+            storeNormal(center[i - 1] - center[i + 1], above[i] - below[i], out + i * stride);
+    }
+
+#if RACING_SIMD_X86
+    void normalRowSSE2(const float *above, const float *center, const float *below, int count, float *out,
+                       size_t stride)
+    {
+        int i = 0;
+        alignas(16) float nx[4], ny[4], nz[4];
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(center + i - 1), _mm_loadu_ps(center + i + 1));
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(above + i), _mm_loadu_ps(below + i));
+            __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_set1_ps(4.0f)), _mm_mul_ps(dz, dz));
+            __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+
+            _mm_store_ps(nx, _mm_mul_ps(dx, invLength));
+            _mm_store_ps(ny, _mm_mul_ps(_mm_set1_ps(2.0f), invLength));
+            _mm_store_ps(nz, _mm_mul_ps(dz, invLength));
+
+            // Interleave into the strided output
+            for (int lane = 0; lane < 4; lane++)
+            {
+                float *normal = out + (i + lane) * stride;
+                normal[0] = nx[lane];
+                normal[1] = ny[lane];
+                normal[2] = nz[lane];
+            }
+        }
+        normalRowScalar(above + i, center + i, below + i, count - i, out + i * stride, stride);
+    }
+
+    RACING_TARGET_AVX2 void normalRowAVX2(const float *above, const float *center, const float *below, int count,
+                                          float *out, size_t stride)
+    {
+        int i = 0;
+        alignas(32) float nx[8], ny[8], nz[8];
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(center + i - 1), _mm256_loadu_ps(center + i + 1));
+            __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(above + i), _mm256_loadu_ps(below + i));
+            __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_set1_ps(4.0f)),
+                                                 _mm256_mul_ps(dz, dz));
+            __m256 invLength = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSquared));
+
+            _mm256_store_ps(nx, _mm256_mul_ps(dx, invLength));
+            _mm256_store_ps(ny, _mm256_mul_ps(_mm256_set1_ps(2.0f), invLength));
+            _mm256_store_ps(nz, _mm256_mul_ps(dz, invLength));
+
+            for (int lane = 0; lane < 8; lane++)
+            {
+                float *normal = out + (i + lane) * stride;
+                normal[0] = nx[lane];
+                normal[1] = ny[lane];
+                normal[2] = nz[lane];
+            }
+        }
+        normalRowSSE2(above + i, center + i, below + i, count - i, out + i * stride, stride);
+    }
+#endif
+
+    // Edge samples with clamped neighbours
+    void edgeNormal(const float *heights, int width, int height, int x, int z, float *out)
+    {
+        const float *row = heights + (size_t)z * width;
+        float left = row[std::max(x - 1, 0)];
+        float right = row[std::min(x + 1, width - 1)];
+        float above = heights[(size_t)std::max(z - 1, 0) * width + x];
+        float below = heights[(size_t)std::min(z + 1, height - 1) * width + x];
+        storeNormal(left - right, above - below, out);
+    }
+}
+
+void computeNormalRow(const float *above, const float *center, const float *below, int count, float *out,
+                      size_t stride, SimdLevel level)
+{
+    if (level > detectSimdLevel())
+        level = detectSimdLevel();
+
+#if RACING_SIMD_X86
+    if (level == SimdLevel::AVX2)
+        return normalRowAVX2(above, center, below, count, out, stride);
+    if (level == SimdLevel::SSE2)
+        return normalRowSSE2(above, center, below, count, out, stride);
+#endif
+    normalRowScalar(above, center, below, count, out, stride);
+}
+
+void computeNormalsRect(const float *heights, int width, int height, int x0, int z0, int x1, int z1, float *out,
+                        size_t stride, ThreadPool *pool)
+{
+    x0 = std::max(x0, 0);
+    z0 = std::max(z0, 0);
+    x1 = std::min(x1, width);
+    z1 = std::min(z1, height);
+    if (x0 >= x1 || z0 >= z1)
+        return;
+
+    // Columns with both horizontal neighbours inside the grid go through the row kernel
+    int innerBegin = std::max(x0, 1);
+    int innerEnd = std::min(x1, width - 1);
+
+    auto rows = [&](int zBegin, int zEnd)
+    {
+        for (int z = zBegin; z < zEnd; z++)
+        {
+            const float *center = heights + (size_t)z * width;
+            const float *above = heights + (size_t)std::max(z - 1, 0) * width;
+            const float *below = heights + (size_t)std::min(z + 1, height - 1) * width;
+            float *rowOut = out + (size_t)z * width * stride;
+
+            if (innerBegin < innerEnd)
+                computeNormalRow(above + innerBegin, center + innerBegin, below + innerBegin, innerEnd - innerBegin,
+                                 rowOut + innerBegin * stride, stride);
+
+            if (x0 == 0)
+                edgeNormal(heights, width, height, 0, z, rowOut);
+            if (x1 == width && width > 1)
+                edgeNormal(heights, width, height, width - 1, z, rowOut + (size_t)(width - 1) * stride);
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(z0, z1, 16, rows);
+    else
+        rows(z0, z1);
+}
+
+void computeNormals(const float *heights, int width, int height, float *out, size_t stride, ThreadPool *pool)
+{
+    computeNormalsRect(heights, width, height, 0, 0, width, height, out, stride, pool);
+}
+
+void updateNormalsForDirtyRect(const float *heights, int width, int height, int x0, int z0, int x1, int z1,
+                               float *out, size_t stride, ThreadPool *pool)
+{
+    // A height feeds the normals of its four neighbours as well as its own
+    computeNormalsRect(heights, width, height, x0 - 1, z0 - 1, x1 + 1, z1 + 1, out, stride, pool);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "simd.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+
+// Heightfield normals from central differences over a 2-cell baseline:
+//   normalize(h(x-1, z) - h(x+1, z), 2, h(x, z-1) - h(x, z+1))
+// Normalization uses 1 / sqrt like glm::normalize and the SIMD paths avoid FMA, so every level
+// writes bit-identical normals.
+
+// One row of normals. center[-1] and center[count] must be readable; above and below are the
+// neighbouring rows aligned with center. Normal i is written to out[i * stride .. i * stride + 2].
+void computeNormalRow(const float *above, const float *center, const float *below, int count, float *out,
+                      size_t stride, SimdLevel level = detectSimdLevel());
+
+// Normals for the samples in [x0, x1) x [z0, z1) of a width x height heightfield, clamping
+// neighbours to the grid edge. The normal of sample (x, z) goes to out + (z * width + x) * stride,
+// so it can be written straight into an interleaved vertex buffer. Rows are spread over pool
+// when one is given.
+void computeNormalsRect(const float *heights, int width, int height, int x0, int z0, int x1, int z1, float *out,
+                        size_t stride, ThreadPool *pool = nullptr);
+
+// Normals for the whole heightfield
+void computeNormals(const float *heights, int width, int height, float *out, size_t stride, ThreadPool *pool = nullptr);
+
+// Recomputes only the normals affected by a height edit in [x0, x1) x [z0, z1): the rectangle
+// grown by one sample on each side, clamped to the grid
+void updateNormalsForDirtyRect(const float *heights, int width, int height, int x0, int z0, int x1, int z1,
+                               float *out, size_t stride, ThreadPool *pool = nullptr);
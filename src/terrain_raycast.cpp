@@ -0,0 +1,350 @@
+#include "terrain_raycast.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Clips [tNear, tFar] to the slab lo <= origin + t * direction <= hi on one axis
+    bool clipSlab(float origin, float direction, float inverse, float lo, float hi, float &tNear, float &tFar)
+    {
+        if (direction == 0.0f)
+            return origin >= lo && origin <= hi;
+
+        float a = (lo - origin) * inverse;
+        float b = (hi - origin) * inverse;
+        if (a > b)
+            std::swap(a, b);
+        tNear = std::max(tNear, a);
+        tFar = std::min(tFar, b);
+        return tNear <= tFar;
+    }
+}
+
+struct TerrainHeightPyramid::Packet
+{
+    Ray rays[PacketSize];
+    TerrainRayHit hits[PacketSize];
+    float best[PacketSize];
+    glm::vec3 direction; // Sum of the directions, picks the child order
+};
+
+void TerrainHeightPyramid::build(const float *heightData, int w, int h, ThreadPool *pool)
+{
+    heights = heightData;
+    width = w;
+    height = h;
+    levels.clear();
+    if (width < 2 || height < 2)
+        return;
+
+    // Cell ranges come straight from the four corners, which the cell test loads anyway, so
+    // level 0 stores nothing and the pyramid costs 2 bytes per sample instead of 10
+    Level cells;
+    cells.nodesX = width - 1;
+    cells.nodesZ = height - 1;
+    levels.push_back(std::move(cells));
+
+    while (levels.back().nodesX > 1 || levels.back().nodesZ > 1)
+    {
+        Level parents;
+        parents.nodesX = (levels.back().nodesX + 1) / 2;
+        parents.nodesZ = (levels.back().nodesZ + 1) / 2;
+        parents.minMax.resize((size_t)parents.nodesX * parents.nodesZ);
+        levels.push_back(std::move(parents));
+
+        int level = (int)levels.size() - 1;
+        auto rows = [&](int first, int last)
+        {
+            reduceLevel(level, 0, first, levels[level].nodesX, last);
+        };
+        if (pool && level == 1)
+            pool->parallelFor(0, levels[level].nodesZ, 64, rows);
+        else
+            rows(0, levels[level].nodesZ);
+    }
+}
+
+glm::vec2 TerrainHeightPyramid::nodeRange(int level, int i, int j) const
+{
+    if (level > 0)
+        return levels[level].minMax[(size_t)j * levels[level].nodesX + i];
+
+    // A bilinear cell never leaves the range of its four corners
+    const float *row = heights + (size_t)j * width + i;
+    return glm::vec2(std::min(std::min(row[0], row[1]), std::min(row[width], row[width + 1])),
+                     std::max(std::max(row[0], row[1]), std::max(row[width], row[width + 1])));
+}
+
+void TerrainHeightPyramid::reduceLevel(int level, int i0, int j0, int i1, int j1)
+{
+    Level &target = levels[level];
+    for (int j = j0; j < j1; j++)
+    {
+        for (int i = i0; i < i1; i++)
+        {
+            const Level &children = levels[level - 1];
+            glm::vec2 range(INFINITY, -INFINITY);
+            for (int cj = 2 * j; cj < std::min(2 * j + 2, children.nodesZ); cj++)
+            {
+                for (int ci = 2 * i; ci < std::min(2 * i + 2, children.nodesX); ci++)
+                {
+                    glm::vec2 child = nodeRange(level - 1, ci, cj);
+                    range.x = std::min(range.x, child.x);
+                    range.y = std::max(range.y, child.y);
+                }
+            }
+            target.minMax[(size_t)j * target.nodesX + i] = range;
+        }
+    }
+}
+
+void TerrainHeightPyramid::update(const float *heightData, int x0, int z0, int x1, int z1)
+{
+    heights = heightData;
+    if (levels.empty())
+        return;
+
+    // A sample belongs to the (up to) four cells around it
+    int i0 = std::max(x0 - 1, 0), j0 = std::max(z0 - 1, 0);
+    int i1 = std::min(x1, levels[0].nodesX), j1 = std::min(z1, levels[0].nodesZ);
+    for (int level = 1; level < (int)levels.size() && i0 < i1 && j0 < j1; level++)
+    {
+        i0 /= 2;
+        j0 /= 2;
+        i1 = (i1 + 1) / 2;
+        j1 = (j1 + 1) / 2;
+        reduceLevel(level, i0, j0, i1, j1);
+    }
+}
+
+bool TerrainHeightPyramid::nodeInterval(const Ray &ray, int level, int i, int j, float tMax, float &t0,
+                                        float &t1) const
+{
+    glm::vec2 range = nodeRange(level, i, j);
+    int size = 1 << level;
+
+    float tNear = 0.0f, tFar = tMax;
+    if (!clipSlab(ray.origin.x, ray.direction.x, ray.inverse.x, (float)(i * size),
+                  (float)std::min((i + 1) * size, width - 1), tNear, tFar) ||
+        !clipSlab(ray.origin.z, ray.direction.z, ray.inverse.z, (float)(j * size),
+                  (float)std::min((j + 1) * size, height - 1), tNear, tFar) ||
+        !clipSlab(ray.origin.y, ray.direction.y, ray.inverse.y, range.x, range.y, tNear, tFar))
+        return false;
+
+    t0 = tNear;
+    t1 = tFar;
+    return true;
+}
+
+bool TerrainHeightPyramid::intersectCell(const Ray &ray, int cellX, int cellZ, float t0, float t1,
+                                         TerrainRayHit &hit) const
+{
+    const float *row = heights + (size_t)cellZ * width + cellX;
+    float h00 = row[0], h10 = row[1], h01 = row[width], h11 = row[width + 1];
+
+    // h(u, v) = h00 + A u + B v + C u v over the cell's local [0, 1]^2
+    float A = h10 - h00;
+    float B = h01 - h00;
+    float C = h00 - h10 - h01 + h11;
+
+    // Solve from the cell entry point, which keeps the numbers small on long rays:
+    // f(s) = ray height - surface height = a s^2 + b s + c for t = t0 + s
+    glm::vec3 entry = ray.origin + ray.direction * t0;
+    float u0 = entry.x - (float)cellX, v0 = entry.z - (float)cellZ;
+    float dx = ray.direction.x, dy = ray.direction.y, dz = ray.direction.z;
+
+    float a = -C * dx * dz;
+    float b = dy - A * dx - B * dz - C * (u0 * dz + v0 * dx);
+    float c = entry.y - (h00 + A * u0 + B * v0 + C * u0 * v0);
+
+    float roots[2];
+    int rootCount = 0;
+    if (a == 0.0f)
+    {
+        if (b != 0.0f)
+            roots[rootCount++] = -c / b;
+    }
+    else
+    {
+        float discriminant = b * b - 4.0f * a * c;
+        if (discriminant < 0.0f)
+            return false;
+        float q = -0.5f * (b + std::copysign(std::sqrt(discriminant), b));
+        roots[rootCount++] = q / a;
+        if (q != 0.0f)
+            roots[rootCount++] = c / q;
+        if (rootCount == 2 && roots[1] < roots[0])
+            std::swap(roots[0], roots[1]);
+    }
+
+    // First root inside the cell where the ray is heading down through the surface
+    float length = t1 - t0;
+    float epsilon = 1e-5f * (1.0f + length);
+    for (int k = 0; k < rootCount; k++)
+    {
+        float s = roots[k];
+        if (s < -epsilon || s > length + epsilon || 2.0f * a * s + b > 0.0f)
+            continue;
+
+        s = std::clamp(s, 0.0f, length);
+        float u = std::clamp(u0 + dx * s, 0.0f, 1.0f);
+        float v = std::clamp(v0 + dz * s, 0.0f, 1.0f);
+
+        hit.hit = true;
+        hit.distance = t0 + s;
+        hit.position = ray.origin + ray.direction * hit.distance;
+        hit.normal = glm::normalize(glm::vec3(-(A + C * v), 1.0f, -(B + C * u)));
+        return true;
+    }
+    return false;
+}
+
+int TerrainHeightPyramid::childOrder(const glm::vec3 &direction, int level, int i, int j, int *childI,
+                                     int *childJ) const
+{
+    // Nearest child first, farthest last. A ray heading one way in x and z crosses at most one of
+    // the two side children, so their order doesn't matter.
+    int nearX = direction.x < 0.0f ? 1 : 0;
+    int nearZ = direction.z < 0.0f ? 1 : 0;
+    const int offsets[4][2] = {{nearX, nearZ}, {1 - nearX, nearZ}, {nearX, 1 - nearZ}, {1 - nearX, 1 - nearZ}};
+
+    const Level &children = levels[level - 1];
+    int count = 0;
+    for (const auto &offset : offsets)
+    {
+        int ci = 2 * i + offset[0], cj = 2 * j + offset[1];
+        if (ci < children.nodesX && cj < children.nodesZ)
+        {
+            childI[count] = ci;
+            childJ[count] = cj;
+            count++;
+        }
+    }
+    return count;
+}
+
+void TerrainHeightPyramid::traverse(const Ray &ray, int level, int i, int j, TerrainRayHit &hit, float &best,
+                                    TerrainRaycastStats &stats) const
+{
+    stats.nodesVisited++;
+    float t0, t1;
+    if (!nodeInterval(ray, level, i, j, best, t0, t1))
+        return;
+
+    if (level == 0)
+    {
+        stats.cellsTested++;
+        if (intersectCell(ray, i, j, t0, t1, hit))
+            best = hit.distance;
+        return;
+    }
+
+    // Children are visited front to back, so the first hit is the nearest
+    int childI[4], childJ[4];
+    int count = childOrder(ray.direction, level, i, j, childI, childJ);
+    for (int k = 0; k < count && !hit.hit; k++)
+        traverse(ray, level - 1, childI[k], childJ[k], hit, best, stats);
+}
+
+bool TerrainHeightPyramid::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                                   TerrainRayHit &hit, TerrainRaycastStats *stats) const
+{
+    hit = TerrainRayHit();
+    if (levels.empty())
+        return false;
+
+    Ray ray = {origin, direction, 1.0f / direction};
+    float best = maxDistance;
+    TerrainRaycastStats localStats;
+    traverse(ray, (int)levels.size() - 1, 0, 0, hit, best, localStats);
+
+    if (stats)
+    {
+        stats->nodesVisited += localStats.nodesVisited;
+        stats->cellsTested += localStats.cellsTested;
+    }
+    return hit.hit;
+}
+
+void TerrainHeightPyramid::traversePacket(Packet &packet, const int *active, int activeCount, int level, int i,
+                                          int j, TerrainRaycastStats &stats) const
+{
+    stats.nodesVisited++;
+
+    // Rays that reach this node before their current best hit
+    int inside[PacketSize];
+    float t0[PacketSize], t1[PacketSize];
+    int insideCount = 0;
+    for (int k = 0; k < activeCount; k++)
+    {
+        int r = active[k];
+        if (nodeInterval(packet.rays[r], level, i, j, packet.best[r], t0[insideCount], t1[insideCount]))
+            inside[insideCount++] = r;
+    }
+    if (insideCount == 0)
+        return;
+
+    if (level == 0)
+    {
+        for (int k = 0; k < insideCount; k++)
+        {
+            int r = inside[k];
+            stats.cellsTested++;
+            TerrainRayHit candidate;
+            if (intersectCell(packet.rays[r], i, j, t0[k], t1[k], candidate) && candidate.distance < packet.best[r])
+            {
+                packet.hits[r] = candidate;
+                packet.best[r] = candidate.distance;
+            }
+        }
+        return;
+    }
+
+    // Rays may disagree on direction, so a later child can still improve on an earlier hit; the
+    // best-distance clipping above drops the rays that are already done
+    int childI[4], childJ[4];
+    int count = childOrder(packet.direction, level, i, j, childI, childJ);
+    for (int k = 0; k < count; k++)
+        traversePacket(packet, inside, insideCount, level - 1, childI[k], childJ[k], stats);
+}
+
+int TerrainHeightPyramid::raycastPacket(const glm::vec3 *origins, const glm::vec3 *directions, int count,
+                                        float maxDistance, TerrainRayHit *hits, TerrainRaycastStats *stats) const
+{
+    TerrainRaycastStats localStats;
+    int hitCount = 0;
+    Packet packet;
+
+    for (int first = 0; first < count; first += PacketSize)
+    {
+        int size = std::min(PacketSize, count - first);
+        int active[PacketSize];
+        packet.direction = glm::vec3(0.0f);
+        for (int r = 0; r < size; r++)
+        {
+            const glm::vec3 &direction = directions[first + r];
+            packet.rays[r] = {origins[first + r], direction, 1.0f / direction};
+            packet.hits[r] = TerrainRayHit();
+            packet.best[r] = maxDistance;
+            packet.direction += direction;
+            active[r] = r;
+        }
+
+        if (!levels.empty())
+            traversePacket(packet, active, size, (int)levels.size() - 1, 0, 0, localStats);
+
+        for (int r = 0; r < size; r++)
+        {
+            hits[first + r] = packet.hits[r];
+            hitCount += packet.hits[r].hit ? 1 : 0;
+        }
+    }
+
+    if (stats)
+    {
+        stats->nodesVisited += localStats.nodesVisited;
+        stats->cellsTested += localStats.cellsTested;
+    }
+    return hitCount;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Ray casts against a heightfield's bilinear surface, the same surface getHeight/sampleHeight
+// interpolate. A min/max pyramid over the cells lets a ray skip every node it passes above or
+// below, so only the cells it actually grazes are solved exactly.
+//
+// A hit is where the ray passes from above the surface to on or below it. Rays that start under
+// the terrain hit nothing until they come back up and re-enter it, so a camera that ends up
+// underground can still move out. Only the map itself is hit; there is no ground beyond its edges.
+
+struct TerrainRayHit
+{
+    bool hit = false;
+    float distance = 0.0f; // Along the (normalized) direction
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
+};
+
+struct TerrainRaycastStats
+{
+    size_t nodesVisited = 0;
+    size_t cellsTested = 0;
+};
+
+class TerrainHeightPyramid
+{
+public:
+    // Rays in a packet are traversed together, this many at a time
+    static constexpr int PacketSize = 16;
+
+    // Builds the per-level (min, max) heights of a width x height row-major heightfield. heights
+    // is kept, not copied, and must outlive the pyramid (or be replaced through update).
+    void build(const float *heights, int width, int height, ThreadPool *pool = nullptr);
+
+    // Refreshes the pyramid after the samples in [x0, x1) x [z0, z1) changed. heights may be a new
+    // pointer to the same heightfield (e.g. after a copy-on-write).
+    void update(const float *heights, int x0, int z0, int x1, int z1);
+
+    bool isBuilt() const { return !levels.empty(); }
+    int getLevelCount() const { return (int)levels.size(); }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // A level-k node covers 2^k x 2^k cells (fewer on the far edges); nodeRange is its
+    // (min, max) height
+    int getNodesX(int level) const { return levels[level].nodesX; }
+    int getNodesZ(int level) const { return levels[level].nodesZ; }
+    glm::vec2 nodeRange(int level, int i, int j) const;
+
+    // Nearest hit within maxDistance. direction must be normalized.
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, TerrainRayHit &hit,
+                 TerrainRaycastStats *stats = nullptr) const;
+
+    // Casts count rays, writing hits[i] for ray i. Rays are walked down the pyramid in packets,
+    // so nodes shared by neighbouring rays (a picking fan, a bundle of line-of-sight checks) are
+    // fetched once; results are identical to casting each ray on its own. Returns the number of hits.
+    int raycastPacket(const glm::vec3 *origins, const glm::vec3 *directions, int count, float maxDistance,
+                      TerrainRayHit *hits, TerrainRaycastStats *stats = nullptr) const;
+
+private:
+    struct Level
+    {
+        int nodesX = 0, nodesZ = 0;
+        std::vector<glm::vec2> minMax; // nodesX * nodesZ (min, max), empty for level 0
+    };
+
+    struct Ray
+    {
+        glm::vec3 origin, direction, inverse;
+    };
+
+    struct Packet;
+
+    void reduceLevel(int level, int i0, int j0, int i1, int j1);
+    bool nodeInterval(const Ray &ray, int level, int i, int j, float tMax, float &t0, float &t1) const;
+    bool intersectCell(const Ray &ray, int cellX, int cellZ, float t0, float t1, TerrainRayHit &hit) const;
+    void traverse(const Ray &ray, int level, int i, int j, TerrainRayHit &hit, float &best,
+                  TerrainRaycastStats &stats) const;
+    void traversePacket(Packet &packet, const int *active, int activeCount, int level, int i, int j,
+                        TerrainRaycastStats &stats) const;
+    int childOrder(const glm::vec3 &direction, int level, int i, int j, int *childI, int *childJ) const;
+
+    const float *heights = nullptr;
+    int width = 0, height = 0;
+    std::vector<Level> levels; // levels[0] is the cells themselves (no storage), the last level a single node
+};
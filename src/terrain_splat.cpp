@@ -0,0 +1,106 @@
+#include "terrain_splat.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    float smoothstep(float edge0, float edge1, float x)
+    {
+        float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    void bakeRow(const float *heights, const float *normals, size_t normalStride, int width, int x0, int x1, int z,
+                 uint8_t *out)
+    {
+        for (int x = x0; x < x1; x++)
+        {
+            size_t sample = (size_t)z * width + x;
+            const float *normal = normals + sample * normalStride;
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            float slope = length > 0.0f ? 1.0f - normal[1] / length : 0.0f;
+            glm::vec4 weights = computeSplatWeights(heights[sample], slope);
+
+            // Round each channel, then give the rounding remainder to the heaviest one so the
+            // weights still sum to one after quantization
+            int channels[4], total = 0, heaviest = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                channels[c] = (int)std::lround(weights[c] * 255.0f);
+                total += channels[c];
+                if (weights[c] > weights[heaviest])
+                    heaviest = c;
+            }
+            channels[heaviest] += 255 - total;
+
+            uint8_t *texel = out + sample * 4;
+            for (int c = 0; c < 4; c++)
+                texel[c] = (uint8_t)channels[c];
+        }
+    }
+}
+
+glm::vec4 computeSplatWeights(float height, float slope)
+{
+    float grass = 0.0f, rock = 0.0f, sand = 0.0f, earth = 0.0f;
+
+    // Sand into earth below 1, earth into grass up to 3, grass into rock above
+    if (height < 1.0f)
+    {
+        float t = smoothstep(0.0f, 1.0f, height);
+        sand = 1.0f - t;
+        earth = t;
+    }
+    else if (height < 3.0f)
+    {
+        float t = smoothstep(1.0f, 3.0f, height);
+        earth = 1.0f - t;
+        grass = t;
+    }
+    else
+    {
+        float t = smoothstep(3.0f, 5.0f, height);
+        grass = 1.0f - t;
+        rock = t;
+    }
+
+    // Steep slopes fade into rock
+    if (slope > 0.3f)
+    {
+        float t = smoothstep(0.3f, 0.7f, slope);
+        grass *= 1.0f - t;
+        sand *= 1.0f - t;
+        earth *= 1.0f - t;
+        rock = rock * (1.0f - t) + t;
+    }
+    return glm::vec4(grass, rock, sand, earth);
+}
+
+void bakeSplatMapRect(const float *heights, const float *normals, size_t normalStride, int width, int height, int x0,
+                      int z0, int x1, int z1, uint8_t *out, ThreadPool *pool)
+{
+    x0 = std::max(x0, 0);
+    z0 = std::max(z0, 0);
+    x1 = std::min(x1, width);
+    z1 = std::min(z1, height);
+    if (x0 >= x1 || z0 >= z1)
+        return;
+
+    auto rows = [&](int first, int last)
+    {
+        for (int z = first; z < last; z++)
+            bakeRow(heights, normals, normalStride, width, x0, x1, z, out);
+    };
+
+    if (pool)
+        pool->parallelFor(z0, z1, 16, rows);
+    else
+        rows(z0, z1);
+}
+
+void bakeSplatMap(const float *heights, const float *normals, size_t normalStride, int width, int height, uint8_t *out,
+                  ThreadPool *pool)
+{
+    bakeSplatMapRect(heights, normals, normalStride, width, height, 0, 0, width, height, out, pool);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Terrain material weights baked per heightfield sample.
+//
+// The terrain fragment shader used to work out its texture blend from the fragment's height and
+// slope on every fragment: a chain of height branches with a smoothstep each, then a slope
+// smoothstep over the top. The same blend is evaluated here once per sample and stored as an
+// RGBA8 splat map (grass, rock, sand, earth), so the shader makes one filtered weight fetch and
+// a weighted sum of the four material samples.
+
+// Blend weights in (grass, rock, sand, earth) order for a height and a slope of
+// 1 - normal.y, exactly as the procedural shader blends them. The weights sum to 1.
+glm::vec4 computeSplatWeights(float height, float slope);
+
+// Writes the RGBA8 weights of samples [x0, x1) x [z0, z1) of a width x height heightfield to
+// out + (z * width + x) * 4. The normal of sample (x, z) is read from normals + (z * width + x) *
+// normalStride, so an interleaved vertex buffer can be passed directly. Channels are rounded so
+// every texel sums to exactly 255. Rows are spread over pool when one is given.
+void bakeSplatMapRect(const float *heights, const float *normals, size_t normalStride, int width, int height, int x0,
+                      int z0, int x1, int z1, uint8_t *out, ThreadPool *pool = nullptr);
+
+// Weights for the whole heightfield
+void bakeSplatMap(const float *heights, const float *normals, size_t normalStride, int width, int height, uint8_t *out,
+                  ThreadPool *pool = nullptr);
+
+// Per-fragment cost of the material blend, counted by hand from the GLSL of each path (update
+// these with the shaders): scalar ALU operations (a vec4 operation counts four), texture
+// fetches and conditionals. Estimates for comparing the two paths, not measurements.
+struct SplatShaderCost
+{
+    int aluOps;
+    int textureFetches;
+    int branches;
+};
+
+// Steep-slope worst case: normalize + dot for the slope (11), height compares (2), two
+// smoothsteps (10), two vec4 mixes (16) and the slope compare (1)
+constexpr SplatShaderCost ProceduralSplatCost = {40, 4, 3};
+
+// Splat coordinate from FragPos and textureSize (8), then a four-term vec4 weighted sum (16)
+constexpr SplatShaderCost BakedSplatCost = {24, 5, 0};
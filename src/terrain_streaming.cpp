@@ -0,0 +1,371 @@
+#include "terrain_streaming.h"
+#include "terrain_indices.h"
+#include "terrain_normals.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int FloatsPerVertex = 8;
+
+    // Integer division rounding towards negative infinity
+    int floorDiv(int value, int divisor)
+    {
+        int quotient = value / divisor;
+        if (value % divisor != 0 && value < 0)
+            quotient--;
+        return quotient;
+    }
+}
+
+size_t TerrainChunk::memoryBytes() const
+{
+    // Heights stay on the CPU; vertex data lives on the CPU until upload and on the GPU after
+    size_t sampleCount = (size_t)samples * samples;
+    return sampleCount * sizeof(float) + sampleCount * FloatsPerVertex * sizeof(float);
+}
+
+TerrainStreamer::TerrainStreamer(HeightRowFunction source, const Settings &settings)
+    : source(std::move(source)), settings(settings), workers(std::max(1u, settings.workerThreads) + 1)
+{
+}
+
+TerrainStreamer::~TerrainStreamer()
+{
+    // Queued jobs see the flag and return immediately; running ones finish before workers joins
+    cancelled = true;
+
+    for (auto &entry : resident)
+        releaseChunk(*entry.second.chunk);
+
+    if (sharedEBO)
+        glDeleteBuffers(1, &sharedEBO);
+}
+
+std::unique_ptr<TerrainChunk> TerrainStreamer::buildChunk(const HeightRowFunction &source, int chunkSize, int cx, int cz)
+{
+    auto chunk = std::make_unique<TerrainChunk>();
+    chunk->cx = cx;
+    chunk->cz = cz;
+    chunk->samples = chunkSize + 1;
+
+    int samples = chunk->samples;
+    int x0 = cx * chunkSize;
+    int z0 = cz * chunkSize;
+
+    // Generate with a one-sample apron so edge normals match the neighbouring chunk
+    int apron = samples + 2;
+    std::vector<float> padded((size_t)apron * apron);
+    for (int row = 0; row < apron; row++)
+        source(x0 - 1, z0 - 1 + row, apron, padded.data() + (size_t)row * apron);
+
+    auto at = [&](int x, int z)
+    { return padded[(size_t)(z + 1) * apron + (x + 1)]; };
+
+    chunk->heights.resize((size_t)samples * samples);
+    chunk->vertices.resize((size_t)samples * samples * FloatsPerVertex);
+    chunk->minHeight = at(0, 0);
+    chunk->maxHeight = at(0, 0);
+
+    float *vertex = chunk->vertices.data();
+    for (int z = 0; z < samples; z++)
+    {
+        for (int x = 0; x < samples; x++)
+        {
+            float y = at(x, z);
+            chunk->heights[(size_t)z * samples + x] = y;
+            chunk->minHeight = std::min(chunk->minHeight, y);
+            chunk->maxHeight = std::max(chunk->maxHeight, y);
+
+            float worldX = (float)(x0 + x);
+            float worldZ = (float)(z0 + z);
+            *vertex++ = worldX;
+            *vertex++ = y;
+            *vertex++ = worldZ;
+            vertex += 3; // Normal, filled in below
+            *vertex++ = worldX * 0.1f;
+            *vertex++ = worldZ * 0.1f;
+        }
+
+        // The apron supplies every neighbour, so each row goes straight through the normal kernel
+        const float *center = &padded[(size_t)(z + 1) * apron + 1];
+        computeNormalRow(center - apron, center, center + apron, samples,
+                         chunk->vertices.data() + (size_t)z * samples * FloatsPerVertex + 3, FloatsPerVertex);
+    }
+
+    return chunk;
+}
+
+bool TerrainStreamer::isRequired(const ChunkKey &key, const ChunkKey &focusChunk) const
+{
+    return std::abs(key.cx - focusChunk.cx) <= settings.requiredRadius &&
+           std::abs(key.cz - focusChunk.cz) <= settings.requiredRadius;
+}
+
+bool TerrainStreamer::inLoadRadius(const ChunkKey &key, const ChunkKey &focusChunk) const
+{
+    return std::abs(key.cx - focusChunk.cx) <= settings.loadRadius &&
+           std::abs(key.cz - focusChunk.cz) <= settings.loadRadius;
+}
+
+void TerrainStreamer::requestChunk(const ChunkKey &key)
+{
+    pending[key] = false;
+    frameStats.requested++;
+
+    workers.submit([this, key]
+                   {
+        if (cancelled)
+            return;
+
+        auto chunk = buildChunk(source, settings.chunkSize, key.cx, key.cz);
+
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.push_back(std::move(chunk)); });
+}
+
+void TerrainStreamer::update(const glm::vec3 &focus)
+{
+    frameStats = TerrainStreamingStats();
+
+    ChunkKey focusChunk = {(int)std::floor(focus.x / settings.chunkSize), (int)std::floor(focus.z / settings.chunkSize)};
+
+    // Collect whatever the workers finished since last frame without waiting on them
+    std::vector<std::unique_ptr<TerrainChunk>> finished;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        finished.swap(completed);
+    }
+
+    for (auto &chunk : finished)
+    {
+        ChunkKey key = {chunk->cx, chunk->cz};
+        auto found = pending.find(key);
+        if (found == pending.end())
+            continue;
+
+        frameStats.completed++;
+        if (found->second)
+            frameStats.lateLoads++;
+        pending.erase(found);
+
+        residentBytes += chunk->memoryBytes();
+        lru.push_front(key);
+        resident[key] = ResidentChunk{std::move(chunk), lru.begin()};
+        uploadQueue.push_back(key);
+    }
+
+    // Visit the load area nearest-first so close chunks are requested before distant ones
+    std::vector<ChunkKey> wanted;
+    for (int dz = -settings.loadRadius; dz <= settings.loadRadius; dz++)
+        for (int dx = -settings.loadRadius; dx <= settings.loadRadius; dx++)
+            wanted.push_back({focusChunk.cx + dx, focusChunk.cz + dz});
+
+    auto distance = [&](const ChunkKey &key)
+    { return std::max(std::abs(key.cx - focusChunk.cx), std::abs(key.cz - focusChunk.cz)); };
+    std::stable_sort(wanted.begin(), wanted.end(), [&](const ChunkKey &a, const ChunkKey &b)
+                     { return distance(a) < distance(b); });
+
+    for (const ChunkKey &key : wanted)
+    {
+        bool required = isRequired(key, focusChunk);
+
+        auto found = resident.find(key);
+        if (found != resident.end())
+        {
+            lru.splice(lru.begin(), lru, found->second.lruPosition);
+            if (required && !found->second.chunk->uploaded)
+                frameStats.missingRequired++;
+            continue;
+        }
+
+        if (required)
+            frameStats.missingRequired++;
+
+        auto inFlight = pending.find(key);
+        if (inFlight != pending.end())
+        {
+            if (required)
+                inFlight->second = true;
+            continue;
+        }
+
+        if ((int)pending.size() < settings.maxInFlight)
+        {
+            requestChunk(key);
+            if (required)
+                pending[key] = true;
+        }
+    }
+
+    // Upload a bounded number of finished chunks, nearest first
+    std::stable_sort(uploadQueue.begin(), uploadQueue.end(), [&](const ChunkKey &a, const ChunkKey &b)
+                     { return distance(a) < distance(b); });
+
+    size_t next = 0;
+    for (; next < uploadQueue.size() && frameStats.uploaded < settings.maxUploadsPerFrame; next++)
+    {
+        auto found = resident.find(uploadQueue[next]);
+        if (found == resident.end() || found->second.chunk->uploaded)
+            continue;
+
+        uploadChunk(*found->second.chunk);
+        frameStats.uploaded++;
+    }
+    uploadQueue.erase(uploadQueue.begin(), uploadQueue.begin() + next);
+
+    evictToBudget(focusChunk);
+
+    frameStats.resident = (int)resident.size();
+    frameStats.inFlight = (int)pending.size();
+    frameStats.residentBytes = residentBytes;
+}
+
+void TerrainStreamer::uploadChunk(TerrainChunk &chunk)
+{
+    // All chunks share one index buffer since they have the same grid size. Chunks small enough
+    // for 16-bit indices draw as restart-separated strips, larger ones fall back to a 32-bit list.
+    if (!sharedEBO)
+    {
+        glGenBuffers(1, &sharedEBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedEBO);
+
+        if (chunk.samples <= MaxStripGridSamples)
+        {
+            std::vector<uint16_t> strip;
+            buildGridTriangleStrip(chunk.samples, chunk.samples, strip);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, strip.size() * sizeof(uint16_t), strip.data(), GL_STATIC_DRAW);
+            indexCount = strip.size();
+            useStrips = true;
+        }
+        else
+        {
+            std::vector<unsigned int> indices;
+            buildGridTriangleList(chunk.samples, chunk.samples, indices);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+            indexCount = indices.size();
+        }
+    }
+
+    glGenVertexArrays(1, &chunk.VAO);
+    glGenBuffers(1, &chunk.VBO);
+
+    glBindVertexArray(chunk.VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+    glBufferData(GL_ARRAY_BUFFER, chunk.vertices.size() * sizeof(float), chunk.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedEBO);
+
+    // Same layout as Terrain::setupMesh
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, FloatsPerVertex * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, FloatsPerVertex * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, FloatsPerVertex * sizeof(float), (void *)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+
+    // The GPU copy is the only one needed from now on
+    chunk.vertices.clear();
+    chunk.vertices.shrink_to_fit();
+    chunk.uploaded = true;
+}
+
+void TerrainStreamer::releaseChunk(TerrainChunk &chunk)
+{
+    if (chunk.VAO)
+        glDeleteVertexArrays(1, &chunk.VAO);
+    if (chunk.VBO)
+        glDeleteBuffers(1, &chunk.VBO);
+    chunk.VAO = chunk.VBO = 0;
+    chunk.uploaded = false;
+}
+
+void TerrainStreamer::evictToBudget(const ChunkKey &focusChunk)
+{
+    // Chunks in the load radius were touched this frame, so the tail holds the stale ones
+    while (residentBytes > settings.memoryBudget && !lru.empty())
+    {
+        ChunkKey key = lru.back();
+        if (inLoadRadius(key, focusChunk))
+            break;
+
+        auto found = resident.find(key);
+        releaseChunk(*found->second.chunk);
+        residentBytes -= found->second.chunk->memoryBytes();
+        resident.erase(found);
+        lru.pop_back();
+        frameStats.evicted++;
+    }
+}
+
+void TerrainStreamer::render()
+{
+    if (useStrips)
+    {
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(PrimitiveRestartIndex16);
+    }
+
+    for (auto &entry : resident)
+    {
+        const TerrainChunk &chunk = *entry.second.chunk;
+        if (!chunk.uploaded)
+            continue;
+
+        glBindVertexArray(chunk.VAO);
+        if (useStrips)
+            glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)indexCount, GL_UNSIGNED_SHORT, 0);
+        else
+            glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT, 0);
+    }
+    glBindVertexArray(0);
+
+    if (useStrips)
+        glDisable(GL_PRIMITIVE_RESTART);
+}
+
+float TerrainStreamer::getHeight(float x, float z) const
+{
+    int gridX = (int)std::floor(x);
+    int gridZ = (int)std::floor(z);
+    float xCoord = x - gridX;
+    float zCoord = z - gridZ;
+
+    float h00, h10, h01, h11;
+
+    ChunkKey key = {floorDiv(gridX, settings.chunkSize), floorDiv(gridZ, settings.chunkSize)};
+    auto found = resident.find(key);
+    if (found != resident.end())
+    {
+        // The cell's far corners are the chunk's shared edge, so they are always inside it
+        const TerrainChunk &chunk = *found->second.chunk;
+        int localX = gridX - key.cx * settings.chunkSize;
+        int localZ = gridZ - key.cz * settings.chunkSize;
+        const float *row0 = chunk.heights.data() + (size_t)localZ * chunk.samples + localX;
+        const float *row1 = row0 + chunk.samples;
+        h00 = row0[0];
+        h10 = row0[1];
+        h01 = row1[0];
+        h11 = row1[1];
+    }
+    else
+    {
+        float row0[2], row1[2];
+        source(gridX, gridZ, 2, row0);
+        source(gridX, gridZ + 1, 2, row1);
+        h00 = row0[0];
+        h10 = row0[1];
+        h01 = row1[0];
+        h11 = row1[1];
+    }
+
+    float h0 = h00 * (1 - xCoord) + h10 * xCoord;
+    float h1 = h01 * (1 - xCoord) + h11 * xCoord;
+
+    return h0 * (1 - zCoord) + h1 * zCoord;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "heightfield.h"
+#include "thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// One fixed-size tile of the infinite heightfield. Neighbouring chunks share their edge samples.
+struct TerrainChunk
+{
+    int cx = 0, cz = 0;
+    int samples = 0;           // Samples per side (chunkSize + 1)
+    std::vector<float> heights; // samples x samples, row-major
+    std::vector<float> vertices; // Interleaved position/normal/uv, released after upload
+    float minHeight = 0.0f, maxHeight = 0.0f;
+
+    unsigned int VAO = 0, VBO = 0;
+    bool uploaded = false;
+
+    size_t memoryBytes() const;
+};
+
+// Per-frame counters for the streaming system
+struct TerrainStreamingStats
+{
+    int requested = 0;      // Chunk loads queued this frame
+    int completed = 0;      // Loads that finished generating this frame
+    int lateLoads = 0;      // Completed loads that were already needed by an earlier frame
+    int missingRequired = 0; // Required chunks that were not ready to draw this frame
+    int uploaded = 0;       // Chunks uploaded to the GPU this frame
+    int evicted = 0;
+    int resident = 0;
+    int inFlight = 0;
+    size_t residentBytes = 0;
+};
+
+// Pages terrain chunks in and out around a focus point (the vehicle).
+//
+// Chunks are generated on a private worker pool and handed back through a locked queue; the render
+// thread only ever polls that queue, uploads a bounded number of finished chunks and draws what
+// is resident, so update() never waits on a worker. Resident chunks live in an LRU cache that is
+// trimmed to a memory budget, never evicting chunks inside the load radius.
+class TerrainStreamer
+{
+public:
+    struct Settings
+    {
+        int chunkSize = 64;            // Quads per chunk side
+        int loadRadius = 3;            // Chunks kept loaded around the focus, in chunks
+        int requiredRadius = 1;        // Chunks that must be ready to draw; later ones count as late
+        size_t memoryBudget = 64u << 20; // CPU + GPU bytes for resident chunks
+        int maxUploadsPerFrame = 2;
+        int maxInFlight = 16;
+        unsigned int workerThreads = 2; // Background generator threads
+    };
+
+    TerrainStreamer(HeightRowFunction source, const Settings &settings);
+    ~TerrainStreamer();
+
+    TerrainStreamer(const TerrainStreamer &) = delete;
+    TerrainStreamer &operator=(const TerrainStreamer &) = delete;
+
+    // Once per frame on the render thread: requests, collects, uploads and evicts chunks
+    void update(const glm::vec3 &focus);
+
+    // Draws every uploaded chunk (caller binds the shader and textures)
+    void render();
+
+    // Height anywhere in the world. Uses the resident chunk when there is one and otherwise
+    // evaluates the generator directly, so the answer never depends on what is loaded.
+    float getHeight(float x, float z) const;
+
+    const TerrainStreamingStats &getFrameStats() const { return frameStats; }
+    const Settings &getSettings() const { return settings; }
+
+private:
+    struct ChunkKey
+    {
+        int cx, cz;
+        bool operator==(const ChunkKey &other) const { return cx == other.cx && cz == other.cz; }
+    };
+
+    struct ChunkKeyHash
+    {
+        size_t operator()(const ChunkKey &key) const
+        {
+            return std::hash<uint64_t>()(((uint64_t)(uint32_t)key.cx << 32) | (uint32_t)key.cz);
+        }
+    };
+
+    struct ResidentChunk
+    {
+        std::unique_ptr<TerrainChunk> chunk;
+        std::list<ChunkKey>::iterator lruPosition;
+    };
+
+    static std::unique_ptr<TerrainChunk> buildChunk(const HeightRowFunction &source, int chunkSize, int cx, int cz);
+
+    void requestChunk(const ChunkKey &key);
+    void uploadChunk(TerrainChunk &chunk);
+    void releaseChunk(TerrainChunk &chunk);
+    void evictToBudget(const ChunkKey &focusChunk);
+    bool isRequired(const ChunkKey &key, const ChunkKey &focusChunk) const;
+    bool inLoadRadius(const ChunkKey &key, const ChunkKey &focusChunk) const;
+
+    HeightRowFunction source;
+    Settings settings;
+
+    std::unordered_map<ChunkKey, ResidentChunk, ChunkKeyHash> resident;
+    std::list<ChunkKey> lru; // Most recently used at the front
+    std::unordered_map<ChunkKey, bool, ChunkKeyHash> pending; // Key -> needed by a frame before it was ready
+    std::vector<ChunkKey> uploadQueue;
+
+    // Finished chunks waiting for the render thread
+    std::mutex completedMutex;
+    std::vector<std::unique_ptr<TerrainChunk>> completed;
+    std::atomic<bool> cancelled{false};
+
+    unsigned int sharedEBO = 0;
+    size_t indexCount = 0;
+    bool useStrips = false;
+    size_t residentBytes = 0;
+    TerrainStreamingStats frameStats;
+
+    // Declared last so it is destroyed first, joining workers while the queue above still exists
+    ThreadPool workers;
+};
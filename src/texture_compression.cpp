@@ -0,0 +1,379 @@
+#include "texture_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // One 4x4 block, channel by channel; values are whole numbers 0-255 stored as float so every
+    // distance below is exact
+    struct BlockTexels
+    {
+        float r[16], g[16], b[16];
+    };
+
+    uint16_t packColor565(const float *color)
+    {
+        int r = (int)std::lround(std::clamp(color[0], 0.0f, 255.0f) * (31.0f / 255.0f));
+        int g = (int)std::lround(std::clamp(color[1], 0.0f, 255.0f) * (63.0f / 255.0f));
+        int b = (int)std::lround(std::clamp(color[2], 0.0f, 255.0f) * (31.0f / 255.0f));
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void unpackColor565(uint16_t color, int *rgb)
+    {
+        int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // The four colours a block can pick from; with color0 <= color1 the block is in three-colour
+    // mode (a midpoint and black)
+    void buildPalette(uint16_t color0, uint16_t color1, int palette[4][3])
+    {
+        unpackColor565(color0, palette[0]);
+        unpackColor565(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            if (color0 > color1)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+    }
+
+    // Picks the nearest palette entry per texel (lowest index on ties) and returns the summed
+    // squared error
+    float selectIndicesScalar(const BlockTexels &block, const float palette[4][3], int *indices)
+    {
+        float total = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            float best = std::numeric_limits<float>::max();
+            for (int j = 0; j < 4; j++)
+            {
+                float dr = block.r[i] - palette[j][0], dg = block.g[i] - palette[j][1], db = block.b[i] - palette[j][2];
+                float distance = dr * dr + dg * dg + db * db;
+                if (distance < best)
+                {
+                    best = distance;
+                    indices[i] = j;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+#if RACING_SIMD_X86
+    float selectIndicesSSE2(const BlockTexels &block, const float palette[4][3], int *indices)
+    {
+        __m128 total = _mm_setzero_ps();
+        for (int i = 0; i < 16; i += 4)
+        {
+            __m128 r = _mm_loadu_ps(block.r + i), g = _mm_loadu_ps(block.g + i), b = _mm_loadu_ps(block.b + i);
+            __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128i bestIndex = _mm_setzero_si128();
+            for (int j = 0; j < 4; j++)
+            {
+                __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[j][0]));
+                __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[j][1]));
+                __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[j][2]));
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+                __m128 closer = _mm_cmplt_ps(distance, best);
+                best = _mm_or_ps(_mm_and_ps(closer, distance), _mm_andnot_ps(closer, best));
+                __m128i closerMask = _mm_castps_si128(closer);
+                bestIndex = _mm_or_si128(_mm_and_si128(closerMask, _mm_set1_epi32(j)),
+                                         _mm_andnot_si128(closerMask, bestIndex));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(indices + i), bestIndex);
+            total = _mm_add_ps(total, best);
+        }
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, total);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    RACING_TARGET_AVX2 float selectIndicesAVX2(const BlockTexels &block, const float palette[4][3], int *indices)
+    {
+        __m256 total = _mm256_setzero_ps();
+        for (int i = 0; i < 16; i += 8)
+        {
+            __m256 r = _mm256_loadu_ps(block.r + i), g = _mm256_loadu_ps(block.g + i), b = _mm256_loadu_ps(block.b + i);
+            __m256 best = _mm256_set1_ps(std::numeric_limits<float>::max());
+            __m256i bestIndex = _mm256_setzero_si256();
+            for (int j = 0; j < 4; j++)
+            {
+                __m256 dr = _mm256_sub_ps(r, _mm256_set1_ps(palette[j][0]));
+                __m256 dg = _mm256_sub_ps(g, _mm256_set1_ps(palette[j][1]));
+                __m256 db = _mm256_sub_ps(b, _mm256_set1_ps(palette[j][2]));
+                __m256 distance =
+                    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(dg, dg)), _mm256_mul_ps(db, db));
+
+                __m256 closer = _mm256_cmp_ps(distance, best, _CMP_LT_OQ);
+                best = _mm256_blendv_ps(best, distance, closer);
+                bestIndex = _mm256_blendv_epi8(bestIndex, _mm256_set1_epi32(j), _mm256_castps_si256(closer));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(indices + i), bestIndex);
+            total = _mm256_add_ps(total, best);
+        }
+
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, total);
+        float sum = 0.0f;
+        for (float lane : lanes)
+            sum += lane;
+        return sum;
+    }
+#endif
+
+    float selectIndices(const BlockTexels &block, uint16_t color0, uint16_t color1, int *indices, SimdLevel level)
+    {
+        int entries[4][3];
+        buildPalette(color0, color1, entries);
+        float palette[4][3];
+        for (int j = 0; j < 4; j++)
+            for (int c = 0; c < 3; c++)
+                palette[j][c] = (float)entries[j][c];
+
+#if RACING_SIMD_X86
+        if (level == SimdLevel::AVX2)
+            return selectIndicesAVX2(block, palette, indices);
+        if (level == SimdLevel::SSE2)
+            return selectIndicesSSE2(block, palette, indices);
+#endif
+        return selectIndicesScalar(block, palette, indices);
+    }
+
+    // Endpoints as four-colour mode wants them (color0 > color1); equal endpoints stay equal
+    void orderEndpoints(uint16_t &color0, uint16_t &color1)
+    {
+        if (color0 < color1)
+            std::swap(color0, color1);
+    }
+
+    // The texels furthest apart along the block's principal colour axis (power iteration on the
+    // covariance), as 565 endpoints
+    void principalEndpoints(const BlockTexels &block, uint16_t &color0, uint16_t &color1)
+    {
+        float mean[3] = {0.0f, 0.0f, 0.0f};
+        for (int i = 0; i < 16; i++)
+        {
+            mean[0] += block.r[i];
+            mean[1] += block.g[i];
+            mean[2] += block.b[i];
+        }
+        for (float &m : mean)
+            m *= 1.0f / 16.0f;
+
+        float covariance[6] = {}; // rr, rg, rb, gg, gb, bb
+        for (int i = 0; i < 16; i++)
+        {
+            float r = block.r[i] - mean[0], g = block.g[i] - mean[1], b = block.b[i] - mean[2];
+            covariance[0] += r * r;
+            covariance[1] += r * g;
+            covariance[2] += r * b;
+            covariance[3] += g * g;
+            covariance[4] += g * b;
+            covariance[5] += b * b;
+        }
+
+        float axis[3] = {1.0f, 1.0f, 1.0f};
+        for (int iteration = 0; iteration < 4; iteration++)
+        {
+            float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+            float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+            float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+            float largest = std::max({std::fabs(x), std::fabs(y), std::fabs(z)});
+            if (largest <= 0.0f)
+                break;
+            axis[0] = x / largest;
+            axis[1] = y / largest;
+            axis[2] = z / largest;
+        }
+
+        int low = 0, high = 0;
+        float lowT = std::numeric_limits<float>::max(), highT = -std::numeric_limits<float>::max();
+        for (int i = 0; i < 16; i++)
+        {
+            float t = block.r[i] * axis[0] + block.g[i] * axis[1] + block.b[i] * axis[2];
+            if (t < lowT)
+            {
+                lowT = t;
+                low = i;
+            }
+            if (t > highT)
+            {
+                highT = t;
+                high = i;
+            }
+        }
+
+        float highColor[3] = {block.r[high], block.g[high], block.b[high]};
+        float lowColor[3] = {block.r[low], block.g[low], block.b[low]};
+        color0 = packColor565(highColor);
+        color1 = packColor565(lowColor);
+        orderEndpoints(color0, color1);
+    }
+
+    // Least-squares endpoints for a fixed set of four-colour indices; false when every texel uses
+    // the same weight and the system is singular
+    bool refitEndpoints(const BlockTexels &block, const int *indices, uint16_t &color0, uint16_t &color1)
+    {
+        static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[3] = {0.0f, 0.0f, 0.0f}, bp[3] = {0.0f, 0.0f, 0.0f};
+        for (int i = 0; i < 16; i++)
+        {
+            float a = weights[indices[i]], b = 1.0f - a;
+            float texel[3] = {block.r[i], block.g[i], block.b[i]};
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < 3; c++)
+            {
+                ap[c] += a * texel[c];
+                bp[c] += b * texel[c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+            return false;
+
+        float end0[3], end1[3];
+        for (int c = 0; c < 3; c++)
+        {
+            end0[c] = (ap[c] * bb - bp[c] * ab) / determinant;
+            end1[c] = (bp[c] * aa - ap[c] * ab) / determinant;
+        }
+        color0 = packColor565(end0);
+        color1 = packColor565(end1);
+        orderEndpoints(color0, color1);
+        return true;
+    }
+
+    void encodeBlock(const BlockTexels &block, uint8_t *out, SimdLevel level)
+    {
+        uint16_t color0, color1;
+        principalEndpoints(block, color0, color1);
+
+        int indices[16] = {};
+        if (color0 != color1)
+        {
+            float error = selectIndices(block, color0, color1, indices, level);
+
+            uint16_t refit0, refit1;
+            int refitIndices[16];
+            if (refitEndpoints(block, indices, refit0, refit1) && refit0 != refit1)
+            {
+                float refitError = selectIndices(block, refit0, refit1, refitIndices, level);
+                if (refitError < error)
+                {
+                    color0 = refit0;
+                    color1 = refit1;
+                    std::copy(refitIndices, refitIndices + 16, indices);
+                }
+            }
+        }
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; i++)
+            bits |= (uint32_t)indices[i] << (2 * i);
+
+        out[0] = (uint8_t)color0;
+        out[1] = (uint8_t)(color0 >> 8);
+        out[2] = (uint8_t)color1;
+        out[3] = (uint8_t)(color1 >> 8);
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+size_t bc1Size(int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BC1BlockBytes;
+}
+
+void encodeBC1(const uint8_t *rgb, int width, int height, uint8_t *blocks, ThreadPool *pool, SimdLevel level)
+{
+    if (level > detectSimdLevel())
+        level = detectSimdLevel();
+
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    auto blockRows = [&](int first, int last)
+    {
+        BlockTexels block;
+        for (int by = first; by < last; by++)
+        {
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    int x = std::min(bx * 4 + (i & 3), width - 1), y = std::min(by * 4 + (i >> 2), height - 1);
+                    const uint8_t *texel = rgb + ((size_t)y * width + x) * 3;
+                    block.r[i] = texel[0];
+                    block.g[i] = texel[1];
+                    block.b[i] = texel[2];
+                }
+                encodeBlock(block, blocks + ((size_t)by * blocksX + bx) * BC1BlockBytes, level);
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, blocksY, 1, blockRows);
+    else
+        blockRows(0, blocksY);
+}
+
+void decodeBC1(const uint8_t *blocks, int width, int height, uint8_t *rgb)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            const uint8_t *block = blocks + ((size_t)by * blocksX + bx) * BC1BlockBytes;
+            uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+            uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+            uint32_t bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+
+            int palette[4][3];
+            buildPalette(color0, color1, palette);
+            for (int i = 0; i < 16; i++)
+            {
+                int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x >= width || y >= height)
+                    continue;
+                const int *color = palette[(bits >> (2 * i)) & 3];
+                uint8_t *texel = rgb + ((size_t)y * width + x) * 3;
+                for (int c = 0; c < 3; c++)
+                    texel[c] = (uint8_t)color[c];
+            }
+        }
+    }
+}
+
+double computePsnr(const uint8_t *a, const uint8_t *b, size_t count)
+{
+    double squaredError = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        double difference = (double)a[i] - b[i];
+        squaredError += difference * difference;
+    }
+    if (squaredError == 0.0)
+        return std::numeric_limits<double>::infinity();
+    return 10.0 * std::log10(255.0 * 255.0 * count / squaredError);
+}
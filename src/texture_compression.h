@@ -0,0 +1,32 @@
+#pragma once
+
+#include "simd.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// BC1 (DXT1) block compression for the RGB terrain materials.
+//
+// Every 4x4 block becomes two RGB565 endpoints and sixteen 2-bit palette indices (8 bytes, a
+// sixth of RGB8). Endpoints start from the block's principal colour axis and are refit once by
+// least squares; only the refit is kept if it lowers the block error. Index selection and error
+// sums run on SSE2/AVX2 with distances that are exact in float, so every SIMD level encodes the
+// same bytes.
+
+constexpr int BC1BlockBytes = 8;
+
+// Bytes of a width x height image in BC1 (partial blocks at the edges are padded)
+size_t bc1Size(int width, int height);
+
+// Encodes width x height tightly packed RGB8 texels into bc1Size(width, height) bytes, blocks in
+// row-major order. Edge blocks repeat their last row/column. Block rows are spread over pool
+// when one is given.
+void encodeBC1(const uint8_t *rgb, int width, int height, uint8_t *blocks, ThreadPool *pool = nullptr,
+               SimdLevel level = detectSimdLevel());
+
+// Decodes BC1 blocks back to RGB8 with the same palette interpolation as the encoder
+void decodeBC1(const uint8_t *blocks, int width, int height, uint8_t *rgb);
+
+// Peak signal-to-noise ratio in dB between two byte images (infinity when they are identical)
+double computePsnr(const uint8_t *a, const uint8_t *b, size_t count);
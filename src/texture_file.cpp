@@ -0,0 +1,150 @@
+#include "texture_file.h"
+#include "texture_compression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    constexpr char TextureMagic[4] = {'R', 'T', 'E', 'X'};
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+size_t textureLayerSize(TextureCompression compression, int width, int height, int channels)
+{
+    if (compression == TextureCompression::BC1)
+        return bc1Size(width, height);
+    return (size_t)width * height * channels;
+}
+
+bool writeTextureFile(const char *path, const MipChain &chain, MipFilter filter, TextureCompression compression,
+                      ThreadPool *pool)
+{
+    if (compression == TextureCompression::BC1 && chain.channels != 3)
+    {
+        std::cerr << "Failed to write texture file " << path << ": BC1 needs RGB texels" << std::endl;
+        return false;
+    }
+
+    TextureFileHeader header = {};
+    std::memcpy(header.magic, TextureMagic, sizeof(header.magic));
+    header.version = TextureFileVersion;
+    header.width = (uint32_t)chain.width;
+    header.height = (uint32_t)chain.height;
+    header.layers = (uint32_t)chain.layers;
+    header.channels = (uint32_t)chain.channels;
+    header.levels = (uint32_t)chain.levels.size();
+    header.compression = (uint32_t)compression;
+    header.mipFilter = (uint32_t)filter;
+    header.levelTableOffset = sizeof(TextureFileHeader);
+
+    std::vector<TextureLevelInfo> levels(chain.levels.size());
+    uint64_t offset = alignUp(header.levelTableOffset + levels.size() * sizeof(TextureLevelInfo), 64);
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        levels[i].width = (uint32_t)chain.levelWidth((int)i);
+        levels[i].height = (uint32_t)chain.levelHeight((int)i);
+        levels[i].offset = offset;
+        levels[i].size =
+            textureLayerSize(compression, (int)levels[i].width, (int)levels[i].height, chain.channels) * chain.layers;
+        offset = alignUp(offset + levels[i].size, 64);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to create texture file " << path << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(levels.data()), levels.size() * sizeof(TextureLevelInfo));
+
+    const char padding[64] = {};
+    std::vector<uint8_t> encoded;
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        const uint8_t *data = chain.levels[i].data();
+        if (compression == TextureCompression::BC1)
+        {
+            // One level at a time, so only a single compressed level is ever held in memory
+            int width = (int)levels[i].width, height = (int)levels[i].height;
+            encoded.resize(levels[i].size);
+            for (int layer = 0; layer < chain.layers; layer++)
+                encodeBC1(data + layer * chain.levelLayerBytes((int)i), width, height,
+                          encoded.data() + layer * bc1Size(width, height), pool);
+            data = encoded.data();
+        }
+
+        file.write(padding, levels[i].offset - (uint64_t)file.tellp());
+        file.write(reinterpret_cast<const char *>(data), levels[i].size);
+    }
+
+    if (!file.good())
+    {
+        std::cerr << "Failed to write texture file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TextureFile::open(const char *path)
+{
+    header = nullptr;
+    levels = nullptr;
+
+    if (!file.open(path))
+        return false;
+
+    auto fail = [&](const char *reason)
+    {
+        std::cerr << "Failed to load texture " << path << ": " << reason << std::endl;
+        file.close();
+        header = nullptr;
+        return false;
+    };
+
+    const unsigned char *bytes = file.data();
+    uint64_t size = file.size();
+    if (size < sizeof(TextureFileHeader))
+        return fail("file too small");
+
+    header = reinterpret_cast<const TextureFileHeader *>(bytes);
+    if (std::memcmp(header->magic, TextureMagic, sizeof(header->magic)) != 0)
+        return fail("not a texture file");
+    if (header->version != TextureFileVersion)
+        return fail("unsupported version");
+    if (header->compression > (uint32_t)TextureCompression::BC1)
+        return fail("unknown compression");
+    if (getCompression() == TextureCompression::BC1 && header->channels != 3)
+        return fail("BC1 texture without 3 channels");
+    if (header->width == 0 || header->height == 0 || header->layers == 0 || header->channels == 0 ||
+        header->channels > 4 || header->levels == 0 ||
+        header->levels > (uint32_t)mipLevelCount((int)header->width, (int)header->height))
+        return fail("inconsistent dimensions");
+
+    if (header->levelTableOffset % alignof(TextureLevelInfo) != 0 ||
+        header->levelTableOffset + (uint64_t)header->levels * sizeof(TextureLevelInfo) > size)
+        return fail("truncated level table");
+    levels = reinterpret_cast<const TextureLevelInfo *>(bytes + header->levelTableOffset);
+
+    for (uint32_t i = 0; i < header->levels; i++)
+    {
+        const TextureLevelInfo &level = levels[i];
+        uint32_t width = std::max(1u, header->width >> i), height = std::max(1u, header->height >> i);
+        if (level.width != width || level.height != height ||
+            level.size != (uint64_t)textureLayerSize(getCompression(), (int)width, (int)height, (int)header->channels) *
+                              header->layers)
+            return fail("inconsistent level size");
+        if (level.offset > size || level.size > size - level.offset)
+            return fail("truncated level data");
+    }
+    return true;
+}
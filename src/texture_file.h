@@ -0,0 +1,87 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "mip_filter.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Baked texture container, little-endian:
+//
+//   TextureFileHeader    64 bytes
+//   TextureLevelInfo     one per mip level, largest first, at levelTableOffset
+//   level data           each level 64-byte aligned, every layer of the level back to back
+//
+// A level's data is exactly what glTexImage3D / glCompressedTexImage3D take for it, so the
+// runtime maps the file once and uploads each level straight from the mapping.
+
+constexpr uint32_t TextureFileVersion = 1;
+
+enum class TextureCompression : uint32_t
+{
+    None = 0, // Tightly packed 8-bit texels, channels bytes each
+    BC1 = 1   // 8-byte 4x4 blocks per layer (RGB only)
+};
+
+// Bytes of one width x height layer stored with compression
+size_t textureLayerSize(TextureCompression compression, int width, int height, int channels);
+
+struct TextureFileHeader
+{
+    char magic[4]; // "RTEX"
+    uint32_t version;
+    uint32_t width, height; // Level 0 texels
+    uint32_t layers;
+    uint32_t channels;
+    uint32_t levels;
+    uint32_t compression; // TextureCompression
+    uint32_t mipFilter;   // MipFilter the chain was built with
+    uint32_t reserved0;
+    uint64_t levelTableOffset;
+    uint8_t reserved[16];
+};
+
+struct TextureLevelInfo
+{
+    uint32_t width, height;
+    uint64_t offset;
+    uint64_t size; // Bytes of all layers together
+    uint64_t reserved;
+};
+
+static_assert(sizeof(TextureFileHeader) == 64, "texture header layout is part of the file format");
+static_assert(sizeof(TextureLevelInfo) == 32, "texture level layout is part of the file format");
+
+// Writes every level of chain (built with filter), block-compressing each layer first unless
+// compression is None (encoding runs on pool). Returns false on I/O failure or when the
+// compression cannot hold chain's channels.
+bool writeTextureFile(const char *path, const MipChain &chain, MipFilter filter,
+                      TextureCompression compression = TextureCompression::None, ThreadPool *pool = nullptr);
+
+// A baked texture mapped for reading; level data points straight into the mapping
+class TextureFile
+{
+public:
+    // Maps and validates path. Returns false (and prints why) if the file is missing, truncated
+    // or not a supported version.
+    bool open(const char *path);
+
+    int getWidth() const { return (int)header->width; }
+    int getHeight() const { return (int)header->height; }
+    int getLayers() const { return (int)header->layers; }
+    int getChannels() const { return (int)header->channels; }
+    int getLevelCount() const { return (int)header->levels; }
+    TextureCompression getCompression() const { return (TextureCompression)header->compression; }
+    MipFilter getMipFilter() const { return (MipFilter)header->mipFilter; }
+
+    const TextureLevelInfo &getLevel(int level) const { return levels[level]; }
+    const uint8_t *levelData(int level) const { return file.data() + levels[level].offset; }
+
+    // Bytes of the whole mapping
+    size_t size() const { return file.size(); }
+
+private:
+    MappedFile file;
+    const TextureFileHeader *header = nullptr;
+    const TextureLevelInfo *levels = nullptr;
+};
@@ -0,0 +1,126 @@
+#include "texture_synthesis.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // Same colours the original per-pixel generator used
+    const MaterialPattern Patterns[] = {
+        {{34, 139, 34}, {50, 50, 50}, false},  // Grass: green
+        {{100, 100, 100}, {80, 80, 80}, true}, // Rock: grey
+        {{194, 178, 128}, {40, 40, 40}, false}, // Sand: beige
+        {{139, 69, 19}, {40, 40, 40}, false},   // Earth: brown
+    };
+
+    uint64_t splitMix64(uint64_t &x)
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Generator seed of one tile: every input is folded in through splitmix64 so neighbouring
+    // tiles and seeds start from unrelated states
+    uint64_t tileSeed(uint32_t seed, TerrainMaterial material, int tileX, int tileY)
+    {
+        uint64_t state = seed;
+        uint64_t hash = splitMix64(state) ^ (uint64_t)material;
+        hash = splitMix64(hash) ^ (uint32_t)tileX;
+        hash = splitMix64(hash) ^ (uint32_t)tileY;
+        return splitMix64(hash);
+    }
+
+    uint32_t rotl(uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+}
+
+const MaterialPattern &materialPattern(TerrainMaterial material)
+{
+    return Patterns[(int)material];
+}
+
+Xoshiro128::Xoshiro128(uint64_t seed)
+{
+    uint64_t a = splitMix64(seed), b = splitMix64(seed);
+    state[0] = (uint32_t)a;
+    state[1] = (uint32_t)(a >> 32);
+    state[2] = (uint32_t)b;
+    state[3] = (uint32_t)(b >> 32);
+}
+
+uint32_t Xoshiro128::next()
+{
+    uint32_t result = rotl(state[1] * 5, 7) * 9;
+    uint32_t t = state[1] << 9;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 11);
+    return result;
+}
+
+void synthesizeMaterialTexture(TerrainMaterial material, int width, int height, uint32_t seed, uint8_t *rgb,
+                               ThreadPool *pool, int tileSize)
+{
+    const MaterialPattern &pattern = materialPattern(material);
+    tileSize = std::max(tileSize, 1);
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+
+    auto tiles = [&](int first, int last)
+    {
+        for (int tile = first; tile < last; tile++)
+        {
+            int tileX = tile % tilesX, tileY = tile / tilesX;
+            Xoshiro128 random(tileSeed(seed, material, tileX, tileY));
+
+            int x0 = tileX * tileSize, x1 = std::min(x0 + tileSize, width);
+            int y0 = tileY * tileSize, y1 = std::min(y0 + tileSize, height);
+            for (int y = y0; y < y1; y++)
+            {
+                uint8_t *texel = rgb + ((size_t)y * width + x0) * 3;
+                for (int x = x0; x < x1; x++, texel += 3)
+                {
+                    if (pattern.grey)
+                    {
+                        uint8_t grey = (uint8_t)(pattern.base[0] + random.nextBelow(pattern.range[0]));
+                        texel[0] = texel[1] = texel[2] = grey;
+                        continue;
+                    }
+                    for (int c = 0; c < 3; c++)
+                        texel[c] = (uint8_t)(pattern.base[c] + random.nextBelow(pattern.range[c]));
+                }
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, tilesX * tilesY, 1, tiles);
+    else
+        tiles(0, tilesX * tilesY);
+}
+
+void synthesizeMaterialLayers(int width, int height, uint32_t seed, uint8_t *layers, ThreadPool *pool)
+{
+    size_t layerBytes = (size_t)width * height * 3;
+    for (int material = 0; material < TerrainMaterialCount; material++)
+        synthesizeMaterialTexture((TerrainMaterial)material, width, height, seed, layers + material * layerBytes, pool);
+}
+
+size_t countLayerMismatches(TerrainMaterial material, const uint8_t *layer, int width, int height, uint32_t seed,
+                            ThreadPool *pool)
+{
+    std::vector<uint8_t> expected((size_t)width * height * 3);
+    synthesizeMaterialTexture(material, width, height, seed, expected.data(), pool);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < expected.size(); i++)
+        mismatches += layer[i] != expected[i];
+    return mismatches;
+}
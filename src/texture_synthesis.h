@@ -0,0 +1,62 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Procedural terrain material textures.
+//
+// Each texel is a base colour plus uniform per-channel noise. The texture is split into square
+// tiles and every tile draws from its own xoshiro128** generator seeded from (seed, material,
+// tile), so tiles can be filled on any thread in any order and the result depends only on the
+// seed. Unlike rand(), the output is the same on every platform.
+
+enum class TerrainMaterial
+{
+    Grass,
+    Rock,
+    Sand,
+    Earth
+};
+
+constexpr int TerrainMaterialCount = 4;
+
+// Colour of a material: base + [0, range) per channel, or one shared offset for grey materials
+struct MaterialPattern
+{
+    uint8_t base[3];
+    uint8_t range[3];
+    bool grey;
+};
+
+const MaterialPattern &materialPattern(TerrainMaterial material);
+
+// Small, fast generator (xoshiro128**) seeded through splitmix64
+class Xoshiro128
+{
+public:
+    explicit Xoshiro128(uint64_t seed);
+
+    uint32_t next();
+
+    // Uniform in [0, bound), by multiply-shift (bias below 2^-24 for the ranges used here)
+    uint32_t nextBelow(uint32_t bound) { return (uint32_t)(((uint64_t)next() * bound) >> 32); }
+
+private:
+    uint32_t state[4];
+};
+
+// Fills width x height tightly packed RGB8 texels. Tiles of tileSize x tileSize run on pool when
+// one is given; the output is identical either way.
+void synthesizeMaterialTexture(TerrainMaterial material, int width, int height, uint32_t seed, uint8_t *rgb,
+                               ThreadPool *pool = nullptr, int tileSize = 64);
+
+// Fills TerrainMaterialCount layers of width x height RGB8 texels back to back, layer i holding
+// material i, ready for one glTexImage3D into a texture array
+void synthesizeMaterialLayers(int width, int height, uint32_t seed, uint8_t *layers, ThreadPool *pool = nullptr);
+
+// Bytes of layer (a packed upload or a read-back of the array) that differ from the texture of
+// material synthesized on its own
+size_t countLayerMismatches(TerrainMaterial material, const uint8_t *layer, int width, int height, uint32_t seed,
+                            ThreadPool *pool = nullptr);
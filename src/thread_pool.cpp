@@ -0,0 +1,124 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // The calling thread always helps out, so spawn one fewer worker
+    for (unsigned int i = 1; i < threads; i++)
+        workers.emplace_back([this]
+                             { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    if (workers.empty())
+    {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &body)
+{
+    if (end <= begin)
+        return;
+
+    grain = std::max(1, grain);
+    int chunkCount = (end - begin + grain - 1) / grain;
+
+    if (chunkCount == 1 || workers.empty())
+    {
+        for (int chunk = begin; chunk < end; chunk += grain)
+            body(chunk, std::min(end, chunk + grain));
+        return;
+    }
+
+    // Shared so that helpers which only get scheduled after the loop has finished stay valid
+    struct LoopState
+    {
+        std::function<void(int, int)> body;
+        std::atomic<int> nextChunk{0};
+        std::atomic<int> doneChunks{0};
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+    };
+
+    auto state = std::make_shared<LoopState>();
+    state->body = body;
+
+    auto runChunks = [state, begin, end, grain, chunkCount]
+    {
+        int chunk;
+        while ((chunk = state->nextChunk.fetch_add(1)) < chunkCount)
+        {
+            int chunkBegin = begin + chunk * grain;
+            state->body(chunkBegin, std::min(end, chunkBegin + grain));
+
+            if (state->doneChunks.fetch_add(1) + 1 == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(state->doneMutex);
+                state->doneCondition.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min((int)workers.size(), chunkCount - 1);
+    for (int i = 0; i < helpers; i++)
+        submit(runChunks);
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->doneCondition.wait(lock, [&]
+                              { return state->doneChunks.load() == chunkCount; });
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]
+                           { return stopping || !tasks.empty(); });
+
+            if (stopping && tasks.empty())
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool used for CPU-heavy terrain and texture work
+class ThreadPool
+{
+public:
+    // threads is the total concurrency including the calling thread (0 = hardware concurrency)
+    explicit ThreadPool(unsigned int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of threads that take part in parallelFor (workers + caller)
+    unsigned int threadCount() const { return (unsigned int)workers.size() + 1; }
+
+    // Queues a task to run on a worker thread (runs inline if the pool has no workers)
+    void submit(std::function<void()> task);
+
+    // Splits [begin, end) into chunks of at most grain items and runs body(chunkBegin, chunkEnd)
+    // across the pool. The calling thread takes part and the call returns once every chunk is done.
+    void parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &body);
+
+    // Process-wide pool sized to the hardware
+    static ThreadPool &shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+};
@@ -0,0 +1,217 @@
+#include "uniform_buffers.h"
+#include "gl_utils.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const char *const sharedUniformBlocksSource = R"(
+    layout (std140) uniform FrameConstants
+    {
+        mat4 view;
+        mat4 projection;
+        vec3 viewPos;
+        vec3 lightPos;
+        vec3 lightColor;
+    };
+    layout (std140) uniform ObjectConstants
+    {
+        mat4 model;
+        vec3 objectColor;
+    };
+)";
+
+namespace
+{
+    struct BlockMember
+    {
+        const char *name;
+        size_t offset;
+    };
+
+    const BlockMember frameMembers[] = {
+        {"view", offsetof(FrameConstants, view)},
+        {"projection", offsetof(FrameConstants, projection)},
+        {"viewPos", offsetof(FrameConstants, viewPos)},
+        {"lightPos", offsetof(FrameConstants, lightPos)},
+        {"lightColor", offsetof(FrameConstants, lightColor)},
+    };
+
+    const BlockMember objectMembers[] = {
+        {"model", offsetof(ObjectConstants, model)},
+        {"objectColor", offsetof(ObjectConstants, objectColor)},
+    };
+
+    template <size_t N>
+    bool bindSharedBlock(const ShaderProgram &program, const char *name, unsigned int binding, size_t bytes,
+                         const BlockMember (&members)[N])
+    {
+        const ShaderProgram::Block *block = program.uniformBlock(name);
+        if (!block)
+            return true;
+        if ((size_t)block->dataSize > bytes)
+        {
+            std::cerr << "Uniform block " << name << " takes " << block->dataSize << " bytes, more than the "
+                      << bytes << " the renderer writes" << std::endl;
+            return false;
+        }
+
+        // std140 members are always active, so every one has an index and an offset
+        const char *names[N];
+        for (size_t i = 0; i < N; i++)
+            names[i] = members[i].name;
+        GLuint indices[N];
+        GLint offsets[N];
+        glGetUniformIndices(program.getId(), (GLsizei)N, names, indices);
+        for (size_t i = 0; i < N; i++)
+        {
+            if (indices[i] == GL_INVALID_INDEX)
+            {
+                std::cerr << "Uniform block " << name << " has no member " << names[i] << std::endl;
+                return false;
+            }
+        }
+        glGetActiveUniformsiv(program.getId(), (GLsizei)N, indices, GL_UNIFORM_OFFSET, offsets);
+        for (size_t i = 0; i < N; i++)
+        {
+            if ((size_t)offsets[i] != members[i].offset)
+            {
+                std::cerr << "Uniform block " << name << " has " << names[i] << " at byte " << offsets[i]
+                          << ", but the renderer writes it at " << members[i].offset << std::endl;
+                return false;
+            }
+        }
+        return program.bindUniformBlock(name, binding);
+    }
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+std::string addSharedUniformBlocks(const char *source)
+{
+    return addShaderPreamble(source, sharedUniformBlocksSource);
+}
+
+bool bindSharedUniformBlocks(const ShaderProgram &program)
+{
+    bool frame =
+        bindSharedBlock(program, "FrameConstants", FrameUniformBinding, sizeof(FrameConstants), frameMembers);
+    bool object =
+        bindSharedBlock(program, "ObjectConstants", ObjectUniformBinding, sizeof(ObjectConstants), objectMembers);
+    return frame && object;
+}
+
+UniformBufferRing::UniformBufferRing(size_t frameBytes, int frames)
+    : fences(std::max(1, frames), nullptr)
+{
+    GLint offsetAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    alignment = std::max<size_t>(16, offsetAlignment);
+    this->frameBytes = alignUp(frameBytes, alignment);
+
+    glGenBuffers(1, &buffer);
+    allocate();
+}
+
+void UniformBufferRing::allocate()
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, frameBytes * fences.size(), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformBufferRing::~UniformBufferRing()
+{
+    if (mapped)
+        unmap();
+    for (void *fence : fences)
+        if (fence)
+            glDeleteSync((GLsync)fence);
+    glDeleteBuffers(1, &buffer);
+}
+
+void UniformBufferRing::beginFrame()
+{
+    // The last frame didn't fit: reallocate bigger. glBufferData orphans the old storage, which
+    // the driver keeps until the frames still reading it finish, so their fences can go.
+    if (requested > frameBytes)
+    {
+        frameBytes = alignUp(std::max(requested, frameBytes * 2), alignment);
+        for (void *&fence : fences)
+        {
+            if (fence)
+                glDeleteSync((GLsync)fence);
+            fence = nullptr;
+        }
+        allocate();
+        current = -1;
+        std::cerr << "Uniform buffer ring: regions grown to " << frameBytes << " bytes" << std::endl;
+    }
+
+    current = (current + 1) % (int)fences.size();
+    used = 0;
+    requested = 0;
+
+    // With a few frames in flight the fence has almost always passed already
+    if (GLsync fence = (GLsync)fences[current])
+    {
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            stalledFrames++;
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull) == GL_TIMEOUT_EXPIRED)
+            {
+            }
+        }
+        glDeleteSync(fence);
+        fences[current] = nullptr;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    mapped = static_cast<uint8_t *>(glMapBufferRange(GL_UNIFORM_BUFFER, current * frameBytes, frameBytes,
+                                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                                         GL_MAP_UNSYNCHRONIZED_BIT));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if (!mapped)
+        std::cerr << "Failed to map the uniform buffer ring" << std::endl;
+}
+
+size_t UniformBufferRing::write(const void *data, size_t size)
+{
+    requested = alignUp(requested, alignment) + size;
+    size_t offset = alignUp(used, alignment);
+    if (!mapped || offset + size > frameBytes)
+        return SIZE_MAX;
+
+    std::memcpy(mapped + offset, data, size);
+    used = offset + size;
+    return current * frameBytes + offset;
+}
+
+void UniformBufferRing::unmap()
+{
+    if (!mapped)
+        return;
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    mapped = nullptr;
+}
+
+bool UniformBufferRing::bind(unsigned int binding, size_t offset, size_t size) const
+{
+    if (offset == SIZE_MAX)
+        return false;
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+    return true;
+}
+
+void UniformBufferRing::endFrame()
+{
+    if (current >= 0)
+        fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "shader_program.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Uniform blocks shared by every scene program: FrameConstants is written once per frame,
+// ObjectConstants once per drawn object. sharedUniformBlocksSource is their only GLSL
+// declaration; the structs below mirror its std140 layout (vec3 members take 16 bytes), and
+// bindSharedUniformBlocks checks every member's offset against them.
+
+constexpr unsigned int FrameUniformBinding = 0;
+constexpr unsigned int ObjectUniformBinding = 1;
+
+struct FrameConstants
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float padding0;
+    glm::vec3 lightPos;
+    float padding1;
+    glm::vec3 lightColor;
+    float padding2;
+};
+
+struct ObjectConstants
+{
+    glm::mat4 model;
+    glm::vec3 objectColor;
+    float padding0;
+};
+
+static_assert(sizeof(FrameConstants) == 176, "FrameConstants must match its std140 block");
+static_assert(offsetof(FrameConstants, viewPos) == 128 && offsetof(FrameConstants, lightPos) == 144 &&
+                  offsetof(FrameConstants, lightColor) == 160,
+              "FrameConstants must match its std140 block");
+static_assert(sizeof(ObjectConstants) == 80 && offsetof(ObjectConstants, objectColor) == 64,
+              "ObjectConstants must match its std140 block");
+
+extern const char *const sharedUniformBlocksSource;
+
+// Copy of a shader source with sharedUniformBlocksSource inserted after its #version line
+std::string addSharedUniformBlocks(const char *source);
+
+// Points program's FrameConstants and ObjectConstants blocks (those it uses) at their binding
+// points. Returns false (and prints why) when a block's size or member offsets differ from its
+// struct.
+bool bindSharedUniformBlocks(const ShaderProgram &program);
+
+// Per-frame uniform data in one buffer split into a region per frame in flight. Each frame maps
+// its region once, writes every block it needs (frame constants, then one per object) and
+// unmaps it before drawing; draws select their data with glBindBufferRange. A region is only
+// rewritten after the fence of the frame that last used it has passed.
+//
+// Blocks start on GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT (commonly 256 bytes), so the default 64 KB
+// region holds about 250 objects. A frame that writes more gets SIZE_MAX for the blocks that
+// didn't fit, and its draws of them must be skipped (bind returns false); the next beginFrame
+// grows every region to fit that frame.
+class UniformBufferRing
+{
+public:
+    explicit UniformBufferRing(size_t frameBytes = 64u << 10, int frames = 3);
+    ~UniformBufferRing();
+
+    UniformBufferRing(const UniformBufferRing &) = delete;
+    UniformBufferRing &operator=(const UniformBufferRing &) = delete;
+
+    // Grows the regions if the last frame overflowed, waits (rarely) for the GPU to finish with
+    // the next region, then maps it
+    void beginFrame();
+
+    // Copies size bytes into the mapped region and returns their buffer offset, or SIZE_MAX when
+    // the region is full (the region grows from the next frame on)
+    size_t write(const void *data, size_t size);
+
+    template <typename T>
+    size_t write(const T &constants)
+    {
+        return write(&constants, sizeof(T));
+    }
+
+    // Unmaps the region: after the last write, before the first draw that reads it
+    void unmap();
+
+    // Binds size bytes at offset (from write) to a uniform block binding point. Returns false,
+    // binding nothing, for a failed write: the draw would read another object's data.
+    bool bind(unsigned int binding, size_t offset, size_t size) const;
+
+    // Fences the region after the frame's last draw
+    void endFrame();
+
+    // Bytes written this frame, bytes each region holds, and frames that had to wait for the
+    // GPU to release a region
+    size_t getFrameBytes() const { return used; }
+    size_t getRegionBytes() const { return frameBytes; }
+    uint64_t getStalledFrames() const { return stalledFrames; }
+
+private:
+    void allocate();
+
+    unsigned int buffer = 0;
+    size_t frameBytes;
+    size_t alignment = 256;
+    std::vector<void *> fences;
+    int current = -1;
+    uint8_t *mapped = nullptr;
+    size_t used = 0;
+    size_t requested = 0; // Bytes this frame asked for, including writes that didn't fit
+    uint64_t stalledFrames = 0;
+};
@@ -0,0 +1,425 @@
+#include "upload_manager.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    // Pieces start on cache lines so loader threads never share one
+    constexpr size_t StagingAlignment = 64;
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Source rows per layer of a texture region, and texel rows per source row
+    int regionRows(const TextureUploadRegion &region)
+    {
+        return region.compressed ? (region.height + 3) / 4 : region.height;
+    }
+
+    int rowTexels(const TextureUploadRegion &region)
+    {
+        return region.compressed ? 4 : 1;
+    }
+}
+
+UploadFill copyUploadFill(const void *source, std::shared_ptr<const void> owner)
+{
+    return [source, owner = std::move(owner)](uint8_t *destination, size_t offset, size_t size)
+    {
+        std::memcpy(destination, static_cast<const uint8_t *>(source) + offset, size);
+    };
+}
+
+UploadManager::UploadManager(const UploadManagerSettings &settings)
+    : settings(settings), pieceLimit(std::min(settings.segmentBytes, settings.frameBudget)),
+      segments(std::max(1, settings.segments)), loaders(settings.loaderThreads + 1)
+{
+    for (Segment &segment : segments)
+    {
+        glGenBuffers(1, &segment.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, segment.buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, settings.segmentBytes, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+UploadManager::~UploadManager()
+{
+    for (Segment &segment : segments)
+    {
+        // Loaders may still be writing into the mapping
+        while (segment.fillsLeft && *segment.fillsLeft > 0)
+            std::this_thread::yield();
+
+        if (segment.mapped)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, segment.buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        if (segment.fence)
+            glDeleteSync((GLsync)segment.fence);
+        glDeleteBuffers(1, &segment.buffer);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void UploadManager::queueBuffer(unsigned int buffer, size_t offset, size_t size, UploadFill fill,
+                                std::function<void()> onComplete)
+{
+    auto request = std::make_shared<Request>();
+    request->buffer = buffer;
+    request->bufferOffset = offset;
+    request->fill = std::move(fill);
+    request->onComplete = std::move(onComplete);
+
+    std::vector<Piece> pieces;
+    for (size_t start = 0; start < size; start += pieceLimit)
+    {
+        Piece piece;
+        piece.request = request;
+        piece.sourceOffset = start;
+        piece.size = std::min(pieceLimit, size - start);
+        pieces.push_back(piece);
+    }
+    push(pieces);
+}
+
+void UploadManager::queueTexture(const TextureUploadRegion &region, UploadFill fill,
+                                 std::function<void()> onComplete)
+{
+    if (region.rowBytes > settings.segmentBytes)
+    {
+        std::cerr << "Texture rows of " << region.rowBytes << " bytes do not fit the " << settings.segmentBytes
+                  << "-byte upload staging buffers" << std::endl;
+        return;
+    }
+
+    auto request = std::make_shared<Request>();
+    request->texture = true;
+    request->region = region;
+    request->fill = std::move(fill);
+    request->onComplete = std::move(onComplete);
+
+    // Small layers go together; a layer bigger than a piece is split into row bands
+    int rows = regionRows(region);
+    size_t layerBytes = (size_t)rows * region.rowBytes;
+    size_t limit = std::max(pieceLimit, region.rowBytes);
+    std::vector<Piece> pieces;
+    if (layerBytes <= limit)
+    {
+        int layersPerPiece = (int)std::max<size_t>(1, limit / std::max<size_t>(1, layerBytes));
+        for (int layer = 0; layer < region.depth; layer += layersPerPiece)
+        {
+            Piece piece;
+            piece.request = request;
+            piece.firstLayer = layer;
+            piece.layerCount = std::min(layersPerPiece, region.depth - layer);
+            piece.rowCount = rows;
+            piece.sourceOffset = layer * layerBytes;
+            piece.size = piece.layerCount * layerBytes;
+            pieces.push_back(piece);
+        }
+    }
+    else
+    {
+        int rowsPerPiece = (int)(limit / region.rowBytes);
+        for (int layer = 0; layer < region.depth; layer++)
+            for (int row = 0; row < rows; row += rowsPerPiece)
+            {
+                Piece piece;
+                piece.request = request;
+                piece.firstLayer = layer;
+                piece.layerCount = 1;
+                piece.firstRow = row;
+                piece.rowCount = std::min(rowsPerPiece, rows - row);
+                piece.sourceOffset = layer * layerBytes + row * region.rowBytes;
+                piece.size = piece.rowCount * region.rowBytes;
+                pieces.push_back(piece);
+            }
+    }
+    push(pieces);
+}
+
+void UploadManager::push(std::vector<Piece> &pieces)
+{
+    if (pieces.empty())
+        return;
+    pieces.front().request->piecesLeft = (int)pieces.size();
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (Piece &piece : pieces)
+    {
+        queuedBytes += piece.size;
+        queue.push_back(std::move(piece));
+    }
+}
+
+void UploadManager::update()
+{
+    stats.frameBytes = 0;
+    stats.frameCopies = 0;
+    stats.budgetLimited = false;
+
+    retireSegments(false);
+    submitFilled(false);
+    stageQueued();
+    updateStats();
+}
+
+void UploadManager::flush()
+{
+    stats.frameBytes = 0;
+    stats.frameCopies = 0;
+    stats.budgetLimited = false;
+
+    while (true)
+    {
+        retireSegments(false);
+        stageQueued();
+        if (fillingOrder.empty())
+        {
+            bool queued;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queued = !queue.empty();
+            }
+            if (!queued)
+                break;
+            if (fencedOrder.empty())
+            {
+                std::cerr << "Upload flush stopped with data still queued" << std::endl;
+                break;
+            }
+
+            // Every segment is in flight: wait for the GPU to release the oldest
+            retireSegments(true);
+            continue;
+        }
+
+        const Segment &oldest = segments[fillingOrder.front()];
+        while (*oldest.fillsLeft > 0)
+            std::this_thread::yield();
+        submitFilled(true);
+    }
+    updateStats();
+}
+
+void UploadManager::retireSegments(bool wait)
+{
+    while (!fencedOrder.empty())
+    {
+        Segment &segment = segments[fencedOrder.front()];
+        GLenum result = glClientWaitSync((GLsync)segment.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                         wait ? 1000000000ull : 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            if (wait)
+                continue;
+            break;
+        }
+
+        // Fences signal in order, so only the oldest is ever waited for
+        wait = false;
+        glDeleteSync((GLsync)segment.fence);
+        segment.fence = nullptr;
+        segment.state = SegmentState::Free;
+        fencedOrder.pop_front();
+    }
+}
+
+// Issues filled segments oldest first. Segments never hold more than the budget, so the first of
+// a frame always goes and later ones go while they still fit.
+void UploadManager::submitFilled(bool ignoreBudget)
+{
+    while (!fillingOrder.empty())
+    {
+        Segment &segment = segments[fillingOrder.front()];
+        if (*segment.fillsLeft > 0)
+            break;
+
+        size_t bytes = 0;
+        for (const Piece &piece : segment.pieces)
+            bytes += piece.size;
+        if (!ignoreBudget && stats.frameBytes > 0 && stats.frameBytes + bytes > settings.frameBudget)
+        {
+            stats.budgetLimited = true;
+            break;
+        }
+
+        fillingOrder.pop_front();
+        submitSegment(segment);
+        stats.frameBytes += bytes;
+        stats.totalBytes += bytes;
+    }
+}
+
+void UploadManager::submitSegment(Segment &segment)
+{
+    glBindBuffer(GL_COPY_WRITE_BUFFER, segment.buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    segment.mapped = nullptr;
+
+    // Texture copies change bindings other code relies on, so they are put back afterwards
+    GLint unpackAlignment = 4, texture2D = 0, textureArray = 0;
+    bool textures = std::any_of(segment.pieces.begin(), segment.pieces.end(),
+                                [](const Piece &piece)
+                                { return piece.request->texture; });
+    if (textures)
+    {
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture2D);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &textureArray);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, segment.buffer);
+    }
+
+    std::vector<std::function<void()>> completed;
+    for (Piece &piece : segment.pieces)
+    {
+        Request &request = *piece.request;
+        if (!request.texture)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, segment.buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, request.buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, piece.stagingOffset,
+                                request.bufferOffset + piece.sourceOffset, piece.size);
+        }
+        else
+        {
+            const TextureUploadRegion &region = request.region;
+            int y = region.y + piece.firstRow * rowTexels(region);
+            int height = std::min(piece.rowCount * rowTexels(region), region.height - piece.firstRow * rowTexels(region));
+            const void *offset = reinterpret_cast<const void *>(piece.stagingOffset);
+
+            glBindTexture(region.target, region.texture);
+            if (region.target == GL_TEXTURE_2D_ARRAY)
+            {
+                int z = region.z + piece.firstLayer;
+                if (region.compressed)
+                    glCompressedTexSubImage3D(region.target, region.level, region.x, y, z, region.width, height,
+                                              piece.layerCount, region.format, (GLsizei)piece.size, offset);
+                else
+                    glTexSubImage3D(region.target, region.level, region.x, y, z, region.width, height,
+                                    piece.layerCount, region.format, region.type, offset);
+            }
+            else
+            {
+                if (region.compressed)
+                    glCompressedTexSubImage2D(region.target, region.level, region.x, y, region.width, height,
+                                              region.format, (GLsizei)piece.size, offset);
+                else
+                    glTexSubImage2D(region.target, region.level, region.x, y, region.width, height, region.format,
+                                    region.type, offset);
+            }
+        }
+        stats.frameCopies++;
+
+        if (--request.piecesLeft == 0 && request.onComplete)
+            completed.push_back(std::move(request.onComplete));
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (textures)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+        glBindTexture(GL_TEXTURE_2D, texture2D);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    }
+
+    // The segment is rewritten only once the GPU has finished reading it
+    segment.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    segment.state = SegmentState::Fenced;
+    segment.pieces.clear();
+    segment.used = 0;
+    fencedOrder.push_back((int)(&segment - segments.data()));
+
+    for (std::function<void()> &onComplete : completed)
+        onComplete();
+}
+
+// Maps free segments and hands their queued pieces to the loaders
+void UploadManager::stageQueued()
+{
+    for (int index = 0; index < (int)segments.size(); index++)
+    {
+        Segment &segment = segments[index];
+        if (segment.state != SegmentState::Free)
+            continue;
+
+        std::vector<Piece> pieces;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            size_t used = 0;
+            // A row too long for a piece still gets a segment of its own
+            while (!queue.empty() &&
+                   (used == 0 || alignUp(used, StagingAlignment) + queue.front().size <= pieceLimit))
+            {
+                Piece piece = std::move(queue.front());
+                queue.pop_front();
+                piece.stagingOffset = alignUp(used, StagingAlignment);
+                used = piece.stagingOffset + piece.size;
+                queuedBytes -= piece.size;
+                pieces.push_back(std::move(piece));
+            }
+            segment.used = used;
+        }
+        if (pieces.empty())
+            return;
+
+        // The fence has passed, so nothing reads the old contents
+        glBindBuffer(GL_COPY_WRITE_BUFFER, segment.buffer);
+        void *mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, settings.segmentBytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (!mapped)
+        {
+            std::cerr << "Failed to map an upload staging buffer" << std::endl;
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (auto piece = pieces.rbegin(); piece != pieces.rend(); ++piece)
+            {
+                queuedBytes += piece->size;
+                queue.push_front(std::move(*piece));
+            }
+            segment.used = 0;
+            return;
+        }
+
+        segment.mapped = static_cast<uint8_t *>(mapped);
+        segment.state = SegmentState::Filling;
+        segment.pieces = std::move(pieces);
+        segment.fillsLeft = std::make_shared<std::atomic<int>>((int)segment.pieces.size());
+        fillingOrder.push_back(index);
+
+        for (const Piece &piece : segment.pieces)
+        {
+            uint8_t *destination = segment.mapped + piece.stagingOffset;
+            loaders.submit([destination, piece, fillsLeft = segment.fillsLeft]
+                           {
+                piece.request->fill(destination, piece.sourceOffset, piece.size);
+                fillsLeft->fetch_sub(1, std::memory_order_release); });
+        }
+    }
+}
+
+void UploadManager::updateStats()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stats.queuedPieces = queue.size();
+        stats.queuedBytes = queuedBytes;
+    }
+    stats.stagedBytes = 0;
+    for (int index : fillingOrder)
+        stats.stagedBytes += segments[index].used;
+    stats.segmentsInFlight = (int)fencedOrder.size();
+}
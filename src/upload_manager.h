@@ -0,0 +1,155 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Writes bytes [offset, offset + size) of an upload's source data to destination. Runs on a
+// loader thread, straight into a mapped staging buffer.
+using UploadFill = std::function<void(uint8_t *destination, size_t offset, size_t size)>;
+
+// Fill that copies from source. The upload holds owner until it completes; without one the caller
+// keeps source alive.
+UploadFill copyUploadFill(const void *source, std::shared_ptr<const void> owner = nullptr);
+
+// Part of a texture level that staged bytes are copied into. The source is tightly packed rows,
+// layer after layer: texel rows, or rows of 4x4 blocks for compressed formats.
+struct TextureUploadRegion
+{
+    unsigned int target = 0; // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+    unsigned int texture = 0;
+    int level = 0;
+    int x = 0, y = 0, z = 0;
+    int width = 0, height = 0, depth = 1;
+    unsigned int format = 0; // Pixel format, or the internal format when compressed
+    unsigned int type = 0;   // Pixel type; unused when compressed
+    size_t rowBytes = 0;     // Bytes of one source row
+    bool compressed = false;
+};
+
+struct UploadManagerSettings
+{
+    size_t segmentBytes = 4u << 20; // Size of each staging buffer in the ring
+    int segments = 4;
+    size_t frameBudget = 4u << 20;  // Bytes of copy commands issued per frame
+    unsigned int loaderThreads = 2; // Threads filling the staging buffers
+};
+
+struct UploadStats
+{
+    size_t queuedPieces = 0;  // Queue depth: pieces waiting for staging space
+    size_t queuedBytes = 0;
+    size_t stagedBytes = 0;   // In staging buffers, being filled or waiting for the budget
+    int segmentsInFlight = 0; // Copied and waiting for the GPU to finish reading them
+    size_t frameBytes = 0;    // Copy commands issued by the last update
+    int frameCopies = 0;
+    bool budgetLimited = false; // The last update left filled data waiting for a later frame
+    size_t totalBytes = 0;
+};
+
+// Asynchronous buffer and texture uploads through a ring of staging buffers (pixel buffer
+// objects).
+//
+// Uploads can be queued from any thread. Each update stages queued pieces into a free ring
+// segment: the render thread maps it and loader threads write the source data straight into the
+// mapping. A later update unmaps the filled segment, issues its copy commands while they fit the
+// per-frame byte budget, and fences it; the segment is reused once the fence has passed. The
+// render thread never waits on a loader or on the GPU, and large uploads are split so no frame
+// copies more than the budget.
+class UploadManager
+{
+public:
+    explicit UploadManager(const UploadManagerSettings &settings = UploadManagerSettings());
+    ~UploadManager();
+
+    UploadManager(const UploadManager &) = delete;
+    UploadManager &operator=(const UploadManager &) = delete;
+
+    // Queues size bytes for buffer at offset. onComplete runs on the render thread once every
+    // copy command of the upload has been issued, so later GL commands see the data.
+    void queueBuffer(unsigned int buffer, size_t offset, size_t size, UploadFill fill,
+                     std::function<void()> onComplete = nullptr);
+
+    // Queues every row of region; the source is region.depth layers of rows, region.rowBytes each
+    void queueTexture(const TextureUploadRegion &region, UploadFill fill, std::function<void()> onComplete = nullptr);
+
+    // Once per frame on the render thread
+    void update();
+
+    // Render thread: issues everything queued so far, ignoring the budget and waiting on loaders
+    // and fences as needed (for loading screens and startup)
+    void flush();
+
+    const UploadStats &getStats() const { return stats; }
+    const UploadManagerSettings &getSettings() const { return settings; }
+
+private:
+    struct Request
+    {
+        bool texture = false;
+        unsigned int buffer = 0;
+        size_t bufferOffset = 0;
+        TextureUploadRegion region;
+        UploadFill fill;
+        std::function<void()> onComplete;
+        int piecesLeft = 0;
+    };
+
+    // A slice of a request that fits one segment: a byte range, whole layers, or rows of one layer
+    // (block rows when compressed)
+    struct Piece
+    {
+        std::shared_ptr<Request> request;
+        size_t sourceOffset = 0, size = 0;
+        int firstLayer = 0, layerCount = 0;
+        int firstRow = 0, rowCount = 0;
+        size_t stagingOffset = 0;
+    };
+
+    enum class SegmentState
+    {
+        Free,
+        Filling,
+        Fenced
+    };
+
+    struct Segment
+    {
+        unsigned int buffer = 0;
+        SegmentState state = SegmentState::Free;
+        uint8_t *mapped = nullptr;
+        size_t used = 0;
+        std::vector<Piece> pieces;
+        std::shared_ptr<std::atomic<int>> fillsLeft;
+        void *fence = nullptr;
+    };
+
+    void push(std::vector<Piece> &pieces);
+    void retireSegments(bool wait);
+    void submitFilled(bool ignoreBudget);
+    void submitSegment(Segment &segment);
+    void stageQueued();
+    void updateStats();
+
+    UploadManagerSettings settings;
+    size_t pieceLimit;
+
+    std::mutex queueMutex;
+    std::deque<Piece> queue;
+    size_t queuedBytes = 0;
+
+    std::vector<Segment> segments;
+    std::deque<int> fillingOrder; // Segments being filled, oldest first
+    std::deque<int> fencedOrder;  // Segments the GPU may still read, oldest first
+    UploadStats stats;
+
+    // Declared last so it is destroyed first, finishing every fill while the segments exist
+    ThreadPool loaders;
+};